@@ -20,6 +20,7 @@ public class BYGRichText : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"InputCore",
 				"Slate",
 				"SlateCore",
 				"UMG",
@@ -0,0 +1,151 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDevice.h"
+#include "UObject/UObjectIterator.h"
+
+#include "BYGRichTextModule.h"
+#include "Core/BYGFontMetricsCache.h"
+#include "Core/BYGRichTextLayoutCache.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGRichTextStats.h"
+#include "Widget/BYGRichTextBlock.h"
+
+// Reports for finding expensive rich text in a running build, without a profiler attached
+
+namespace BYGRichTextConsoleCommands
+{
+	static bool IsLiveWidget( const UBYGRichTextBlock* Widget )
+	{
+		return Widget && !Widget->IsTemplate() && !Widget->IsPendingKill();
+	}
+
+	static FString GetHitRate( int64 Hits, int64 Misses )
+	{
+		const int64 Total = Hits + Misses;
+		return FString::Printf( TEXT( "%.1f%% (%lld/%lld)" ), Total > 0 ? 100.0 * Hits / Total : 0.0, Hits, Total );
+	}
+
+	static void Stats( const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar )
+	{
+		int32 NumWidgets = 0;
+		int32 NumDocuments = 0;
+		int32 NumBlocks = 0;
+		int32 NumRuns[ 3 ] = { 0, 0, 0 };
+		int32 NumRebuilds = 0;
+		double RebuildSeconds = 0.0;
+		for ( TObjectIterator<UBYGRichTextBlock> It; It; ++It )
+		{
+			if ( !IsLiveWidget( *It ) )
+				continue;
+
+			++NumWidgets;
+			NumDocuments += It->GetDocumentWidget().IsValid() ? 1 : 0;
+			NumBlocks += It->GetNumBlocks();
+			for ( int32 Type = 0; Type < 3; ++Type )
+			{
+				NumRuns[ Type ] += It->GetStats()->GetNumRuns( ( EBYGRunType )Type );
+			}
+			NumRebuilds += It->GetStats()->GetNumRebuilds();
+			RebuildSeconds += It->GetStats()->GetTotalRebuildSeconds();
+		}
+
+		Ar.Logf( TEXT( "Widgets: %d (%d drawn as a single widget)" ), NumWidgets, NumDocuments );
+		Ar.Logf( TEXT( "Blocks: %d, text runs: %d, widget runs: %d, image runs: %d" ), NumBlocks, NumRuns[ ( int32 )EBYGRunType::Text ], NumRuns[ ( int32 )EBYGRunType::Widget ], NumRuns[ ( int32 )EBYGRunType::Image ] );
+		Ar.Logf( TEXT( "Rebuilds: %d, %.2fms total" ), NumRebuilds, RebuildSeconds * 1000.0 );
+
+		FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+		int32 NumBrushes = 0;
+		int32 NumTextures = 0;
+		SIZE_T TextureBytes = 0;
+		RichTextModule.GetIconCacheStats( NumBrushes, NumTextures, TextureBytes );
+		Ar.Logf( TEXT( "Icon cache: %d brushes, %d textures, %.2fKB" ), NumBrushes, NumTextures, TextureBytes / 1024.0 );
+		Ar.Logf( TEXT( "Pooled tooltip widgets: %d" ), RichTextModule.GetNumFreeTooltipWidgets() );
+
+		int64 Hits = 0;
+		int64 Misses = 0;
+		FBYGRichTextParseCache::Get().GetHitCounts( Hits, Misses );
+		Ar.Logf( TEXT( "Parse cache: %d compiled, %d shared, hit rate %s" ), FBYGRichTextParseCache::Get().Num(), FBYGRichTextParseCache::Get().NumShared(), *GetHitRate( Hits, Misses ) );
+		FBYGRichTextLayoutCache::Get().GetHitCounts( Hits, Misses );
+		Ar.Logf( TEXT( "Layout cache: %d, hit rate %s" ), FBYGRichTextLayoutCache::Get().Num(), *GetHitRate( Hits, Misses ) );
+		Ar.Logf( TEXT( "Font metrics cache: %d" ), FBYGFontMetricsCache::Get().Num() );
+	}
+
+	static void DumpWidgets( const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar )
+	{
+		const int32 TopN = Args.Num() > 0 ? FMath::Max( 1, FCString::Atoi( *Args[ 0 ] ) ) : 10;
+		const float Seconds = Args.Num() > 1 ? FMath::Max( 0.0f, FCString::Atof( *Args[ 1 ] ) ) : 10.0f;
+		const double Since = FPlatformTime::Seconds() - Seconds;
+
+		struct FEntry
+		{
+			const UBYGRichTextBlock* Widget;
+			int32 Count;
+			double Seconds;
+		};
+		TArray<FEntry> Entries;
+		for ( TObjectIterator<UBYGRichTextBlock> It; It; ++It )
+		{
+			if ( !IsLiveWidget( *It ) )
+				continue;
+
+			FEntry Entry{ *It, 0, 0.0 };
+			It->GetStats()->GetRebuildsSince( Since, Entry.Count, Entry.Seconds );
+			if ( Entry.Count > 0 )
+			{
+				Entries.Add( Entry );
+			}
+		}
+
+		Entries.Sort( []( const FEntry& A, const FEntry& B )
+		{
+			return A.Seconds != B.Seconds ? A.Seconds > B.Seconds : A.Count > B.Count;
+		} );
+
+		Ar.Logf( TEXT( "%d widgets rebuilt in the last %.1fs, top %d by rebuild time:" ), Entries.Num(), Seconds, FMath::Min( TopN, Entries.Num() ) );
+		for ( int32 i = 0; i < Entries.Num() && i < TopN; ++i )
+		{
+			const FEntry& Entry = Entries[ i ];
+			const TSharedRef<FBYGRichTextBlockStats> WidgetStats = Entry.Widget->GetStats();
+			Ar.Logf( TEXT( "  %6.2fms %4d rebuilds, %3d blocks, %4d runs (%d widget)%s  %s" ),
+				Entry.Seconds * 1000.0,
+				Entry.Count,
+				Entry.Widget->GetNumBlocks(),
+				WidgetStats->GetNumRuns( EBYGRunType::Text ) + WidgetStats->GetNumRuns( EBYGRunType::Widget ) + WidgetStats->GetNumRuns( EBYGRunType::Image ),
+				WidgetStats->GetNumRuns( EBYGRunType::Widget ),
+				Entry.Widget->GetDocumentWidget().IsValid() ? TEXT( "" ) : TEXT( ", widget per block" ),
+				*Entry.Widget->GetPathName() );
+		}
+	}
+
+	static void ClearCaches( const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar )
+	{
+		// Icons aren't cleared, runs point straight at their brushes
+		FBYGRichTextParseCache::Get().EmptyShared();
+		FBYGRichTextParseCache::Get().ResetHitCounts();
+		FBYGRichTextLayoutCache::Get().Empty();
+		FBYGRichTextLayoutCache::Get().ResetHitCounts();
+		FBYGFontMetricsCache::Get().Empty();
+
+		FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+		RichTextModule.EmptyTooltipWidgetPool();
+
+		Ar.Logf( TEXT( "Cleared shared parser output, predicted layouts, font metrics and pooled tooltips" ) );
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice StatsCommand(
+		TEXT( "BYGRichText.Stats" ),
+		TEXT( "Live rich text widgets, their blocks and runs, and cache sizes and hit rates" ),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic( &Stats ) );
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpWidgetsCommand(
+		TEXT( "BYGRichText.DumpWidgets" ),
+		TEXT( "BYGRichText.DumpWidgets [TopN=10] [Seconds=10]: widgets that spent the most time rebuilding recently" ),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic( &DumpWidgets ) );
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice ClearCachesCommand(
+		TEXT( "BYGRichText.ClearCaches" ),
+		TEXT( "Empty the runtime caches and reset their hit rates. Compiled markup is kept" ),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic( &ClearCaches ) );
+}
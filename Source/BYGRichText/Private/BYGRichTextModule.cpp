@@ -1,12 +1,26 @@
 // Copyright Brace Yourself Games. All Rights Reserved.
 
 #include "BYGRichTextModule.h"
+#include "Blueprint/UserWidget.h"
 #include "Brushes/SlateImageBrush.h"
 #include "Brushes/SlateNoResource.h"
 #include "Styling/SlateStyle.h"
 #include "Settings/BYGRichTextStylesheet.h"
 #include "Settings/BYGRichTextStyle.h"
 #include "Settings/BYGRichTextProperty.h"
+#include "Widget/BYGRichTextBlock.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGFontMetricsCache.h"
+#include "Core/BYGRichTextLayoutCache.h"
+#include "Core/BYGTextMeasure.h"
+#include "Core/BYGRichTextMemory.h"
+#include "Fonts/FontCache.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/SlateRenderer.h"
+#include "BYGRichTextRuntimeSettings.h"
+#include "Misc/Paths.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
 
 #define LOCTEXT_NAMESPACE "BYGRichTextModule"
 
@@ -17,21 +31,47 @@ void FBYGRichTextModule::StartupModule()
 	SlateStyleSet = MakeShareable( new FSlateStyleSet( TEXT( "BYGRichTextStyle" ) ) );
 
 	FCoreDelegates::OnPostEngineInit.AddRaw( this, &FBYGRichTextModule::OnPostEngineInit );
+
+	TickDelegateHandle = FTicker::GetCoreTicker().AddTicker( FTickerDelegate::CreateRaw( this, &FBYGRichTextModule::Tick ) );
+
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw( this, &FBYGRichTextModule::OnWorldCleanup );
 }
 
 
 void FBYGRichTextModule::ShutdownModule()
 {
+	FTicker::GetCoreTicker().RemoveTicker( TickDelegateHandle );
+	PendingRebuilds.Empty();
+	BoundTextWidgets.Empty();
+
+	FWorldDelegates::OnWorldCleanup.Remove( WorldCleanupHandle );
+	FreeTooltipWidgets.Empty();
+
 	InlineIconsCache.Empty();
 	IconTextures.Empty();
 
 	SlateStyleSet.Reset();
 
+	FBYGRichTextParseCache::Get().Empty();
+
+	if ( FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer() )
+	{
+		FBYGFontMetricsCache::Get().UnregisterFromFontCache( FSlateApplication::Get().GetRenderer()->GetFontCache().Get() );
+		FBYGRichTextLayoutCache::Get().UnregisterFromFontCache( FSlateApplication::Get().GetRenderer()->GetFontCache().Get() );
+	}
+	FBYGFontMetricsCache::Get().Empty();
+	FBYGRichTextLayoutCache::Get().Empty();
+	FBYGTextMeasure::Shutdown();
+
 	FallbackStylesheet = nullptr;
 }
 
+DEFINE_STAT( STAT_BYGRichTextLLM );
+
 const FSlateBrush* FBYGRichTextModule::GetIconBrush( const FString& Path, const FVector2D& MaxSize )
 {
+	BYG_RICHTEXT_LLM_SCOPE();
+
 	// Can have multiple instances of the same texture/brush, but rendered at different sizes
 	// We need to create a brush asset for every time that the brush is used for a particular size, and maintain it
 
@@ -60,6 +100,20 @@ const FSlateBrush* FBYGRichTextModule::GetIconBrush( const FString& Path, const
 	return &NullIcon;
 }
 
+void FBYGRichTextModule::GetIconCacheStats( int32& OutNumBrushes, int32& OutNumTextures, SIZE_T& OutTextureBytes ) const
+{
+	OutNumBrushes = InlineIconsCache.Num();
+	OutNumTextures = IconTextures.Num();
+	OutTextureBytes = 0;
+	for ( const UTexture2D* Texture : IconTextures )
+	{
+		if ( Texture )
+		{
+			OutTextureBytes += Texture->CalcTextureMemorySizeEnum( TMC_ResidentMips );
+		}
+	}
+}
+
 void FBYGRichTextModule::OnPostEngineInit()
 {
 	FallbackStylesheet = NewObject<UBYGRichTextStylesheet>( ( UObject* )GetTransientPackage(), FName( "FallbackStylesheet" ) );
@@ -87,11 +141,147 @@ void FBYGRichTextModule::OnPostEngineInit()
 		FallbackStylesheet->AddStyle( Style );
 		FallbackStylesheet->SetDefaultStyleName( "error" );
 	}
+
+	if ( FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer() )
+	{
+		FBYGFontMetricsCache::Get().RegisterWithFontCache( FSlateApplication::Get().GetRenderer()->GetFontCache().Get() );
+		FBYGRichTextLayoutCache::Get().RegisterWithFontCache( FSlateApplication::Get().GetRenderer()->GetFontCache().Get() );
+	}
+
+	const UBYGRichTextRuntimeSettings* Settings = GetDefault<UBYGRichTextRuntimeSettings>();
+	if ( Settings )
+	{
+		for ( const FFilePath& CompiledFile : Settings->CompiledMarkupFiles )
+		{
+			if ( !CompiledFile.FilePath.IsEmpty() )
+			{
+				FBYGRichTextParseCache::Get().LoadCompiledFile( FPaths::Combine( FPaths::ProjectDir(), CompiledFile.FilePath ) );
+			}
+		}
+	}
+}
+
+void FBYGRichTextModule::QueueContentsRebuild( UBYGRichTextBlock* Widget )
+{
+	if ( Widget )
+	{
+		PendingRebuilds.Add( Widget );
+	}
+}
+
+void FBYGRichTextModule::FlushPendingRebuilds()
+{
+	if ( PendingRebuilds.Num() == 0 )
+		return;
+
+	// Rebuilding can queue more widgets (e.g. a stylesheet edit from a rebuild), those wait for the next flush
+	TSet<TWeakObjectPtr<UBYGRichTextBlock>> ToRebuild = MoveTemp( PendingRebuilds );
+	PendingRebuilds.Reset();
+
+	for ( const TWeakObjectPtr<UBYGRichTextBlock>& Widget : ToRebuild )
+	{
+		if ( Widget.IsValid() )
+		{
+			Widget->FlushPendingRebuild();
+		}
+	}
+}
+
+void FBYGRichTextModule::RegisterTextBinding( UBYGRichTextBlock* Widget )
+{
+	if ( Widget )
+	{
+		BoundTextWidgets.Add( Widget );
+	}
+}
+
+void FBYGRichTextModule::UnregisterTextBinding( UBYGRichTextBlock* Widget )
+{
+	BoundTextWidgets.Remove( Widget );
+}
+
+void FBYGRichTextModule::PollTextBindings()
+{
+	const double Time = FPlatformTime::Seconds();
+	for ( auto It = BoundTextWidgets.CreateIterator(); It; ++It )
+	{
+		UBYGRichTextBlock* Widget = It->Get();
+		if ( !Widget )
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		Widget->PollTextBinding( Time );
+	}
+}
+
+UUserWidget* FBYGRichTextModule::AcquireTooltipWidget( UWorld* World, TSubclassOf<UUserWidget> WidgetClass )
+{
+	if ( !World || !WidgetClass )
+		return nullptr;
+
+	for ( auto* Node = FreeTooltipWidgets.GetTail(); Node; Node = Node->GetPrevNode() )
+	{
+		UUserWidget* Widget = Node->GetValue().Widget;
+		if ( Widget && Widget->GetClass() == WidgetClass && Widget->GetWorld() == World )
+		{
+			FreeTooltipWidgets.RemoveNode( Node );
+			return Widget;
+		}
+	}
+
+	return UUserWidget::CreateWidgetInstance( *World, WidgetClass, NAME_None );
+}
+
+void FBYGRichTextModule::ReleaseTooltipWidget( UUserWidget* Widget )
+{
+	if ( !Widget )
+		return;
+
+	const int32 MaxFree = GetDefault<UBYGRichTextRuntimeSettings>()->MaxPooledTooltipWidgets;
+	if ( MaxFree <= 0 )
+		return;
+
+	FPooledTooltipWidget Pooled;
+	Pooled.Widget = Widget;
+	Pooled.SlateWidget = Widget->GetCachedWidget();
+	FreeTooltipWidgets.AddTail( Pooled );
+
+	while ( FreeTooltipWidgets.Num() > MaxFree )
+	{
+		FreeTooltipWidgets.RemoveNode( FreeTooltipWidgets.GetHead() );
+	}
+}
+
+void FBYGRichTextModule::OnWorldCleanup( UWorld* World, bool bSessionEnded, bool bCleanupResources )
+{
+	for ( auto* Node = FreeTooltipWidgets.GetHead(); Node; )
+	{
+		auto* Next = Node->GetNextNode();
+		const FPooledTooltipWidget& Pooled = Node->GetValue();
+		if ( !Pooled.Widget || Pooled.Widget->GetWorld() == World )
+		{
+			FreeTooltipWidgets.RemoveNode( Node );
+		}
+		Node = Next;
+	}
+}
+
+bool FBYGRichTextModule::Tick( float DeltaTime )
+{
+	PollTextBindings();
+	FlushPendingRebuilds();
+
+	return true;
 }
 
 void FBYGRichTextModule::AddReferencedObjects( FReferenceCollector& Collector )
 {
 	Collector.AddReferencedObject( FallbackStylesheet );
+	for ( auto* Node = FreeTooltipWidgets.GetHead(); Node; Node = Node->GetNextNode() )
+	{
+		Collector.AddReferencedObject( Node->GetValue().Widget );
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,89 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_CPU_X86_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#define BYG_CHARACTER_SCAN_SSE2 1
+#else
+#define BYG_CHARACTER_SCAN_SSE2 0
+#endif
+
+// The characters a tokenizer has to stop and look at: tag and slot brackets, newlines, escapes, the first
+// character of each shortcut. Everything between them is plain text that can be copied through in one go
+// Uses SSE2 to check 8 characters at a time where it can, otherwise one at a time
+class FBYGCharacterScan
+{
+public:
+	void Add( TCHAR c )
+	{
+		if ( c == 0 || Characters.Contains( c ) )
+			return;
+
+		Characters.Add( c );
+		if ( static_cast<uint32>( c ) < 128 )
+		{
+			AsciiMask[ c >> 5 ] |= 1u << ( c & 31 );
+		}
+#if BYG_CHARACTER_SCAN_SSE2
+		if ( Characters.Num() <= MaxVectorCharacters )
+		{
+			VectorCharacters[ Characters.Num() - 1 ] = _mm_set1_epi16( static_cast<int16>( c ) );
+		}
+#endif
+	}
+
+	bool IsSpecial( TCHAR c ) const
+	{
+		if ( static_cast<uint32>( c ) < 128 )
+		{
+			return ( AsciiMask[ c >> 5 ] >> ( c & 31 ) ) & 1;
+		}
+		return Characters.Contains( c );
+	}
+
+	// Index of the first special character in [Start, End), or End if there isn't one
+	int32 FindNext( const TCHAR* Text, int32 Start, int32 End ) const
+	{
+		int32 i = Start;
+#if BYG_CHARACTER_SCAN_SSE2
+		if ( sizeof( TCHAR ) == sizeof( int16 ) && Characters.Num() <= MaxVectorCharacters )
+		{
+			const int32 NumVectorCharacters = Characters.Num();
+			for ( ; i + 8 <= End; i += 8 )
+			{
+				const __m128i Chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( Text + i ) );
+				__m128i Matches = _mm_setzero_si128();
+				for ( int32 n = 0; n < NumVectorCharacters; ++n )
+				{
+					Matches = _mm_or_si128( Matches, _mm_cmpeq_epi16( Chunk, VectorCharacters[ n ] ) );
+				}
+				// Two bits per character
+				const uint32 Mask = static_cast<uint32>( _mm_movemask_epi8( Matches ) );
+				if ( Mask != 0 )
+				{
+					return i + static_cast<int32>( FMath::CountTrailingZeros( Mask ) / 2 );
+				}
+			}
+		}
+#endif
+		for ( ; i < End; ++i )
+		{
+			if ( IsSpecial( Text[ i ] ) )
+				return i;
+		}
+		return End;
+	}
+
+protected:
+	// Past this many, a compare per character costs more than checking one at a time
+	static const int32 MaxVectorCharacters = 16;
+
+	TArray<TCHAR, TInlineAllocator<MaxVectorCharacters>> Characters;
+	uint32 AsciiMask[ 4 ] = { 0, 0, 0, 0 };
+#if BYG_CHARACTER_SCAN_SSE2
+	__m128i VectorCharacters[ MaxVectorCharacters ];
+#endif
+};
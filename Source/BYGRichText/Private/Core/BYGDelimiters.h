@@ -0,0 +1,80 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BYGRichTextRuntimeSettings.h"
+
+// What the tokenizers in FBYGRichTextMarkupParser are specialized on. Almost every project keeps the default
+// delimiters, so those are compile-time constants and comparisons against them fold away
+// Anything else set in UBYGRichTextRuntimeSettings goes through FBYGConfigDelimiters, read once per parse
+// Slots are off by default, 0 never matches anything inside the input
+struct FBYGDefaultDelimiters
+{
+	static constexpr TCHAR TagOpen = TEXT( '[' );
+	static constexpr TCHAR TagClose = TEXT( ']' );
+	static constexpr TCHAR SlotOpen = 0;
+	static constexpr TCHAR SlotClose = 0;
+	static constexpr TCHAR ParagraphSeparatorStart = TEXT( '\r' );
+	static constexpr int32 ParagraphSeparatorLen = 4;
+
+	// Same as MatchForward, the separator has to have more input after it
+	static bool MatchParagraphSeparator( const TCHAR* Text, int32 Index )
+	{
+		return Text[ Index ] == TEXT( '\r' ) && Text[ Index + 1 ] == TEXT( '\n' ) && Text[ Index + 2 ] == TEXT( '\r' ) && Text[ Index + 3 ] == TEXT( '\n' ) && Text[ Index + 4 ] != 0;
+	}
+
+	static bool Matches( const UBYGRichTextRuntimeSettings* Settings )
+	{
+		return !Settings
+			|| ( Settings->TagOpenCharacter == TEXT( "[" )
+				&& Settings->TagCloseCharacter == TEXT( "]" )
+				&& ( Settings->SlotOpenCharacter.IsEmpty() || Settings->SlotCloseCharacter.IsEmpty() )
+				&& Settings->ParagraphSeparator == TEXT( "\r\n\r\n" ) );
+	}
+};
+
+struct FBYGConfigDelimiters
+{
+	explicit FBYGConfigDelimiters( const UBYGRichTextRuntimeSettings* Settings )
+		: TagOpen( GetFirstCharacter( Settings->TagOpenCharacter ) )
+		, TagClose( GetFirstCharacter( Settings->TagCloseCharacter ) )
+		, ParagraphSeparator( Settings->ParagraphSeparator )
+		, ParagraphSeparatorStart( GetFirstCharacter( Settings->ParagraphSeparator ) )
+		, ParagraphSeparatorLen( Settings->ParagraphSeparator.Len() )
+	{
+		// Slots need both, otherwise they're disabled. Nothing matches 0 inside the input
+		if ( !Settings->SlotOpenCharacter.IsEmpty() && !Settings->SlotCloseCharacter.IsEmpty() )
+		{
+			SlotOpen = Settings->SlotOpenCharacter[ 0 ];
+			SlotClose = Settings->SlotCloseCharacter[ 0 ];
+		}
+	}
+
+	bool MatchParagraphSeparator( const TCHAR* Text, int32 Index ) const
+	{
+		if ( ParagraphSeparatorLen == 0 )
+			return false;
+		for ( int32 i = 0; i < ParagraphSeparatorLen; ++i )
+		{
+			if ( Text[ Index + i ] != ParagraphSeparator[ i ] )
+				return false;
+		}
+		return Text[ Index + ParagraphSeparatorLen ] != 0;
+	}
+
+	TCHAR TagOpen = 0;
+	TCHAR TagClose = 0;
+	TCHAR SlotOpen = 0;
+	TCHAR SlotClose = 0;
+	FString ParagraphSeparator;
+	TCHAR ParagraphSeparatorStart = 0;
+	int32 ParagraphSeparatorLen = 0;
+
+protected:
+	static TCHAR GetFirstCharacter( const FString& Str )
+	{
+		return Str.Len() > 0 ? Str[ 0 ] : 0;
+	}
+};
@@ -0,0 +1,73 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGFontMetricsCache.h"
+
+#include "Core/BYGTextMeasure.h"
+#include "Fonts/FontCache.h"
+#include "Misc/ScopeLock.h"
+
+FBYGFontMetricsCache& FBYGFontMetricsCache::Get()
+{
+	static FBYGFontMetricsCache Instance;
+	return Instance;
+}
+
+FBYGFontMetrics FBYGFontMetricsCache::GetMetrics( const FSlateFontInfo& Font, float Scale )
+{
+	const FKey Key{ Font, Scale };
+	{
+		FScopeLock Lock( &MetricsLock );
+		if ( const FBYGFontMetrics* Found = Metrics.Find( Key ) )
+		{
+			return *Found;
+		}
+	}
+
+	const FBYGFontMetrics Measured = MeasureMetrics( Font, Scale );
+
+	FScopeLock Lock( &MetricsLock );
+	Metrics.Add( Key, Measured );
+	return Measured;
+}
+
+FBYGFontMetrics FBYGFontMetricsCache::MeasureMetrics( const FSlateFontInfo& Font, float Scale ) const
+{
+	// Works without a renderer, so runs can be created in commandlets and headless tests
+	const TSharedRef<IBYGTextMeasure> FontMeasure = FBYGTextMeasure::Get();
+	FBYGFontMetrics Result;
+	Result.Baseline = FontMeasure->GetBaseline( Font, Scale );
+	Result.MaxHeight = FontMeasure->GetMaxCharacterHeight( Font, Scale );
+	return Result;
+}
+
+void FBYGFontMetricsCache::Empty()
+{
+	FScopeLock Lock( &MetricsLock );
+	Metrics.Empty();
+}
+
+int32 FBYGFontMetricsCache::Num() const
+{
+	FScopeLock Lock( &MetricsLock );
+	return Metrics.Num();
+}
+
+void FBYGFontMetricsCache::RegisterWithFontCache( FSlateFontCache& FontCache )
+{
+	UnregisterFromFontCache( FontCache );
+	ReleaseResourcesHandle = FontCache.OnReleaseResources().AddRaw( this, &FBYGFontMetricsCache::OnFontCacheReleased );
+}
+
+void FBYGFontMetricsCache::UnregisterFromFontCache( FSlateFontCache& FontCache )
+{
+	if ( ReleaseResourcesHandle.IsValid() )
+	{
+		FontCache.OnReleaseResources().Remove( ReleaseResourcesHandle );
+		ReleaseResourcesHandle.Reset();
+	}
+}
+
+void FBYGFontMetricsCache::OnFontCacheReleased( const FSlateFontCache& FontCache )
+{
+	Empty();
+}
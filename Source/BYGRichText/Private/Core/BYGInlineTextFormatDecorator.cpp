@@ -4,23 +4,71 @@
 #include "Styling/SlateStyle.h"
 #include "Styling/SlateTypes.h"
 #include "Framework/Text/SlateTextRun.h"
+#include "Core/BYGTextRun.h"
+#include "Core/BYGFontMetricsCache.h"
+#include "Core/BYGRichTextMemory.h"
 #include "Widget/BYGRichTextBlock.h"
 #include "BYGStyleStack.h"
 #include <Framework/Text/SlateImageRun.h>
 #include <Fonts/FontMeasure.h>
 
-TSharedRef< FBYGInlineTextFormatDecorator > FBYGInlineTextFormatDecorator::Create( FString InRunName, const UBYGRichTextBlock* InOwner )
+TSharedRef< FBYGInlineTextFormatDecorator > FBYGInlineTextFormatDecorator::Create( FString InRunName, const UBYGRichTextBlock* InOwner, int32 InBlockIndex )
 {
-	return MakeShareable( new FBYGInlineTextFormatDecorator( InRunName, InOwner ) );
+	return MakeShareable( new FBYGInlineTextFormatDecorator( InRunName, InOwner, InBlockIndex ) );
 }
 
-FBYGInlineTextFormatDecorator::FBYGInlineTextFormatDecorator( FString InRunName, const UBYGRichTextBlock* InOwner )
+FBYGInlineTextFormatDecorator::FBYGInlineTextFormatDecorator( FString InRunName, const UBYGRichTextBlock* InOwner, int32 InBlockIndex )
 	: RunName( InRunName )
 	, RichTextBlockOwner( InOwner )
+	, BlockIndex( InBlockIndex )
 {
 
 }
 
+int32 FBYGInlineTextFormatDecorator::TrackRunOffset( const FTextRunParseResults& RunParseResult, const TSharedRef< FString >& InOutModelText )
+{
+	// The marshaller adds all lines at once, so we can't ask the layout for previous lines.
+	// Runs always come in increasing order of the original text, so going backwards means a new layout pass
+	if ( RunParseResult.OriginalRange.BeginIndex <= LastOriginalBeginIndex )
+	{
+		CurrentLineModelText = nullptr;
+		CurrentLineLength = 0;
+		CompletedLinesLength = 0;
+		if ( BlockIndex != INDEX_NONE )
+		{
+			RichTextBlockOwner->GetRevealState()->ClearBlock( BlockIndex );
+			RichTextBlockOwner->GetStats()->ClearBlock( BlockIndex );
+		}
+	}
+	LastOriginalBeginIndex = RunParseResult.OriginalRange.BeginIndex;
+
+	// Each line gets its own model string
+	if ( &InOutModelText.Get() != CurrentLineModelText )
+	{
+		CompletedLinesLength += CurrentLineLength;
+		CurrentLineModelText = &InOutModelText.Get();
+		CurrentLineLength = 0;
+	}
+
+	return CompletedLinesLength;
+}
+
+FTextRange FBYGInlineTextFormatDecorator::AppendToModel( const TSharedRef< FString >& InOutModelText, const FString& Content )
+{
+	FTextRange ModelRange;
+	ModelRange.BeginIndex = InOutModelText->Len();
+	*InOutModelText += Content;
+	ModelRange.EndIndex = InOutModelText->Len();
+
+	CurrentLineLength = ModelRange.EndIndex;
+	if ( BlockIndex != INDEX_NONE )
+	{
+		RichTextBlockOwner->GetRevealState()->ExtendBlock( BlockIndex, CompletedLinesLength + CurrentLineLength );
+	}
+
+	return ModelRange;
+}
+
 bool FBYGInlineTextFormatDecorator::Supports( const FTextRunParseResults& RunParseResult, const FString& Text ) const
 {
 	return ( RunParseResult.Name == RunName );
@@ -28,44 +76,57 @@ bool FBYGInlineTextFormatDecorator::Supports( const FTextRunParseResults& RunPar
 
 TSharedRef<ISlateRun> FBYGInlineTextFormatDecorator::Create( const TSharedRef<class FTextLayout>& TextLayout, const FTextRunParseResults& RunParseResult, const FString& OriginalText, const TSharedRef< FString >& InOutModelText, const ISlateStyle* Style )
 {
+	BYG_RICHTEXT_LLM_SCOPE();
+
 	FRunInfo RunInfo( RunParseResult.Name );
 	for ( const TPair<FString, FTextRange>& Pair : RunParseResult.MetaData )
 	{
 		RunInfo.MetaData.Add( Pair.Key, OriginalText.Mid( Pair.Value.BeginIndex, Pair.Value.EndIndex - Pair.Value.BeginIndex ) );
 	}
 
-	// Resolve IDs
-	// Detect if any of the properties for this require us to create an inline widget
-	bool bAnyWidgetRequiresBlockWrap = false;
-	TArray<const UBYGRichTextPropertyBase*> Props;
+	// Resolve IDs, the stylesheet keeps the combined text style for every combination it has seen
 	const FString* const IDsString = RunInfo.MetaData.Find( TEXT( "ids" ) );
-	if ( ensure( IDsString ) )
+	ensure( IDsString );
+	const TSharedRef<const FBYGResolvedRunStyle> RunStyle = RichTextBlockOwner->GetRichTextStylesheet()->ResolveRunStyle( IDsString ? *IDsString : FString() );
+	const TArray<const UBYGRichTextPropertyBase*>& Props = RunStyle->Properties;
+	// Detect if any of the properties for this require us to create an inline widget
+	const bool bAnyWidgetRequiresBlockWrap = RunStyle->bRequiresInlineTextBlock;
+
+	FTextBlockStyle TextBlockStyle = RunStyle->TextStyle;
+	TArray<FBYGRunBrushInfo> RunBrushes;
+	bool bSizeToBrush = false;
+	for ( const UBYGRichTextPropertyBase* Prop : Props )
 	{
-		TArray<FString> IDs;
-		IDsString->ParseIntoArray( IDs, TEXT( " " ) );
-		const UBYGRichTextStylesheet* Stylesheet = RichTextBlockOwner->GetRichTextStylesheet();
-		for ( const FString& ID : IDs )
+		if ( Prop )
 		{
-			const int32 InlineID = FCString::Atoi( *ID );
-			const UBYGRichTextPropertyBase* Prop = Stylesheet->FindProperty( InlineID );
-			if ( ensure( Prop ) )
+			FBYGRunBrushInfo BrushInfo;
+			if ( Prop->GetRunBrush( RunInfo.MetaData, BrushInfo ) )
 			{
-				bAnyWidgetRequiresBlockWrap = bAnyWidgetRequiresBlockWrap || Prop->RequiresInlineTextBlock();
-				Props.Add( Prop );
-			}
-			else
-			{
-				UE_LOG( LogTemp, Error, TEXT( "Failed to find property with inline ID %d / %s" ), InlineID, *ID );
+				bSizeToBrush = bSizeToBrush || BrushInfo.bSizeToBrush;
+				RunBrushes.Add( BrushInfo );
 			}
 		}
 	}
 
-	FTextBlockStyle TextBlockStyle;
-	for ( const UBYGRichTextPropertyBase* Prop : Props )
+	FBYGRunRevealInfo RevealInfo;
+	if ( BlockIndex != INDEX_NONE )
 	{
-		if ( Prop )
+		RevealInfo.RevealState = RichTextBlockOwner->GetRevealState();
+		RevealInfo.BlockIndex = BlockIndex;
+		RevealInfo.LocalOffset = TrackRunOffset( RunParseResult, InOutModelText ) + InOutModelText->Len();
+	}
+
+	// Slots show the owner's current value, transformed the same way the parser would have
+	FString Content = OriginalText.Mid( RunParseResult.ContentRange.BeginIndex, RunParseResult.ContentRange.EndIndex - RunParseResult.ContentRange.BeginIndex );
+	if ( const FString* SlotName = RunInfo.MetaData.Find( TEXT( "slot" ) ) )
+	{
+		if ( const FText* SlotValue = RichTextBlockOwner->FindSlotValue( FName( **SlotName ) ) )
 		{
-			Prop->ApplyToTextStyle( TextBlockStyle );
+			Content = SlotValue->ToString();
+			for ( const UBYGRichTextPropertyBase* Prop : Props )
+			{
+				Prop->TransformString( Content );
+			}
 		}
 	}
 
@@ -73,7 +134,7 @@ TSharedRef<ISlateRun> FBYGInlineTextFormatDecorator::Create( const TSharedRef<cl
 	{
 		TSharedPtr<SRichTextBlock> TextBlock = 
 			SNew( SRichTextBlock )
-			.Text( FText::FromString( OriginalText.Mid( RunParseResult.ContentRange.BeginIndex, RunParseResult.ContentRange.EndIndex - RunParseResult.ContentRange.BeginIndex ) ) )
+			.Text( FText::FromString( Content ) )
 			.TextStyle( &TextBlockStyle );
 
 		TSharedRef<SWidget> TextBlockRef = TextBlock.ToSharedRef();
@@ -81,7 +142,6 @@ TSharedRef<ISlateRun> FBYGInlineTextFormatDecorator::Create( const TSharedRef<cl
 		{
 			if ( Prop->RequiresInlineTextBlock() )
 			{
-				UE_LOG( LogTemp, Warning, TEXT( "Wrapping once with '%s'" ), *Prop->GetName() );
 				TextBlockRef = Prop->WrapBlock( TextBlockRef, nullptr, RunInfo.MetaData );
 			}
 		}
@@ -89,28 +149,66 @@ TSharedRef<ISlateRun> FBYGInlineTextFormatDecorator::Create( const TSharedRef<cl
 		//*InOutModelText += TEXT( '\u200B' ); // Zero-Width Breaking Space
 		//ModelRange.EndIndex = InOutModelText->Len();
 
-		// Calculate the baseline of the text within the owning rich text
-		const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
-		const int16 WidgetBaseline = FontMeasure->GetBaseline( TextBlockStyle.Font ) - FMath::Min( 0.0f, TextBlockStyle.ShadowOffset.Y ); // + RichTextSettings->DefaultReplacementBaselineOffset;
+		// Calculate the baseline of the text within the owning rich text, unscaled as FSlateWidgetRun scales it by the layout
+		const int16 WidgetBaseline = FBYGFontMetricsCache::Get().GetBaseline( TextBlockStyle.Font, 1.0f ) - FMath::Min( 0.0f, TextBlockStyle.ShadowOffset.Y ); // + RichTextSettings->DefaultReplacementBaselineOffset;
 
-		FTextRange ModelRange;
-		ModelRange.BeginIndex = InOutModelText->Len();
-		*InOutModelText += TEXT( '\u00A0' ); // Zero-Width Breaking Space
-		ModelRange.EndIndex = InOutModelText->Len();
+		const FTextRange ModelRange = AppendToModel( InOutModelText, TEXT( "\u00A0" ) ); // Zero-Width Breaking Space
+		RichTextBlockOwner->GetStats()->AddRun( BlockIndex, EBYGRunType::Widget );
 
 		//return FSlateWidgetRun::Create( TextLayout, RunInfo, InOutModelText, CreateWidgetDelegate.Execute( RunInfo, Style ), ModelRange );
 
-		return FSlateWidgetRun::Create( TextLayout, RunInfo, InOutModelText, FSlateWidgetRun::FWidgetRunInfo( TextBlockRef, WidgetBaseline ), ModelRange );
+		return FBYGWidgetRun::Create( TextLayout, RunInfo, InOutModelText, FSlateWidgetRun::FWidgetRunInfo( TextBlockRef, WidgetBaseline ), ModelRange, RevealInfo );
 	}
 	else
 	{
-		FTextRange ModelRange;
-		ModelRange.BeginIndex = InOutModelText->Len();
-		*InOutModelText += OriginalText.Mid( RunParseResult.ContentRange.BeginIndex, RunParseResult.ContentRange.EndIndex - RunParseResult.ContentRange.BeginIndex );
-		ModelRange.EndIndex = InOutModelText->Len();
+		// Icons with no text still need a character to give the run somewhere to be laid out
+		if ( Content.IsEmpty() && bSizeToBrush )
+		{
+			Content = TEXT( "\u00A0" );
+
+			// A lone icon with nothing around it is just an image, no need for text shaping or brush alignment
+			if ( RunBrushes.Num() == 1 && RunBrushes[ 0 ].Padding.GetDesiredSize().IsZero() )
+			{
+				// Unscaled, same as the widget run baseline above
+				const int16 Baseline = FBYGFontMetricsCache::Get().GetBaseline( TextBlockStyle.Font, 1.0f ) - FMath::Min( 0.0f, TextBlockStyle.ShadowOffset.Y );
+
+				const FTextRange ModelRange = AppendToModel( InOutModelText, Content );
+				RichTextBlockOwner->GetStats()->AddRun( BlockIndex, EBYGRunType::Image );
+
+				return FBYGImageRun::Create( RunInfo, InOutModelText, RunBrushes[ 0 ].Brush, Baseline, ModelRange, RevealInfo );
+			}
+		}
+
+		// Only the document widget can find runs under the mouse, otherwise there's nothing to add them to
+		TSharedPtr<FBYGRunInteraction> Interaction;
+		TSharedPtr<FBYGRunHitTestIndex> HitTestIndex = RichTextBlockOwner->GetHitTestIndex();
+		if ( HitTestIndex.IsValid() )
+		{
+			for ( const UBYGRichTextPropertyBase* Prop : Props )
+			{
+				if ( !Prop->IsRunInteractive() )
+					continue;
+
+				if ( !Interaction.IsValid() )
+				{
+					Interaction = MakeShared<FBYGRunInteraction>();
+					Interaction->Data.Content = Content;
+					Interaction->Data.Pairs = RunInfo.MetaData;
+					Interaction->BlockIndex = BlockIndex;
+				}
+				Interaction->Properties.Add( Prop );
+				Interaction->bClickable = Interaction->bClickable || Prop->IsRunClickable();
+				if ( Prop->GetRunCursor() != EMouseCursor::Default )
+				{
+					Interaction->Cursor = Prop->GetRunCursor();
+				}
+			}
+		}
 
+		const FTextRange ModelRange = AppendToModel( InOutModelText, Content );
+		RichTextBlockOwner->GetStats()->AddRun( BlockIndex, EBYGRunType::Text );
 
-		return FSlateTextRun::Create( RunInfo, InOutModelText, TextBlockStyle, ModelRange );
+		return FBYGTextRun::Create( RunInfo, InOutModelText, TextBlockStyle, ModelRange, RevealInfo, RunBrushes, Interaction, Interaction.IsValid() ? HitTestIndex : nullptr );
 
 	}
 }
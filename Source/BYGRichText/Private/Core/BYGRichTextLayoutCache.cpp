@@ -0,0 +1,105 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGRichTextLayoutCache.h"
+
+#include "BYGRichTextRuntimeSettings.h"
+#include "Fonts/FontCache.h"
+#include "Misc/ScopeLock.h"
+
+uint32 FBYGRichTextLayoutKey::GetSlotValuesHash( const TMap<FName, FText>* SlotValues )
+{
+	uint32 Hash = 0;
+	if ( SlotValues )
+	{
+		for ( const TPair<FName, FText>& Pair : *SlotValues )
+		{
+			Hash ^= HashCombine( GetTypeHash( Pair.Key ), FCrc::StrCrc32( *Pair.Value.ToString() ) );
+		}
+	}
+	return Hash;
+}
+
+FBYGRichTextLayoutCache& FBYGRichTextLayoutCache::Get()
+{
+	static FBYGRichTextLayoutCache Instance;
+	return Instance;
+}
+
+bool FBYGRichTextLayoutCache::Find( const FBYGRichTextLayoutKey& Key, FBYGPredictedLayout& OutLayout ) const
+{
+	FScopeLock Lock( &LayoutsLock );
+	if ( const FBYGPredictedLayout* Found = Layouts.Find( Key ) )
+	{
+		OutLayout = *Found;
+		++NumHits;
+		return true;
+	}
+	++NumMisses;
+	return false;
+}
+
+void FBYGRichTextLayoutCache::GetHitCounts( int64& OutHits, int64& OutMisses ) const
+{
+	FScopeLock Lock( &LayoutsLock );
+	OutHits = NumHits;
+	OutMisses = NumMisses;
+}
+
+void FBYGRichTextLayoutCache::ResetHitCounts()
+{
+	FScopeLock Lock( &LayoutsLock );
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+void FBYGRichTextLayoutCache::Add( const FBYGRichTextLayoutKey& Key, const FBYGPredictedLayout& Layout )
+{
+	const int32 MaxLayouts = GetDefault<UBYGRichTextRuntimeSettings>()->MaxCachedLayouts;
+	if ( MaxLayouts <= 0 )
+		return;
+
+	FScopeLock Lock( &LayoutsLock );
+	if ( Layouts.Contains( Key ) )
+		return;
+	Layouts.Add( Key, Layout );
+	LayoutOrder.Add( Key );
+
+	while ( LayoutOrder.Num() > MaxLayouts )
+	{
+		Layouts.Remove( LayoutOrder.First() );
+		LayoutOrder.PopFirst();
+	}
+}
+
+void FBYGRichTextLayoutCache::Empty()
+{
+	FScopeLock Lock( &LayoutsLock );
+	Layouts.Empty();
+	LayoutOrder.Empty();
+}
+
+int32 FBYGRichTextLayoutCache::Num() const
+{
+	FScopeLock Lock( &LayoutsLock );
+	return Layouts.Num();
+}
+
+void FBYGRichTextLayoutCache::RegisterWithFontCache( FSlateFontCache& FontCache )
+{
+	UnregisterFromFontCache( FontCache );
+	ReleaseResourcesHandle = FontCache.OnReleaseResources().AddRaw( this, &FBYGRichTextLayoutCache::OnFontCacheReleased );
+}
+
+void FBYGRichTextLayoutCache::UnregisterFromFontCache( FSlateFontCache& FontCache )
+{
+	if ( ReleaseResourcesHandle.IsValid() )
+	{
+		FontCache.OnReleaseResources().Remove( ReleaseResourcesHandle );
+		ReleaseResourcesHandle.Reset();
+	}
+}
+
+void FBYGRichTextLayoutCache::OnFontCacheReleased( const FSlateFontCache& FontCache )
+{
+	Empty();
+}
@@ -0,0 +1,385 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGRichTextLayoutPredictor.h"
+
+#include "Core/BYGFontMetricsCache.h"
+#include "Core/BYGRichTextLayoutCache.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGTextMeasure.h"
+#include "Settings/BYGRichTextProperty.h"
+#include "Settings/BYGRichTextStyle.h"
+#include "Settings/BYGRichTextStylesheet.h"
+#include "Styling/SlateTypes.h"
+
+namespace
+{
+	// One run of a line, everything in layout units
+	struct FPredictedRun
+	{
+		FString Text;
+		FSlateFontInfo Font;
+		float MinWidth = 0.0f;
+		float AboveBaseline = 0.0f;
+		float BelowBaseline = 0.0f;
+		// Inline widgets and icons are laid out as a single non-breaking character
+		bool bAtomic = false;
+	};
+
+	struct FPredictedWord
+	{
+		struct FFragment
+		{
+			int32 RunIndex;
+			int32 BeginIndex;
+			int32 EndIndex;
+		};
+		TArray<FFragment> Fragments;
+		float Width = 0.0f;
+		float TrailingWidth = 0.0f;
+		float AboveBaseline = 0.0f;
+		float BelowBaseline = 0.0f;
+
+		bool IsEmpty() const { return Fragments.Num() == 0 && TrailingWidth == 0.0f; }
+
+		void AddMetrics( const FPredictedRun& Run )
+		{
+			AboveBaseline = FMath::Max( AboveBaseline, Run.AboveBaseline );
+			BelowBaseline = FMath::Max( BelowBaseline, Run.BelowBaseline );
+		}
+	};
+
+	struct FPredictedLine
+	{
+		float Width = 0.0f;
+		// Whitespace at the end of the line so far, only counted if something comes after it
+		float PendingTrailing = 0.0f;
+		float AboveBaseline = 0.0f;
+		float BelowBaseline = 0.0f;
+		bool bHasContent = false;
+	};
+
+	// Same metrics as FBYGTextRun::GetMaxHeight and GetBaseLine
+	void SetRunMetrics( FPredictedRun& Run, const FTextBlockStyle& Style, const FVector2D& MinSize, float Scale )
+	{
+		const FBYGFontMetrics Metrics = FBYGFontMetricsCache::Get().GetMetrics( Style.Font, Scale );
+		const float TextHeight = Metrics.MaxHeight + FMath::Abs( Style.ShadowOffset.Y * Scale );
+		const float Height = FMath::Max( TextHeight, FMath::CeilToFloat( MinSize.Y * Scale ) );
+		const float Baseline = Metrics.Baseline - FMath::Min( 0.0f, Style.ShadowOffset.Y * Scale ) - FMath::FloorToFloat( ( Height - TextHeight ) / 2 );
+
+		// Baseline is negative, measured up from the bottom
+		Run.AboveBaseline = Height + Baseline;
+		Run.BelowBaseline = -Baseline;
+		Run.MinWidth = MinSize.X * Scale;
+		Run.Font = Style.Font;
+	}
+
+	FTextBlockStyle GetDefaultTextStyle( const UBYGRichTextStylesheet* Stylesheet )
+	{
+		FTextBlockStyle Style;
+		for ( const UBYGRichTextPropertyBase* Prop : Stylesheet->GetDefaultProperties() )
+		{
+			Prop->ApplyToTextStyle( Style );
+		}
+		if ( const UBYGRichTextStyle* DefaultStyle = Stylesheet->FindStyle( Stylesheet->GetDefaultStyleName() ) )
+		{
+			for ( const UBYGRichTextPropertyBase* Prop : DefaultStyle->Properties )
+			{
+				if ( Prop )
+				{
+					Prop->ApplyToTextStyle( Style );
+				}
+			}
+		}
+		return Style;
+	}
+
+	// Mirrors what FBYGInlineTextFormatDecorator::Create does with a run, without creating it
+	FPredictedRun CreateRun( const FTextRunParseResults& RunResult, const FString& Output, const UBYGRichTextStylesheet* Stylesheet, float Scale, const TMap<FName, FText>* SlotValues )
+	{
+		TMap<FString, FString> MetaData;
+		for ( const TPair<FString, FTextRange>& Pair : RunResult.MetaData )
+		{
+			MetaData.Add( Pair.Key, Output.Mid( Pair.Value.BeginIndex, Pair.Value.Len() ) );
+		}
+
+		const FString* IDsString = MetaData.Find( TEXT( "ids" ) );
+		const TSharedRef<const FBYGResolvedRunStyle> RunStyle = Stylesheet->ResolveRunStyle( IDsString ? *IDsString : FString() );
+		const TArray<const UBYGRichTextPropertyBase*>& Props = RunStyle->Properties;
+
+		FPredictedRun Run;
+		const FTextBlockStyle& TextBlockStyle = RunStyle->TextStyle;
+		FVector2D MinSize = FVector2D::ZeroVector;
+		for ( const UBYGRichTextPropertyBase* Prop : Props )
+		{
+			MinSize = FVector2D::Max( MinSize, Prop->GetRunMinSize( MetaData ) );
+		}
+		Run.bAtomic = RunStyle->bRequiresInlineTextBlock;
+
+		Run.Text = Output.Mid( RunResult.ContentRange.BeginIndex, RunResult.ContentRange.Len() );
+		if ( const FString* SlotName = MetaData.Find( TEXT( "slot" ) ) )
+		{
+			const FText* SlotValue = SlotValues ? SlotValues->Find( FName( **SlotName ) ) : nullptr;
+			if ( SlotValue )
+			{
+				Run.Text = SlotValue->ToString();
+				for ( const UBYGRichTextPropertyBase* Prop : Props )
+				{
+					Prop->TransformString( Run.Text );
+				}
+			}
+		}
+
+		// Icons with no text are given a character to be laid out on
+		if ( Run.Text.IsEmpty() && !MinSize.IsZero() )
+		{
+			Run.Text = TEXT( "\u00A0" );
+		}
+		Run.bAtomic = Run.bAtomic || !MinSize.IsZero();
+
+		SetRunMetrics( Run, TextBlockStyle, MinSize, Scale );
+		return Run;
+	}
+
+	class FLineBreaker
+	{
+	public:
+		FLineBreaker( const IBYGTextMeasure& InMeasure, const FBYGBlockLayoutStyle& InBlockStyle, float InAvailableWidth, float InScale )
+			: Measure( InMeasure )
+			, BlockStyle( InBlockStyle )
+			, AvailableWidth( InAvailableWidth )
+			, Scale( InScale )
+		{
+		}
+
+		void AddLine( const TArray<FPredictedRun>& Runs, const FPredictedRun& EmptyLineRun )
+		{
+			FPredictedWord Word;
+			for ( int32 RunIndex = 0; RunIndex < Runs.Num(); ++RunIndex )
+			{
+				const FPredictedRun& Run = Runs[ RunIndex ];
+				if ( Run.Text.IsEmpty() )
+					continue;
+
+				if ( Run.bAtomic )
+				{
+					if ( Word.TrailingWidth > 0.0f )
+					{
+						PlaceWord( Runs, Word );
+					}
+					Word.AddMetrics( Run );
+					const float Width = FMath::Max( MeasureRange( Run, 0, Run.Text.Len() ), Run.MinWidth );
+					Word.Fragments.Add( { RunIndex, 0, Run.Text.Len() } );
+					Word.Width += Width;
+					continue;
+				}
+
+				int32 SegmentStart = 0;
+				while ( SegmentStart < Run.Text.Len() )
+				{
+					const bool bWhitespace = FChar::IsWhitespace( Run.Text[ SegmentStart ] );
+					int32 SegmentEnd = SegmentStart + 1;
+					while ( SegmentEnd < Run.Text.Len() && FChar::IsWhitespace( Run.Text[ SegmentEnd ] ) == bWhitespace )
+					{
+						++SegmentEnd;
+					}
+
+					const float Width = MeasureRange( Run, SegmentStart, SegmentEnd );
+					if ( bWhitespace )
+					{
+						Word.AddMetrics( Run );
+						Word.TrailingWidth += Width;
+					}
+					else
+					{
+						// Can break after whitespace, so this is the start of a new word
+						if ( Word.TrailingWidth > 0.0f )
+						{
+							PlaceWord( Runs, Word );
+						}
+						Word.AddMetrics( Run );
+						Word.Fragments.Add( { RunIndex, SegmentStart, SegmentEnd } );
+						Word.Width += Width;
+					}
+					SegmentStart = SegmentEnd;
+				}
+			}
+
+			if ( !Word.IsEmpty() )
+			{
+				PlaceWord( Runs, Word );
+			}
+
+			if ( !Line.bHasContent )
+			{
+				Line.AboveBaseline = FMath::Max( Line.AboveBaseline, EmptyLineRun.AboveBaseline );
+				Line.BelowBaseline = FMath::Max( Line.BelowBaseline, EmptyLineRun.BelowBaseline );
+			}
+			FinishLine();
+		}
+
+		FVector2D GetSize() const { return Size; }
+		int32 GetNumLines() const { return NumLines; }
+
+	protected:
+		float MeasureRange( const FPredictedRun& Run, int32 BeginIndex, int32 EndIndex ) const
+		{
+			return Measure.Measure( Run.Text, BeginIndex, EndIndex, Run.Font, Scale ).X;
+		}
+
+		bool ShouldWrap() const { return BlockStyle.bAutoWrap && AvailableWidth > 0.0f; }
+
+		void PlaceWord( const TArray<FPredictedRun>& Runs, FPredictedWord& Word )
+		{
+			if ( ShouldWrap() && Word.Width > AvailableWidth && BlockStyle.WrappingPolicy == ETextWrappingPolicy::AllowPerCharacterWrapping )
+			{
+				PlaceWordPerCharacter( Runs, Word );
+			}
+			else
+			{
+				if ( ShouldWrap() && Line.bHasContent && Line.Width + Line.PendingTrailing + Word.Width > AvailableWidth )
+				{
+					FinishLine();
+				}
+				Line.Width += Line.PendingTrailing + Word.Width;
+				Line.PendingTrailing = Word.TrailingWidth;
+				Line.AboveBaseline = FMath::Max( Line.AboveBaseline, Word.AboveBaseline );
+				Line.BelowBaseline = FMath::Max( Line.BelowBaseline, Word.BelowBaseline );
+				Line.bHasContent = true;
+			}
+			Word = FPredictedWord();
+		}
+
+		// Words too long for a line are split wherever they need to be
+		void PlaceWordPerCharacter( const TArray<FPredictedRun>& Runs, const FPredictedWord& Word )
+		{
+			for ( const FPredictedWord::FFragment& Fragment : Word.Fragments )
+			{
+				const FPredictedRun& Run = Runs[ Fragment.RunIndex ];
+				for ( int32 CharIndex = Fragment.BeginIndex; CharIndex < Fragment.EndIndex; ++CharIndex )
+				{
+					const float Width = Run.bAtomic ? FMath::Max( MeasureRange( Run, Fragment.BeginIndex, Fragment.EndIndex ), Run.MinWidth ) : MeasureRange( Run, CharIndex, CharIndex + 1 );
+					if ( Line.bHasContent && Line.Width + Line.PendingTrailing + Width > AvailableWidth )
+					{
+						FinishLine();
+					}
+					Line.Width += Line.PendingTrailing + Width;
+					Line.PendingTrailing = 0.0f;
+					Line.AboveBaseline = FMath::Max( Line.AboveBaseline, Run.AboveBaseline );
+					Line.BelowBaseline = FMath::Max( Line.BelowBaseline, Run.BelowBaseline );
+					Line.bHasContent = true;
+					if ( Run.bAtomic )
+						break;
+				}
+			}
+			Line.PendingTrailing = Word.TrailingWidth;
+		}
+
+		void FinishLine()
+		{
+			Size.X = FMath::Max( Size.X, Line.Width );
+			Size.Y += ( Line.AboveBaseline + Line.BelowBaseline ) * BlockStyle.LineHeightPercentage;
+			++NumLines;
+			Line = FPredictedLine();
+		}
+
+		const IBYGTextMeasure& Measure;
+		const FBYGBlockLayoutStyle& BlockStyle;
+		float AvailableWidth = 0.0f;
+		float Scale = 1.0f;
+
+		FPredictedLine Line;
+		FVector2D Size = FVector2D::ZeroVector;
+		int32 NumLines = 0;
+	};
+}
+
+FBYGPredictedLayout FBYGRichTextLayoutPredictor::Predict( const FString& Markup, const UBYGRichTextStylesheet* Stylesheet, float WrapWidth, float Scale, const TMap<FName, FText>* SlotValues )
+{
+	if ( !ensure( Stylesheet ) )
+	{
+		return FBYGPredictedLayout();
+	}
+
+	// Same element name as UBYGRichTextBlock, so parser output is shared with widgets
+	TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+
+	FBYGRichTextLayoutKey Key;
+	Key.Stylesheet = Stylesheet;
+	Key.ParseHash = Parser->GetParseHash();
+	Key.Text = Markup;
+	Key.WrapWidth = WrapWidth;
+	Key.Scale = Scale;
+	Key.SlotValuesHash = FBYGRichTextLayoutKey::GetSlotValuesHash( SlotValues );
+
+	FBYGPredictedLayout Result;
+	if ( FBYGRichTextLayoutCache::Get().Find( Key, Result ) )
+	{
+		return Result;
+	}
+
+	TSharedPtr<const FBYGParsedText> Parsed = FBYGRichTextParseCache::Get().Find( Key.ParseHash, Markup );
+	if ( !Parsed.IsValid() )
+	{
+		TSharedRef<const FBYGParsedText> NewParsed = Parser->ParseFully( Markup );
+		FBYGRichTextParseCache::Get().AddShared( Key.ParseHash, Markup, NewParsed );
+		Parsed = NewParsed;
+	}
+
+	Result = Predict( *Parsed, Stylesheet, WrapWidth, Scale, SlotValues );
+	FBYGRichTextLayoutCache::Get().Add( Key, Result );
+	return Result;
+}
+
+FBYGPredictedLayout FBYGRichTextLayoutPredictor::Predict( const FBYGParsedText& Parsed, const UBYGRichTextStylesheet* Stylesheet, float WrapWidth, float Scale, const TMap<FName, FText>* SlotValues )
+{
+	FBYGPredictedLayout Result;
+	if ( !ensure( Stylesheet ) || !ensure( Scale > 0.0f ) )
+	{
+		return Result;
+	}
+
+	const TSharedRef<IBYGTextMeasure> Measure = FBYGTextMeasure::Get();
+
+	// Lines with no runs still take up the height of the default font
+	FPredictedRun EmptyLineRun;
+	SetRunMetrics( EmptyLineRun, GetDefaultTextStyle( Stylesheet ), FVector2D::ZeroVector, Scale );
+
+	for ( int32 BlockIndex = 0; BlockIndex < Parsed.Blocks.Num() && BlockIndex < Parsed.BlockRuns.Num(); ++BlockIndex )
+	{
+		FBYGTextBlockInfo BlockInfo = Parsed.Blocks[ BlockIndex ];
+		BlockInfo.ResolveProperties( Stylesheet );
+
+		FBYGBlockLayoutStyle BlockStyle;
+		for ( const auto& Pair : BlockInfo.GetPropertiesWithDefaults( Stylesheet ) )
+		{
+			Pair.Value->ApplyToBlockStyle( BlockStyle );
+		}
+
+		const FVector2D MarginSize = BlockStyle.Margin.GetDesiredSize();
+		const float AvailableWidth = WrapWidth > 0.0f ? FMath::Max( WrapWidth - MarginSize.X, 0.0f ) * Scale : 0.0f;
+		FLineBreaker LineBreaker( *Measure, BlockStyle, AvailableWidth, Scale );
+
+		const FBYGParsedBlockRuns& BlockRuns = Parsed.BlockRuns[ BlockIndex ];
+		TArray<FPredictedRun> Runs;
+		for ( const FTextLineParseResults& LineResult : BlockRuns.Lines )
+		{
+			Runs.Reset();
+			for ( const FTextRunParseResults& RunResult : LineResult.Runs )
+			{
+				Runs.Add( CreateRun( RunResult, BlockRuns.Output, Stylesheet, Scale, SlotValues ) );
+			}
+			LineBreaker.AddLine( Runs, EmptyLineRun );
+		}
+
+		const FVector2D BlockSize = LineBreaker.GetSize() / Scale + MarginSize;
+		Result.BlockHeights.Add( BlockSize.Y );
+		Result.BlockLineCounts.Add( LineBreaker.GetNumLines() );
+
+		// Blocks are stacked in a vertical box
+		Result.DesiredSize.X = FMath::Max( Result.DesiredSize.X, BlockSize.X );
+		Result.DesiredSize.Y += BlockSize.Y;
+	}
+
+	return Result;
+}
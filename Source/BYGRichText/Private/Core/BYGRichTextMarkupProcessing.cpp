@@ -8,10 +8,15 @@
 
 #include "Widget/BYGRichTextBlock.h"
 #include "Settings/BYGRichTextStylesheet.h"
+#include "Settings/BYGRichTextStyle.h"
 #include "Settings/BYGRichTextProperty.h"
 #include "BYGRichTextRuntimeSettings.h"
 #include "BYGStyleStack.h"
+#include "BYGCharacterScan.h"
+#include "BYGDelimiters.h"
 #include "BYGRichTextModule.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGRichTextMemory.h"
 
 
 static const FString CloseTag = "/";
@@ -78,53 +83,349 @@ void FBYGTextBlockInfo::OverwriteProperties( const FName& StyleName, const TArra
 }
 
 
+SIZE_T FBYGTextBlockInfo::GetAllocatedSize() const
+{
+	SIZE_T Size = RawText.GetAllocatedSize() + StylesApplied.GetAllocatedSize() + BlockPropertiesMap.GetAllocatedSize() + SlotNames.GetAllocatedSize();
+	Size += Payload.GetAllocatedSize();
+	for ( const TPair<FString, FString>& Pair : Payload )
+	{
+		Size += Pair.Key.GetAllocatedSize() + Pair.Value.GetAllocatedSize();
+	}
+	return Size;
+}
+
+SIZE_T FBYGParsedBlockRuns::GetAllocatedSize() const
+{
+	SIZE_T Size = Output.GetAllocatedSize() + Lines.GetAllocatedSize();
+	for ( const FTextLineParseResults& Line : Lines )
+	{
+		Size += Line.Runs.GetAllocatedSize();
+		for ( const FTextRunParseResults& Run : Line.Runs )
+		{
+			Size += Run.Name.GetAllocatedSize() + Run.MetaData.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+void FBYGTextBlockInfo::ResolveProperties( const UBYGRichTextStylesheet* Stylesheet )
+{
+	BlockPropertiesMap.Reset();
+	if ( !Stylesheet )
+		return;
+
+	// Same order as OverwriteProperties was called during parsing, so later styles win
+	for ( const FName& StyleName : StylesApplied )
+	{
+		const UBYGRichTextStyle* Style = Stylesheet->FindStyle( StyleName );
+		if ( !Style )
+			continue;
+		for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+		{
+			if ( Prop )
+			{
+				BlockPropertiesMap.Add( Prop->GetTypeID(), Prop );
+			}
+		}
+	}
+}
+
+TMap<FName, const UBYGRichTextPropertyBase*> FBYGTextBlockInfo::GetPropertiesWithDefaults( const UBYGRichTextStylesheet* Stylesheet ) const
+{
+	TMap<FName, const UBYGRichTextPropertyBase*> Result = BlockPropertiesMap;
+	if ( !Stylesheet )
+		return Result;
+
+	// Add any properties that should be applied, if they have not already got defaults
+	for ( const UBYGRichTextPropertyBase* Prop : Stylesheet->GetDefaultProperties() )
+	{
+		if ( !Result.Contains( Prop->GetTypeID() )
+			&& Prop->GetShouldApplyToDefault() )
+		{
+			Result.Add( Prop->GetTypeID(), Prop );
+		}
+	}
+	return Result;
+}
+
 TSharedRef<FBYGRichTextMarkupParser> FBYGRichTextMarkupParser::Create( UBYGRichTextBlock* InTextBlockOwner, const FString& InXMLElementName )
 {
-	return MakeShareable( new FBYGRichTextMarkupParser( InTextBlockOwner, InXMLElementName ) );
+	return MakeShareable( new FBYGRichTextMarkupParser( InTextBlockOwner, nullptr, InXMLElementName ) );
 }
 
-FBYGRichTextMarkupParser::FBYGRichTextMarkupParser( UBYGRichTextBlock* InTextBlockOwner, const FString& InXMLElementName )
+TSharedRef<FBYGRichTextMarkupParser> FBYGRichTextMarkupParser::Create( const UBYGRichTextStylesheet* InStylesheet, const FString& InXMLElementName )
+{
+	return MakeShareable( new FBYGRichTextMarkupParser( nullptr, InStylesheet, InXMLElementName ) );
+}
+
+FBYGRichTextMarkupParser::FBYGRichTextMarkupParser( UBYGRichTextBlock* InTextBlockOwner, const UBYGRichTextStylesheet* InStylesheet, const FString& InXMLElementName )
 	: TextBlockOwner( InTextBlockOwner )
+	, Stylesheet( InStylesheet )
 	, XMLElementName( InXMLElementName )
 {
 }
 
+const UBYGRichTextStylesheet* FBYGRichTextMarkupParser::GetStylesheet() const
+{
+	if ( TextBlockOwner )
+	{
+		return TextBlockOwner->GetRichTextStylesheet();
+	}
+	return Stylesheet;
+}
+
+uint32 FBYGRichTextMarkupParser::GetParseHash() const
+{
+	const UBYGRichTextStylesheet* RichTextStylesheet = GetStylesheet();
+	uint32 Hash = RichTextStylesheet ? RichTextStylesheet->GetParseHash() : 0;
+
+	const UBYGRichTextRuntimeSettings* Settings = GetDefault<UBYGRichTextRuntimeSettings>();
+	if ( Settings )
+	{
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Settings->TagOpenCharacter ) );
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Settings->TagCloseCharacter ) );
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Settings->ParagraphSeparator ) );
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Settings->SlotOpenCharacter ) );
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Settings->SlotCloseCharacter ) );
+	}
+	return HashCombine( Hash, FCrc::StrCrc32( *XMLElementName ) );
+}
+
 void FBYGRichTextMarkupParser::Process( TArray<FTextLineParseResults>& Results, const FString& Input, FString& Output )
+{
+	BYG_RICHTEXT_LLM_SCOPE();
+
+	if ( SharedParsed.IsValid() )
+	{
+		for ( int32 i = 0; i < SharedParsed->Blocks.Num() && i < SharedParsed->BlockRuns.Num(); ++i )
+		{
+			if ( SharedParsed->Blocks[ i ].RawText.Equals( Input, ESearchCase::CaseSensitive ) )
+			{
+				Results = SharedParsed->BlockRuns[ i ].Lines;
+				Output = SharedParsed->BlockRuns[ i ].Output;
+				return;
+			}
+		}
+	}
+
+	if ( const FBYGParsedBlockRuns* Processed = ProcessedInputs.Find( Input ) )
+	{
+		Results = Processed->Lines;
+		Output = Processed->Output;
+		return;
+	}
+
+	ProcessUncached( Results, Input, Output );
+
+	FBYGParsedBlockRuns& NewProcessed = ProcessedInputs.Add( Input );
+	NewProcessed.Lines = Results;
+	NewProcessed.Output = Output;
+}
+
+void FBYGRichTextMarkupParser::ProcessUncached( TArray<FTextLineParseResults>& Results, const FString& Input, FString& Output )
 {
 	TSharedRef<class FDefaultRichTextMarkupParser> DefaultParser = FDefaultRichTextMarkupParser::Create();
 	DefaultParser->Process( Results, ConvertInputToInlineXML( Input ), Output );
 }
 
+TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::ParseBlocks( const FString& Input )
+{
+	BYG_RICHTEXT_LLM_SCOPE();
 
-void EmitStyledText( FString& Dst, FString& Content, const TArray<const UBYGRichTextPropertyBase*>& Properties, const FString& XMLElementName, const TMap<FString, FString>& Payload  )
+	const uint32 ParseHash = GetParseHash();
+	TSharedPtr<const FBYGParsedText> Parsed = FBYGRichTextParseCache::Get().Find( ParseHash, Input );
+	if ( !Parsed.IsValid() )
+	{
+		if ( GetDefault<UBYGRichTextRuntimeSettings>()->MaxSharedParsedTexts <= 0 )
+		{
+			return SplitIntoBlocks( Input );
+		}
+
+		TSharedRef<const FBYGParsedText> NewParsed = ParseFully( Input );
+		FBYGRichTextParseCache::Get().AddShared( ParseHash, Input, NewParsed );
+		Parsed = NewParsed;
+	}
+
+	ApplyParsedText( Parsed.ToSharedRef() );
+
+	TArray<FBYGTextBlockInfo> Blocks = Parsed->Blocks;
+	for ( FBYGTextBlockInfo& Block : Blocks )
+	{
+		Block.ResolveProperties( GetStylesheet() );
+	}
+	return Blocks;
+}
+
+TSharedRef<FBYGParsedText> FBYGRichTextMarkupParser::ParseFully( const FString& Input )
 {
-	TArray<FString> PropIDs;
-	for ( const UBYGRichTextPropertyBase* Prop : Properties )
+	BYG_RICHTEXT_LLM_SCOPE();
+
+	TSharedRef<FBYGParsedText> Parsed = MakeShared<FBYGParsedText>();
+	Parsed->Blocks = SplitIntoBlocks( Input );
+	for ( FBYGTextBlockInfo& Block : Parsed->Blocks )
 	{
-		Prop->TransformString( Content );
-		PropIDs.Add( Prop->GetInlineID() );
+		// Straight into the parsed text. Process would keep a copy in ProcessedInputs, which is thrown away as
+		// soon as the parsed text is applied
+		FBYGParsedBlockRuns& Runs = Parsed->BlockRuns.AddDefaulted_GetRef();
+		ProcessUncached( Runs.Lines, Block.RawText, Runs.Output );
+		// Pointers into the stylesheet can't outlive it, they're resolved again on use
+		Block.BlockPropertiesMap.Reset();
 	}
-	ensure( PropIDs.Num() > 0 );
+	Parsed->UsedStyleIDs = UsedStyleIDs.Array();
+	Parsed->UsedPropertyTypeIDs = UsedPropertyTypeIDs.Array();
+	return Parsed;
+}
 
-	FString PayloadString = "";
+SIZE_T FBYGRichTextMarkupParser::GetAllocatedSize() const
+{
+	SIZE_T Size = XMLElementName.GetAllocatedSize() + UsedStyleIDs.GetAllocatedSize() + UsedPropertyTypeIDs.GetAllocatedSize();
+	Size += InlineXMLBuffer.GetAllocatedSize() + TokenBuffer.GetAllocatedSize();
+	Size += ProcessedInputs.GetAllocatedSize();
+	for ( const TPair<FString, FBYGParsedBlockRuns>& Pair : ProcessedInputs )
 	{
+		Size += Pair.Key.GetAllocatedSize() + Pair.Value.GetAllocatedSize();
+	}
+	// SharedParsed belongs to the parse cache
+	return Size;
+}
 
-		TArray<FString> PayloadParts;
-		for ( const auto& Pair : Payload )
+void FBYGRichTextMarkupParser::ApplyParsedText( const TSharedRef<const FBYGParsedText>& Parsed )
+{
+	UsedStyleIDs.Reset();
+	UsedStyleIDs.Append( Parsed->UsedStyleIDs );
+	UsedPropertyTypeIDs.Reset();
+	UsedPropertyTypeIDs.Append( Parsed->UsedPropertyTypeIDs );
+
+	ProcessedInputs.Reset();
+	SharedParsed = Parsed;
+}
+
+void FBYGRichTextMarkupParser::RecordStyleUsage( const UBYGRichTextStyle* Style )
+{
+	if ( !Style )
+		return;
+
+	UsedStyleIDs.Add( Style->GetID() );
+	for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+	{
+		RecordPropertyUsage( Prop );
+	}
+}
+
+void FBYGRichTextMarkupParser::RecordPropertyUsage( const UBYGRichTextPropertyBase* Prop )
+{
+	if ( Prop )
+	{
+		UsedPropertyTypeIDs.Add( Prop->GetTypeID() );
+	}
+}
+
+
+// A key:value from an inline tag's payload, pointing into the input rather than copied out of it
+struct FBYGPayloadRange
+{
+	const TCHAR* Key = nullptr;
+	int32 KeyLen = 0;
+	const TCHAR* Value = nullptr;
+	int32 ValueLen = 0;
+};
+// Tags rarely carry more than a couple, so this stays off the heap
+typedef TArray<FBYGPayloadRange, TInlineAllocator<8>> FBYGPayloadRanges;
+
+// Same key twice keeps the first one's place with the last one's value, like TMap::Add
+void AddPayloadRange( FBYGPayloadRanges& Payload, const TCHAR* Key, int32 KeyLen, const TCHAR* Value, int32 ValueLen )
+{
+	for ( FBYGPayloadRange& Existing : Payload )
+	{
+		if ( Existing.KeyLen == KeyLen && FCString::Strncmp( Existing.Key, Key, KeyLen ) == 0 )
 		{
-			PayloadParts.Add( FString::Printf( TEXT( "%s=\"%s\"" ), *Pair.Key, *Pair.Value ) );
+			Existing.Value = Value;
+			Existing.ValueLen = ValueLen;
+			return;
 		}
-		if ( PayloadParts.Num() > 0 )
+	}
+	Payload.Add( { Key, KeyLen, Value, ValueLen } );
+}
+
+// The key:val key:val after an inline tag's ID, read the same way FBYGIDPayload does: parts split on spaces,
+// then on colons with empty pieces dropped. A lone key gets an empty value, more than two pieces is ignored
+void ParsePayloadRanges( const TCHAR* Text, int32 Start, int32 End, FBYGPayloadRanges& OutPayload )
+{
+	int32 i = Start;
+	while ( i < End )
+	{
+		while ( i < End && Text[ i ] == ' ' )
+		{
+			++i;
+		}
+		int32 PartEnd = i;
+		while ( PartEnd < End && Text[ PartEnd ] != ' ' )
 		{
-			PayloadString = " " + FString::Join( PayloadParts, TEXT( " " ) );
+			++PartEnd;
 		}
+
+		const TCHAR* Pieces[ 2 ] = { TEXT( "" ), TEXT( "" ) };
+		int32 PieceLens[ 2 ] = { 0, 0 };
+		int32 NumPieces = 0;
+		for ( int32 j = i; j < PartEnd; )
+		{
+			if ( Text[ j ] == ':' )
+			{
+				++j;
+				continue;
+			}
+			const int32 PieceStart = j;
+			while ( j < PartEnd && Text[ j ] != ':' )
+			{
+				++j;
+			}
+			if ( NumPieces < 2 )
+			{
+				Pieces[ NumPieces ] = Text + PieceStart;
+				PieceLens[ NumPieces ] = j - PieceStart;
+			}
+			++NumPieces;
+		}
+		if ( NumPieces == 1 || NumPieces == 2 )
+		{
+			AddPayloadRange( OutPayload, Pieces[ 0 ], PieceLens[ 0 ], Pieces[ 1 ], PieceLens[ 1 ] );
+		}
+		i = PartEnd;
 	}
+}
 
-	Dst += FString::Printf( TEXT( "<%s ids=\"%s\"%s>%s</>" ),
-		*XMLElementName,
-		*FString::Join( PropIDs, TEXT( " " ) ),
-		*PayloadString,
-		*Content );
+// Appends <s ids="Style.Type Style.Type" key="value">Content</> straight onto Dst, which is reused between
+// parses, so nothing here allocates once it has grown
+void EmitStyledText( FString& Dst, FString& Content, const TArray<const UBYGRichTextPropertyBase*>& Properties, const FString& XMLElementName, const FBYGPayloadRanges& Payload )
+{
+	ensure( Properties.Num() > 0 );
+
+	Dst += TEXT( '<' );
+	Dst += XMLElementName;
+	Dst += TEXT( " ids=\"" );
+	for ( int32 i = 0; i < Properties.Num(); ++i )
+	{
+		Properties[ i ]->TransformString( Content );
+		if ( i > 0 )
+		{
+			Dst += TEXT( ' ' );
+		}
+		Dst += Properties[ i ]->GetInlineID();
+	}
+	Dst += TEXT( '"' );
+
+	for ( const FBYGPayloadRange& Pair : Payload )
+	{
+		Dst += TEXT( ' ' );
+		Dst.AppendChars( Pair.Key, Pair.KeyLen );
+		Dst += TEXT( "=\"" );
+		Dst.AppendChars( Pair.Value, Pair.ValueLen );
+		Dst += TEXT( '"' );
+	}
+
+	Dst += TEXT( '>' );
+	Dst += Content;
+	Dst += TEXT( "</>" );
 }
 
 
@@ -139,20 +440,20 @@ void AppendCharacters( FString& CurrentString, TCHAR c, int Count = 1 )
 
 
 // Output the current state of the system to the regular <span> format that Unreal expects
-void FlushToken( FString& Dst, FString& CurrentToken, const FBYGStyleStack& StyleStack, const FString& XMLElementName, const TMap<FString, FString>& Payload )
+void FlushToken( FString& Dst, FString& CurrentToken, const FBYGStyleStack& StyleStack, const FString& XMLElementName, const FBYGPayloadRanges& Payload )
 {
 	if ( CurrentToken.Len() == 0 ) // || StyleStack.Num() == 0)
 	{
 		//return;
 	}
 
-	TArray<const UBYGRichTextPropertyBase*> Properties = StyleStack.GetHeadProperties();
+	const TArray<const UBYGRichTextPropertyBase*>& Properties = StyleStack.GetHeadProperties();
 
 	//CurrentToken.TrimStartAndEndInline();
 
 	EmitStyledText( Dst, CurrentToken, Properties, XMLElementName, Payload );
 
-	CurrentToken = FString();
+	CurrentToken.Reset();
 }
 void TrimNewlineStartInline( FString& Str )
 {
@@ -324,12 +625,8 @@ bool EmitLink( FString& Result, FString& CurrentToken,
 
 bool MatchForward( TCHAR const* InputText, const int32 StartIndex, const FString& Str )
 {
-	const int32 InputLength = FCString::Strlen( InputText );
-	const int32 MatchLength = FCString::Strlen( *Str );
-	// Match string is longer than space we have left
-	if ( StartIndex + MatchLength >= InputLength )
-		return false;
-
+	// Runs off the end of the input at the terminator, which never matches
+	const int32 MatchLength = Str.Len();
 	for ( int32 i = 0; i < MatchLength; ++i )
 	{
 		const TCHAR a = InputText[ StartIndex + i ];
@@ -337,21 +634,88 @@ bool MatchForward( TCHAR const* InputText, const int32 StartIndex, const FString
 		if ( a != b )
 			return false;
 	}
-	return true;
+	// A match has to have more input after it
+	return InputText[ StartIndex + MatchLength ] != 0;
+}
+
+// Any character that could start a shortcut
+void AddShortcutCharacters( FBYGCharacterScan& Scan, const UBYGRichTextStylesheet* Stylesheet )
+{
+	for ( const UBYGRichTextStyle* Style : Stylesheet->Styles )
+	{
+		if ( Style && Style->HasShortcut() )
+		{
+			Scan.Add( Style->GetShortcut()[ 0 ] );
+		}
+	}
+}
+
+// Slots look like {Name}, names are letters, numbers and underscores only so stray braces stay as text
+// The name is between StartIndex and OutEndIndex
+template <typename DelimitersType>
+bool ParseSlotToken( const FString& Input, int32 StartIndex, const DelimitersType& Delimiters, int32& OutEndIndex )
+{
+	if ( Input[ StartIndex ] != Delimiters.SlotOpen )
+		return false;
 
+	for ( int32 j = StartIndex + 1; j < Input.Len(); ++j )
+	{
+		const TCHAR c = Input[ j ];
+		if ( c == Delimiters.SlotClose )
+		{
+			if ( j == StartIndex + 1 )
+				return false;
+			OutEndIndex = j;
+			return true;
+		}
+		if ( !FChar::IsAlnum( c ) && c != '_' )
+			return false;
+	}
+	return false;
+}
+
+template <typename DelimitersType>
+void CollectSlotNames( FBYGTextBlockInfo& BlockInfo, const DelimitersType& Delimiters )
+{
+	const FString& RawText = BlockInfo.RawText;
+	bool bEscapeCharacter = false;
+	for ( int32 i = 0; i < RawText.Len(); ++i )
+	{
+		int32 SlotEndIndex = INDEX_NONE;
+		if ( !bEscapeCharacter && ParseSlotToken( RawText, i, Delimiters, SlotEndIndex ) )
+		{
+			BlockInfo.SlotNames.AddUnique( FName( SlotEndIndex - i - 1, *RawText + i + 1 ) );
+			i = SlotEndIndex;
+			continue;
+		}
+		bEscapeCharacter = !bEscapeCharacter && RawText[ i ] == '\\';
+	}
 }
 
 TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FString& Input )
 {
 	const UBYGRichTextRuntimeSettings* Settings = GetDefault<UBYGRichTextRuntimeSettings>();
 	ensureMsgf( Settings, TEXT( "Could not load default BYGRichTextRuntimeSettings" ) );
-	const bool bSplitParagraphs = Settings && !Settings->ParagraphSeparator.IsEmpty();
-	const FString ParagraphSeparator = Settings ? Settings->ParagraphSeparator : "\r\n\r\n";
+	if ( FBYGDefaultDelimiters::Matches( Settings ) )
+	{
+		return SplitIntoBlocks( Input, FBYGDefaultDelimiters() );
+	}
+	return SplitIntoBlocks( Input, FBYGConfigDelimiters( Settings ) );
+}
 
-	const UBYGRichTextStylesheet* RichTextStylesheet = TextBlockOwner->GetRichTextStylesheet();
+template <typename DelimitersType>
+TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FString& Input, const DelimitersType& Delimiters )
+{
+	const UBYGRichTextStylesheet* RichTextStylesheet = GetStylesheet();
 
 	TArray<FBYGTextBlockInfo> BlockInfos;
 
+	// A new parse, anything recorded before is stale
+	UsedStyleIDs.Reset();
+	UsedPropertyTypeIDs.Reset();
+	ProcessedInputs.Reset();
+	SharedParsed.Reset();
+
 	#if 0
 	if ( !RichTextStylesheet )
 	{
@@ -366,6 +730,7 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 	const UBYGRichTextStyle* DefaultStyle = RichTextStylesheet->FindStyle( RichTextStylesheet->GetDefaultStyleName() );
 	if ( DefaultStyle )
 	{
+		RecordStyleUsage( DefaultStyle );
 		CurrentBlockInfo.OverwriteProperties( DefaultStyle->GetID(), DefaultStyle->Properties );
 	}
 	else
@@ -375,6 +740,13 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 
 
 	TCHAR const* InputText = *Input;
+	const int32 InputLength = Input.Len();
+
+	// Block shortcuts are only looked for at the start of a line, so lines are stepped through one character at a time
+	FBYGCharacterScan Scan;
+	Scan.Add( '\n' );
+	Scan.Add( Delimiters.TagOpen );
+	Scan.Add( Delimiters.ParagraphSeparatorStart );
 
 	// iterate over all characters
 	bool bEscapeCharacter = false;
@@ -382,22 +754,31 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 	{
 		const TCHAR c = InputText[ i ];
 
+		// Plain text up to the next character that could mean something, copied in one go
+		if ( i > 0 && InputText[ i - 1 ] != '\n' && !Scan.IsSpecial( c ) )
+		{
+			const int32 End = Scan.FindNext( InputText, i + 1, InputLength );
+			CurrentBlockInfo.RawText.AppendChars( InputText + i, End - i );
+			i = End - 1;
+			continue;
+		}
+
 		// Paragraph separator, e.g. two newlines
-		if ( bSplitParagraphs && MatchForward( InputText, i, ParagraphSeparator) )
+		if ( Delimiters.MatchParagraphSeparator( InputText, i ) )
 		{
 			FlushTokenRaw( BlockInfos, CurrentBlockInfo );
 			if ( DefaultStyle )
 				CurrentBlockInfo.OverwriteProperties( DefaultStyle->GetID(), DefaultStyle->Properties );
-			i += ParagraphSeparator.Len() - 1;
+			i += Delimiters.ParagraphSeparatorLen - 1;
 		}
-		else if ( c == Settings->TagOpenCharacter[ 0 ] )
+		else if ( c == Delimiters.TagOpen )
 		{
 			// Look forward until we find an end tag
 			size_t j = i;
 			int32 IDEndIndex = INDEX_NONE;
 			while ( j < Input.Len() )
 			{
-				if ( InputText[ j ] == Settings->TagCloseCharacter[ 0 ] )
+				if ( InputText[ j ] == Delimiters.TagClose )
 				{
 					IDEndIndex = j;
 					break;
@@ -408,15 +789,27 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 			if ( IDEndIndex != INDEX_NONE )
 			{
 				// contents of the start block can be [id key:val key:val], id cannot have spaces
-				const FString TagInternals = Input.Mid( i + 1, IDEndIndex - i - 1 ).TrimStartAndEnd();
-				if ( TagInternals == CloseTag )
+				// Trimmed in place as in ConvertInputToInlineXML, only block styles need their payload copied out
+				int32 TagStart = i + 1;
+				int32 TagEnd = IDEndIndex;
+				while ( TagStart < TagEnd && FChar::IsWhitespace( InputText[ TagStart ] ) )
 				{
-					while ( i <= IDEndIndex )
-					{
-						AppendCharacters( CurrentBlockInfo.RawText, InputText[ i ] );
-						++i;
-					}
-					i -= 1;
+					++TagStart;
+				}
+				while ( TagEnd > TagStart && FChar::IsWhitespace( InputText[ TagEnd - 1 ] ) )
+				{
+					--TagEnd;
+				}
+				int32 IDEnd = TagStart;
+				while ( IDEnd < TagEnd && InputText[ IDEnd ] != ' ' )
+				{
+					++IDEnd;
+				}
+
+				if ( TagEnd - TagStart == CloseTag.Len() && FCString::Strncmp( InputText + TagStart, *CloseTag, CloseTag.Len() ) == 0 )
+				{
+					CurrentBlockInfo.RawText.AppendChars( InputText + i, IDEndIndex - i + 1 );
+					i = IDEndIndex;
 					if ( CurrentBlockInfo.InlineStyleStackCount > 0 )
 					{
 						CurrentBlockInfo.InlineStyleStackCount -= 1;
@@ -431,17 +824,22 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 				}
 				else
 				{
-					const FBYGIDPayload IDPayload( TagInternals );
-					const UBYGRichTextStyle* NewStyle = RichTextStylesheet->FindStyle( FName( IDPayload.ID ) );
+					const FName ID( IDEnd - TagStart, InputText + TagStart );
+					const UBYGRichTextStyle* NewStyle = RichTextStylesheet->FindStyle( ID );
 					if ( NewStyle )
 					{
+						RecordStyleUsage( NewStyle );
 						if ( NewStyle->GetDisplayType() == EBYGStyleDisplayType::Block )
 						{
 							FlushTokenRaw( BlockInfos, CurrentBlockInfo );
 							if ( DefaultStyle )
 								CurrentBlockInfo.OverwriteProperties( DefaultStyle->GetID(), DefaultStyle->Properties );
 							CurrentBlockInfo.OverwriteProperties( NewStyle->GetID(), NewStyle->Properties );
-							CurrentBlockInfo.Payload = IDPayload.Payload;
+							if ( IDEnd < TagEnd )
+							{
+								const FBYGIDPayload IDPayload( Input.Mid( TagStart, TagEnd - TagStart ) );
+								CurrentBlockInfo.Payload = IDPayload.Payload;
+							}
 						}
 						else
 						{
@@ -450,7 +848,7 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 					}
 					else
 					{
-						UE_LOG( LogTemp, Warning, TEXT( "Style '%s' not found" ), *IDPayload.ID );
+						UE_LOG( LogTemp, Warning, TEXT( "Style '%s' not found" ), *ID.ToString() );
 					}
 
 					AppendCharacters( CurrentBlockInfo.RawText, c );
@@ -470,6 +868,7 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 				const UBYGRichTextStyle* NewStyle = RichTextStylesheet->FindStyle( InputText, j, EBYGStyleDisplayType::Block );
 				if ( NewStyle )
 				{
+					RecordStyleUsage( NewStyle );
 					FlushTokenRaw( BlockInfos, CurrentBlockInfo );
 					if ( DefaultStyle )
 						CurrentBlockInfo.OverwriteProperties( DefaultStyle->GetID(), DefaultStyle->Properties );
@@ -484,17 +883,33 @@ TArray<FBYGTextBlockInfo> FBYGRichTextMarkupParser::SplitIntoBlocks( const FStri
 
 	FlushTokenRaw( BlockInfos, CurrentBlockInfo );
 
+	for ( FBYGTextBlockInfo& BlockInfo : BlockInfos )
+	{
+		CollectSlotNames( BlockInfo, Delimiters );
+	}
+
 	return BlockInfos;
 }
 
 FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input )
 {
-	if ( !TextBlockOwner )
+	const UBYGRichTextRuntimeSettings* Settings = GetDefault<UBYGRichTextRuntimeSettings>();
+	if ( FBYGDefaultDelimiters::Matches( Settings ) )
+	{
+		return ConvertInputToInlineXML( Input, FBYGDefaultDelimiters() );
+	}
+	return ConvertInputToInlineXML( Input, FBYGConfigDelimiters( Settings ) );
+}
+
+template <typename DelimitersType>
+FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input, const DelimitersType& Delimiters )
+{
+	const UBYGRichTextStylesheet* RichTextStylesheet = GetStylesheet();
+	if ( !RichTextStylesheet )
 	{
 		return Input;
 	}
 
-	const UBYGRichTextStylesheet* RichTextStylesheet = TextBlockOwner->GetRichTextStylesheet();
 	#if 0
 	if ( !RichTextStylesheet )
 	{
@@ -510,16 +925,17 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 	}
 
 	// Create the style stack with the defaults from the config
-	const UBYGRichTextRuntimeSettings* Settings = GetDefault<UBYGRichTextRuntimeSettings>();
 	UBYGRichTextStyle* DefaultStyle = RichTextStylesheet->FindStyle( RichTextStylesheet->GetDefaultStyleName() );
 
 	FBYGStyleStack StyleStack;
 	for ( const UBYGRichTextPropertyBase* Prop : RichTextStylesheet->GetDefaultProperties() )
 	{
+		RecordPropertyUsage( Prop );
 		StyleStack.SetRootProperty( Prop, false );
 	}
 	if ( DefaultStyle )
 	{
+		RecordStyleUsage( DefaultStyle );
 		// Default style overwrites any auto-filled properties, and cannot be popped
 		for ( const UBYGRichTextPropertyBase* Prop : DefaultStyle->Properties )
 		{
@@ -527,12 +943,24 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 		}
 	}
 
-	FString Result;
+	FString& Result = InlineXMLBuffer;
+	Result.Reset();
 
 	TCHAR const* InputText = *Input;
+	const int32 InputLength = Input.Len();
+
+	FBYGCharacterScan Scan;
+	Scan.Add( '\r' );
+	Scan.Add( '\n' );
+	Scan.Add( '\\' );
+	Scan.Add( Delimiters.TagOpen );
+	Scan.Add( Delimiters.SlotOpen );
+	AddShortcutCharacters( Scan, RichTextStylesheet );
 
-	FString CurrentToken;
-	TMap<FString, FString> CurrentPayload;
+	FString& CurrentToken = TokenBuffer;
+	CurrentToken.Reset();
+	FBYGPayloadRanges CurrentPayload;
+	int32 SlotEndIndex = INDEX_NONE;
 
 	// Iterate over all characters
 	bool bEscapeCharacter = false;
@@ -540,6 +968,16 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 	{
 		const TCHAR c = InputText[ i ];
 
+		// Plain text up to the next character that could mean something, copied in one go
+		// None of it can be a backslash, so we're still not escaping afterwards
+		if ( !bEscapeCharacter && !Scan.IsSpecial( c ) )
+		{
+			const int32 End = Scan.FindNext( InputText, i + 1, InputLength );
+			CurrentToken.AppendChars( InputText + i, End - i );
+			i = End - 1;
+			continue;
+		}
+
 		bool bNewEscapeCharacter = ( c == '\\' );
 
 		// Found a paragraph break
@@ -554,7 +992,7 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 		{
 			// XXX : pseudo HTML does not support \n inside markups
 			FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-			CurrentPayload.Empty();
+			CurrentPayload.Reset();
 			Result += c;
 		}
 		// If we have an explicit backslash escape character, just output it
@@ -566,16 +1004,30 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 		else if ( bNewEscapeCharacter )
 		{
 
+		}
+		// Named slot, emitted as its own run so the value can be swapped in without reparsing
+		else if ( ParseSlotToken( Input, i, Delimiters, SlotEndIndex ) )
+		{
+			FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
+
+			// The token buffer was just emptied, so it holds the placeholder, shown until a value is set
+			static const TCHAR SlotKey[] = TEXT( "slot" );
+			AddPayloadRange( CurrentPayload, SlotKey, UE_ARRAY_COUNT( SlotKey ) - 1, InputText + i + 1, SlotEndIndex - i - 1 );
+			CurrentToken.AppendChars( InputText + i, SlotEndIndex - i + 1 );
+			FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
+			CurrentPayload.Reset();
+
+			i = SlotEndIndex;
 		}
 		// Start of a new style name
-		else if ( c == Settings->TagOpenCharacter[ 0 ] )
+		else if ( c == Delimiters.TagOpen )
 		{
 			// Look forward until we find an end tag
 			size_t j = i;
 			int32 IDEndIndex = INDEX_NONE;
 			while ( j < Input.Len() )
 			{
-				if ( InputText[ j ] == Settings->TagCloseCharacter[ 0 ] )
+				if ( InputText[ j ] == Delimiters.TagClose )
 				{
 					IDEndIndex = j;
 					break;
@@ -586,34 +1038,58 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 			if ( IDEndIndex != INDEX_NONE )
 			{
 				// contents of the start block can be [id key:val key:val], id cannot have spaces
-				const FString TagInternalsUnstripped = Input.Mid( i + 1, IDEndIndex - i - 1 );
-				const FString TagInternals = TagInternalsUnstripped.TrimStartAndEnd();
+				// Trimmed in place, most tags are a bare ID or a close tag and don't need copying out
+				int32 TagStart = i + 1;
+				int32 TagEnd = IDEndIndex;
+				while ( TagStart < TagEnd && FChar::IsWhitespace( InputText[ TagStart ] ) )
+				{
+					++TagStart;
+				}
+				while ( TagEnd > TagStart && FChar::IsWhitespace( InputText[ TagEnd - 1 ] ) )
+				{
+					--TagEnd;
+				}
+				bool bHasPayload = false;
+				for ( int32 j = TagStart; j < TagEnd && !bHasPayload; ++j )
+				{
+					bHasPayload = InputText[ j ] == ' ';
+				}
 
-				if ( TagInternals == CloseTag )
+				if ( TagEnd - TagStart == CloseTag.Len() && FCString::Strncmp( InputText + TagStart, *CloseTag, CloseTag.Len() ) == 0 )
 				{
 					if ( StyleStack.CanPopStyle() )
 					{
 						FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-						CurrentPayload.Empty();
+						CurrentPayload.Reset();
 						StyleStack.PopStyle();
 					}
 				}
 				else
 				{
 					FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-					CurrentPayload.Empty();
+					CurrentPayload.Reset();
 
-					// compose the identifier
-					const FBYGIDPayload IDPayload( TagInternals );
-					CurrentPayload = IDPayload.Payload;
-					UBYGRichTextStyle* NewStyle = RichTextStylesheet->FindStyle( FName( IDPayload.ID ) );
+					// compose the identifier, the payload is read straight out of the input
+					int32 IDEnd = TagEnd;
+					if ( bHasPayload )
+					{
+						IDEnd = TagStart;
+						while ( InputText[ IDEnd ] != ' ' )
+						{
+							++IDEnd;
+						}
+						ParsePayloadRanges( InputText, IDEnd + 1, TagEnd, CurrentPayload );
+					}
+					const FName ID( IDEnd - TagStart, InputText + TagStart );
+					UBYGRichTextStyle* NewStyle = RichTextStylesheet->FindStyle( ID );
 					if ( NewStyle )
 					{
+						RecordStyleUsage( NewStyle );
 						StyleStack.PushStyle( NewStyle );
 					}
 					else
 					{
-						UE_LOG( LogTemp, Warning, TEXT( "Style '%s' not found" ), *IDPayload.ID );
+						UE_LOG( LogTemp, Warning, TEXT( "Style '%s' not found" ), *ID.ToString() );
 					}
 					// Skip over the [id] stuff
 				}
@@ -636,7 +1112,7 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 				&& MatchForward( InputText, i, StyleStack.GetHeadStyle()->GetShortcut() ) )
 			{
 				FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-				CurrentPayload.Empty();
+				CurrentPayload.Reset();
 				StyleStack.PopStyle();
 			}
 			else
@@ -649,11 +1125,12 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 				if ( NewStyle )
 				{
 					FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-					CurrentPayload.Empty();
+					CurrentPayload.Reset();
 
 					// Skip over the shortcut stuff
 					i += NewStyle->GetShortcutLen() - 1;
 
+					RecordStyleUsage( NewStyle );
 					StyleStack.PushStyle( NewStyle );
 				}
 				else
@@ -669,9 +1146,9 @@ FString FBYGRichTextMarkupParser::ConvertInputToInlineXML( const FString& Input
 	}
 
 	FlushToken( Result, CurrentToken, StyleStack, XMLElementName, CurrentPayload );
-	CurrentPayload.Empty();
+	CurrentPayload.Reset();
 
-	UE_LOG( LogTemp, Warning, TEXT( "Result:\n%s" ), *Result );
+	UE_LOG( LogTemp, Verbose, TEXT( "Result:\n%s" ), *Result );
 
 	return Result;
 }
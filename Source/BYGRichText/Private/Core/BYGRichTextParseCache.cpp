@@ -0,0 +1,326 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "BYGRichTextRuntimeSettings.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+	// "BYGM"
+	const uint32 CompiledMarkupMagic = 0x4259474D;
+
+	// Plain archives don't serialize FNames, so go through strings
+	void SerializeNames( FArchive& Ar, TArray<FName>& Names )
+	{
+		int32 Num = Names.Num();
+		Ar << Num;
+		if ( Ar.IsLoading() )
+		{
+			Names.Reset( Num );
+			for ( int32 i = 0; i < Num && !Ar.IsError(); ++i )
+			{
+				FString Name;
+				Ar << Name;
+				Names.Add( FName( *Name ) );
+			}
+		}
+		else
+		{
+			for ( FName& Name : Names )
+			{
+				FString NameStr = Name.ToString();
+				Ar << NameStr;
+			}
+		}
+	}
+
+	void SerializeRange( FArchive& Ar, FTextRange& Range )
+	{
+		Ar << Range.BeginIndex;
+		Ar << Range.EndIndex;
+	}
+
+	void SerializeRun( FArchive& Ar, FTextRunParseResults& Run )
+	{
+		Ar << Run.Name;
+		SerializeRange( Ar, Run.OriginalRange );
+		SerializeRange( Ar, Run.ContentRange );
+
+		int32 NumMetaData = Run.MetaData.Num();
+		Ar << NumMetaData;
+		if ( Ar.IsLoading() )
+		{
+			Run.MetaData.Reset();
+			for ( int32 i = 0; i < NumMetaData && !Ar.IsError(); ++i )
+			{
+				FString Key;
+				FTextRange Range;
+				Ar << Key;
+				SerializeRange( Ar, Range );
+				Run.MetaData.Add( Key, Range );
+			}
+		}
+		else
+		{
+			for ( TPair<FString, FTextRange>& Pair : Run.MetaData )
+			{
+				Ar << Pair.Key;
+				SerializeRange( Ar, Pair.Value );
+			}
+		}
+	}
+
+	void SerializeBlockRuns( FArchive& Ar, FBYGParsedBlockRuns& BlockRuns )
+	{
+		Ar << BlockRuns.Output;
+
+		int32 NumLines = BlockRuns.Lines.Num();
+		Ar << NumLines;
+		if ( Ar.IsLoading() )
+		{
+			BlockRuns.Lines.Reset( NumLines );
+			BlockRuns.Lines.AddDefaulted( NumLines );
+		}
+		for ( FTextLineParseResults& Line : BlockRuns.Lines )
+		{
+			SerializeRange( Ar, Line.Range );
+
+			int32 NumRuns = Line.Runs.Num();
+			Ar << NumRuns;
+			if ( Ar.IsLoading() )
+			{
+				Line.Runs.Reset( NumRuns );
+				for ( int32 i = 0; i < NumRuns; ++i )
+				{
+					Line.Runs.Emplace( FString(), FTextRange() );
+				}
+			}
+			for ( FTextRunParseResults& Run : Line.Runs )
+			{
+				SerializeRun( Ar, Run );
+			}
+		}
+	}
+
+	void SerializeParsedText( FArchive& Ar, FBYGParsedText& Parsed )
+	{
+		int32 NumBlocks = Parsed.Blocks.Num();
+		Ar << NumBlocks;
+		if ( Ar.IsLoading() )
+		{
+			Parsed.Blocks.Reset( NumBlocks );
+			Parsed.Blocks.AddDefaulted( NumBlocks );
+			Parsed.BlockRuns.Reset( NumBlocks );
+			Parsed.BlockRuns.AddDefaulted( NumBlocks );
+		}
+		if ( !ensure( Parsed.BlockRuns.Num() == Parsed.Blocks.Num() ) )
+		{
+			Ar.SetError();
+			return;
+		}
+		for ( int32 i = 0; i < NumBlocks && !Ar.IsError(); ++i )
+		{
+			FBYGTextBlockInfo& Block = Parsed.Blocks[ i ];
+			Ar << Block.RawText;
+			SerializeNames( Ar, Block.StylesApplied );
+			Ar << Block.Payload;
+			Ar << Block.InlineStyleStackCount;
+			SerializeNames( Ar, Block.SlotNames );
+			SerializeBlockRuns( Ar, Parsed.BlockRuns[ i ] );
+		}
+		SerializeNames( Ar, Parsed.UsedStyleIDs );
+		SerializeNames( Ar, Parsed.UsedPropertyTypeIDs );
+	}
+}
+
+FBYGRichTextParseCache& FBYGRichTextParseCache::Get()
+{
+	static FBYGRichTextParseCache Instance;
+	return Instance;
+}
+
+TSharedPtr<const FBYGParsedText> FBYGRichTextParseCache::Find( uint32 ParseHash, const FString& Text ) const
+{
+	FScopeLock Lock( &CacheLock );
+	for ( const TMap<uint32, FBYGParsedTextMap>* Map : { &Entries, &SharedEntries } )
+	{
+		if ( const FBYGParsedTextMap* ForHash = Map->Find( ParseHash ) )
+		{
+			if ( const TSharedRef<const FBYGParsedText>* Parsed = ForHash->Find( Text ) )
+			{
+				++NumHits;
+				return *Parsed;
+			}
+		}
+	}
+	++NumMisses;
+	return nullptr;
+}
+
+void FBYGRichTextParseCache::GetHitCounts( int64& OutHits, int64& OutMisses ) const
+{
+	FScopeLock Lock( &CacheLock );
+	OutHits = NumHits;
+	OutMisses = NumMisses;
+}
+
+void FBYGRichTextParseCache::ResetHitCounts()
+{
+	FScopeLock Lock( &CacheLock );
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+void FBYGRichTextParseCache::EmptyShared()
+{
+	FScopeLock Lock( &CacheLock );
+	SharedEntries.Empty();
+	SharedOrder.Empty();
+}
+
+void FBYGRichTextParseCache::Add( uint32 ParseHash, const FString& Text, TSharedRef<const FBYGParsedText> Parsed )
+{
+	FScopeLock Lock( &CacheLock );
+	Entries.FindOrAdd( ParseHash ).Add( Text, Parsed );
+}
+
+void FBYGRichTextParseCache::AddShared( uint32 ParseHash, const FString& Text, TSharedRef<const FBYGParsedText> Parsed )
+{
+	const int32 MaxShared = GetDefault<UBYGRichTextRuntimeSettings>()->MaxSharedParsedTexts;
+	if ( MaxShared <= 0 )
+		return;
+
+	FScopeLock Lock( &CacheLock );
+	FBYGParsedTextMap& ForHash = SharedEntries.FindOrAdd( ParseHash );
+	if ( ForHash.Contains( Text ) )
+		return;
+	ForHash.Add( Text, Parsed );
+	SharedOrder.Add( TPair<uint32, FString>( ParseHash, Text ) );
+
+	// Widgets keep hold of what they're using, this only stops us holding on to it forever
+	while ( SharedOrder.Num() > MaxShared )
+	{
+		const TPair<uint32, FString>& Oldest = SharedOrder.First();
+		if ( FBYGParsedTextMap* OldForHash = SharedEntries.Find( Oldest.Key ) )
+		{
+			OldForHash->Remove( Oldest.Value );
+			if ( OldForHash->Num() == 0 )
+			{
+				SharedEntries.Remove( Oldest.Key );
+			}
+		}
+		SharedOrder.PopFirst();
+	}
+}
+
+void FBYGRichTextParseCache::Empty()
+{
+	FScopeLock Lock( &CacheLock );
+	Entries.Empty();
+	SharedEntries.Empty();
+	SharedOrder.Empty();
+}
+
+int32 FBYGRichTextParseCache::Num() const
+{
+	FScopeLock Lock( &CacheLock );
+	int32 Total = 0;
+	for ( const TPair<uint32, FBYGParsedTextMap>& Pair : Entries )
+	{
+		Total += Pair.Value.Num();
+	}
+	return Total;
+}
+
+int32 FBYGRichTextParseCache::NumShared() const
+{
+	FScopeLock Lock( &CacheLock );
+	return SharedOrder.Num();
+}
+
+bool FBYGRichTextParseCache::LoadCompiledFile( const FString& Filename )
+{
+	TUniquePtr<FArchive> Ar( IFileManager::Get().CreateFileReader( *Filename ) );
+	if ( !Ar )
+	{
+		UE_LOG( LogTemp, Warning, TEXT( "Could not open compiled markup file '%s'" ), *Filename );
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Ar << Magic;
+	*Ar << Version;
+	if ( Magic != CompiledMarkupMagic || Version != ( int32 )EBYGCompiledMarkupVersion::Latest )
+	{
+		UE_LOG( LogTemp, Warning, TEXT( "Compiled markup file '%s' is from a different version, it will be ignored" ), *Filename );
+		return false;
+	}
+
+	FString StylesheetPath;
+	uint32 ParseHash = 0;
+	int32 NumEntries = 0;
+	*Ar << StylesheetPath;
+	*Ar << ParseHash;
+	*Ar << NumEntries;
+
+	FBYGParsedTextMap Loaded;
+	Loaded.Reserve( NumEntries );
+	for ( int32 i = 0; i < NumEntries && !Ar->IsError(); ++i )
+	{
+		FString Text;
+		*Ar << Text;
+		TSharedRef<FBYGParsedText> Parsed = MakeShared<FBYGParsedText>();
+		SerializeParsedText( *Ar, *Parsed );
+		Loaded.Add( Text, Parsed );
+	}
+
+	if ( Ar->IsError() )
+	{
+		UE_LOG( LogTemp, Warning, TEXT( "Compiled markup file '%s' is corrupt, it will be ignored" ), *Filename );
+		return false;
+	}
+
+	// Stale files are harmless: if the stylesheet changed since compiling, the hash won't match
+	// anything at runtime and we fall back to parsing live
+	{
+		FScopeLock Lock( &CacheLock );
+		Entries.FindOrAdd( ParseHash ).Append( Loaded );
+	}
+
+	UE_LOG( LogTemp, Log, TEXT( "Loaded %d compiled markup strings for '%s' from '%s'" ), NumEntries, *StylesheetPath, *Filename );
+	return true;
+}
+
+bool FBYGRichTextParseCache::SaveCompiledFile( const FString& Filename, const FString& StylesheetPath, uint32 ParseHash, const FBYGCompiledMarkupMap& InEntries )
+{
+	TUniquePtr<FArchive> Ar( IFileManager::Get().CreateFileWriter( *Filename ) );
+	if ( !Ar )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Could not write compiled markup file '%s'" ), *Filename );
+		return false;
+	}
+
+	uint32 Magic = CompiledMarkupMagic;
+	int32 Version = ( int32 )EBYGCompiledMarkupVersion::Latest;
+	FString Path = StylesheetPath;
+	int32 NumEntries = InEntries.Num();
+	*Ar << Magic;
+	*Ar << Version;
+	*Ar << Path;
+	*Ar << ParseHash;
+	*Ar << NumEntries;
+
+	for ( const TPair<FString, TSharedRef<FBYGParsedText>>& Pair : InEntries )
+	{
+		FString Text = Pair.Key;
+		*Ar << Text;
+		SerializeParsedText( *Ar, *Pair.Value );
+	}
+
+	return Ar->Close();
+}
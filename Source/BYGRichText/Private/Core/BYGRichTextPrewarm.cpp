@@ -0,0 +1,106 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGRichTextPrewarm.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "UObject/StrongObjectPtr.h"
+
+#include "BYGRichTextRuntimeSettings.h"
+#include "Core/BYGRichTextLayoutPredictor.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Settings/BYGRichTextStylesheet.h"
+
+TFuture<void> FBYGRichTextPrewarm::PrewarmTexts( const UBYGRichTextStylesheet* Stylesheet, const TArray<FText>& Texts, bool bPredictLayout, float WrapWidth, float Scale )
+{
+	check( IsInGameThread() );
+
+	const int32 MaxShared = GetDefault<UBYGRichTextRuntimeSettings>()->MaxSharedParsedTexts;
+	if ( !ensure( Stylesheet ) || Texts.Num() == 0 || ( MaxShared <= 0 && !bPredictLayout ) )
+	{
+		TPromise<void> Done;
+		Done.SetValue();
+		return Done.GetFuture();
+	}
+
+	// Display strings are read here, FText isn't ours to touch on other threads
+	TArray<FString> Strings;
+	Strings.Reserve( Texts.Num() );
+	for ( const FText& Text : Texts )
+	{
+		Strings.Add( Text.ToString() );
+	}
+
+	// Parsed output depends on case, so duplicates are only exact matches
+	Strings.Sort( []( const FString& A, const FString& B ) { return FCString::Strcmp( *A, *B ) < 0; } );
+	for ( int32 i = Strings.Num() - 1; i > 0; --i )
+	{
+		if ( Strings[ i ].Equals( Strings[ i - 1 ], ESearchCase::CaseSensitive ) )
+		{
+			Strings.RemoveAt( i, 1, false );
+		}
+	}
+
+	if ( Strings.Num() > MaxShared )
+	{
+		UE_LOG( LogTemp, Warning, TEXT( "Prewarming %d texts, but only %d are kept. Raise MaxSharedParsedTexts or warm fewer" ), Strings.Num(), MaxShared );
+	}
+
+	// Nothing else has to keep the stylesheet around until the work is done. Made and released on the game thread
+	TStrongObjectPtr<UBYGRichTextStylesheet> KeepAlive( const_cast<UBYGRichTextStylesheet*>( Stylesheet ) );
+	// Counted here rather than in the task, so edits straight after this returns are caught too
+	Stylesheet->NumPrewarmsInFlight.Increment();
+
+	return Async( EAsyncExecution::ThreadPool, [ KeepAlive = MoveTemp( KeepAlive ), Strings = MoveTemp( Strings ), bPredictLayout, WrapWidth, Scale ]() mutable
+	{
+		const UBYGRichTextStylesheet* Stylesheet = KeepAlive.Get();
+		ParallelFor( Strings.Num(), [ & ]( int32 Index )
+		{
+			const FString& Markup = Strings[ Index ];
+			// Parses and shares the output on the way
+			if ( bPredictLayout )
+			{
+				FBYGRichTextLayoutPredictor::Predict( Markup, Stylesheet, WrapWidth, Scale );
+				return;
+			}
+
+			// Same element name as UBYGRichTextBlock, so widgets find it
+			TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+			const uint32 ParseHash = Parser->GetParseHash();
+			if ( !FBYGRichTextParseCache::Get().Find( ParseHash, Markup ).IsValid() )
+			{
+				FBYGRichTextParseCache::Get().AddShared( ParseHash, Markup, Parser->ParseFully( Markup ) );
+			}
+		} );
+		// Before the future is ready, so it can be edited as soon as Wait returns
+		Stylesheet->NumPrewarmsInFlight.Decrement();
+
+		AsyncTask( ENamedThreads::GameThread, [ KeepAlive = MoveTemp( KeepAlive ) ]()
+		{
+		} );
+	} );
+}
+
+TFuture<void> FBYGRichTextPrewarm::PrewarmStringTables( const UBYGRichTextStylesheet* Stylesheet, const TArray<FName>& TableIds, bool bPredictLayout, float WrapWidth, float Scale )
+{
+	TArray<FText> Texts;
+	for ( const FName& TableId : TableIds )
+	{
+		FStringTableConstPtr StringTable = FStringTableRegistry::Get().FindStringTable( TableId );
+		if ( !StringTable.IsValid() )
+		{
+			UE_LOG( LogTemp, Warning, TEXT( "Can't prewarm string table '%s', it isn't loaded" ), *TableId.ToString() );
+			continue;
+		}
+
+		StringTable->EnumerateSourceStrings( [ & ]( const FString& Key, const FString& SourceString )
+		{
+			Texts.Add( FText::FromStringTable( TableId, Key ) );
+			return true;
+		} );
+	}
+	return PrewarmTexts( Stylesheet, Texts, bPredictLayout, WrapWidth, Scale );
+}
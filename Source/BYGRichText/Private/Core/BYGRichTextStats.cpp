@@ -0,0 +1,62 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGRichTextStats.h"
+
+void FBYGRichTextBlockStats::ResetBlocks( int32 NumBlocks )
+{
+	BlockRuns.Reset( NumBlocks );
+	BlockRuns.AddDefaulted( NumBlocks );
+}
+
+void FBYGRichTextBlockStats::ClearBlock( int32 BlockIndex )
+{
+	if ( BlockRuns.IsValidIndex( BlockIndex ) )
+	{
+		BlockRuns[ BlockIndex ] = FBlockRuns();
+	}
+}
+
+void FBYGRichTextBlockStats::AddRun( int32 BlockIndex, EBYGRunType Type )
+{
+	if ( BlockRuns.IsValidIndex( BlockIndex ) )
+	{
+		++BlockRuns[ BlockIndex ].Counts[ ( int32 )Type ];
+	}
+}
+
+int32 FBYGRichTextBlockStats::GetNumRuns( EBYGRunType Type ) const
+{
+	int32 Total = 0;
+	for ( const FBlockRuns& Runs : BlockRuns )
+	{
+		Total += Runs.Counts[ ( int32 )Type ];
+	}
+	return Total;
+}
+
+void FBYGRichTextBlockStats::AddRebuild( double StartTime, double Duration )
+{
+	++NumRebuilds;
+	TotalRebuildSeconds += Duration;
+
+	if ( RecentRebuilds.Num() >= MaxRecentRebuilds )
+	{
+		RecentRebuilds.PopFirst();
+	}
+	RecentRebuilds.Add( TPair<double, double>( StartTime, Duration ) );
+}
+
+void FBYGRichTextBlockStats::GetRebuildsSince( double Time, int32& OutCount, double& OutSeconds ) const
+{
+	OutCount = 0;
+	OutSeconds = 0.0;
+	for ( int32 i = 0; i < RecentRebuilds.Num(); ++i )
+	{
+		const TPair<double, double>& Rebuild = RecentRebuilds[ i ];
+		if ( Rebuild.Key >= Time )
+		{
+			++OutCount;
+			OutSeconds += Rebuild.Value;
+		}
+	}
+}
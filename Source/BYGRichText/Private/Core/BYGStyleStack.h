@@ -14,17 +14,18 @@ public:
 		return StyleStackNames;
 	}
 
-	TArray<const UBYGRichTextPropertyBase*> GetHeadProperties() const
+	// Filled into the same array every time, so flushing a token doesn't allocate
+	const TArray<const UBYGRichTextPropertyBase*>& GetHeadProperties() const
 	{
-		TArray<const UBYGRichTextPropertyBase*> Props;
+		HeadProperties.Reset();
 		for ( auto& Pair : PropertiesStack )
 		{
 			if ( Pair.Value.Num() > 0 )
 			{
-				Props.Add( Pair.Value.Top() );
+				HeadProperties.Add( Pair.Value.Top() );
 			}
 		}
-		return Props;
+		return HeadProperties;
 	}
 
 	const UBYGRichTextStyle* GetHeadStyle() const
@@ -80,14 +81,14 @@ public:
 				{
 					if ( ensure( Props->Top() == Prop ) )
 					{
-						Props->Pop();
+						Props->Pop( false );
 					}
 				}
 			}
 		}
 
-		StyleStack.Pop();
-		StyleStackNames.Pop();
+		StyleStack.Pop( false );
+		StyleStackNames.Pop( false );
 	}
 
 protected:
@@ -95,5 +96,7 @@ protected:
 
 	TArray<const UBYGRichTextStyle*> StyleStack;
 	TArray<FName> StyleStackNames;
+
+	mutable TArray<const UBYGRichTextPropertyBase*> HeadProperties;
 };
 
@@ -0,0 +1,120 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGTextMeasure.h"
+
+#include "Fonts/FontCache.h"
+#include "Fonts/FontMeasure.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Misc/ScopeLock.h"
+#include "Rendering/SlateRenderer.h"
+
+namespace
+{
+	// Measuring only reads glyph metrics from FreeType, nothing is ever rasterized into an atlas
+	class FBYGNullFontAtlas : public FSlateFontAtlas
+	{
+	public:
+		FBYGNullFontAtlas( bool bInIsGrayscale )
+			: FSlateFontAtlas( 1, 1, bInIsGrayscale )
+		{
+		}
+
+		virtual FSlateShaderResource* GetSlateResource() const override { return nullptr; }
+		virtual void ConditionalUpdateTexture() override {}
+		virtual void ReleaseResources() override {}
+	};
+
+	class FBYGNullFontAtlasFactory : public ISlateFontAtlasFactory
+	{
+	public:
+		virtual FIntPoint GetAtlasSize( const bool InIsGrayscale ) const override { return FIntPoint( 1, 1 ); }
+
+		virtual TSharedRef<FSlateFontAtlas> CreateFontAtlas( const bool InIsGrayscale ) const override
+		{
+			ensureMsgf( false, TEXT( "Headless text measure should never need a font atlas" ) );
+			return MakeShared<FBYGNullFontAtlas>( InIsGrayscale );
+		}
+
+		virtual TSharedPtr<ISlateFontTexture> CreateNonAtlasedTexture( const uint32 InWidth, const uint32 InHeight, const bool InIsGrayscale, const TArray<uint8>& InRawData ) const override
+		{
+			return nullptr;
+		}
+	};
+
+	class FBYGSlateTextMeasure : public IBYGTextMeasure
+	{
+	public:
+		FBYGSlateTextMeasure( const TSharedRef<FSlateFontMeasure>& InFontMeasure, FCriticalSection* InLock = nullptr )
+			: FontMeasure( InFontMeasure )
+			, Lock( InLock ? InLock : &OwnLock )
+		{
+		}
+
+		virtual FVector2D Measure( const FString& Text, int32 BeginIndex, int32 EndIndex, const FSlateFontInfo& Font, float Scale ) const override
+		{
+			FScopeLock ScopeLock( Lock );
+			return FontMeasure->Measure( Text, BeginIndex, EndIndex, Font, false, Scale );
+		}
+
+		virtual int16 GetBaseline( const FSlateFontInfo& Font, float Scale ) const override
+		{
+			FScopeLock ScopeLock( Lock );
+			return FontMeasure->GetBaseline( Font, Scale );
+		}
+
+		virtual uint16 GetMaxCharacterHeight( const FSlateFontInfo& Font, float Scale ) const override
+		{
+			FScopeLock ScopeLock( Lock );
+			return FontMeasure->GetMaxCharacterHeight( Font, Scale );
+		}
+
+		bool Wraps( const TSharedRef<FSlateFontMeasure>& InFontMeasure ) const { return FontMeasure == InFontMeasure; }
+
+	protected:
+		TSharedRef<FSlateFontMeasure> FontMeasure;
+		// The headless measure shares its lock with the font cache, the renderer's measure is only used on the game thread
+		FCriticalSection OwnLock;
+		FCriticalSection* Lock = nullptr;
+	};
+
+	FCriticalSection HeadlessLock;
+	TSharedPtr<FSlateFontCache> HeadlessFontCache;
+	TSharedPtr<IBYGTextMeasure> HeadlessTextMeasure;
+	// Game thread only
+	TSharedPtr<FBYGSlateTextMeasure> RendererTextMeasure;
+}
+
+TSharedRef<IBYGTextMeasure> FBYGTextMeasure::Get()
+{
+	if ( IsInGameThread() && FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer() )
+	{
+		// Only wrapped again if the renderer has been recreated since
+		const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+		if ( !RendererTextMeasure.IsValid() || !RendererTextMeasure->Wraps( FontMeasure ) )
+		{
+			RendererTextMeasure = MakeShared<FBYGSlateTextMeasure>( FontMeasure );
+		}
+		return RendererTextMeasure.ToSharedRef();
+	}
+	return GetHeadless();
+}
+
+TSharedRef<IBYGTextMeasure> FBYGTextMeasure::GetHeadless()
+{
+	FScopeLock ScopeLock( &HeadlessLock );
+	if ( !HeadlessTextMeasure.IsValid() )
+	{
+		HeadlessFontCache = MakeShared<FSlateFontCache>( MakeShared<FBYGNullFontAtlasFactory>(), ESlateTextureAtlasThreadId::Game );
+		HeadlessTextMeasure = MakeShared<FBYGSlateTextMeasure>( FSlateFontMeasure::Create( HeadlessFontCache.ToSharedRef() ), &HeadlessLock );
+	}
+	return HeadlessTextMeasure.ToSharedRef();
+}
+
+void FBYGTextMeasure::Shutdown()
+{
+	RendererTextMeasure.Reset();
+
+	FScopeLock ScopeLock( &HeadlessLock );
+	HeadlessTextMeasure.Reset();
+	HeadlessFontCache.Reset();
+}
@@ -0,0 +1,301 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Core/BYGTextRun.h"
+
+#include "Framework/Text/ILayoutBlock.h"
+#include "Framework/Text/RunUtils.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/SlateBrush.h"
+
+void FBYGRevealState::ResetBlocks( int32 NumBlocks )
+{
+	BlockLengths.Reset( NumBlocks );
+	BlockLengths.AddZeroed( NumBlocks );
+}
+
+void FBYGRevealState::ExtendBlock( int32 BlockIndex, int32 LocalEnd )
+{
+	if ( BlockLengths.IsValidIndex( BlockIndex ) )
+	{
+		BlockLengths[ BlockIndex ] = FMath::Max( BlockLengths[ BlockIndex ], LocalEnd );
+	}
+}
+
+void FBYGRevealState::ClearBlock( int32 BlockIndex )
+{
+	if ( BlockLengths.IsValidIndex( BlockIndex ) )
+	{
+		BlockLengths[ BlockIndex ] = 0;
+	}
+}
+
+int32 FBYGRevealState::GetBlockStart( int32 BlockIndex ) const
+{
+	int32 Start = 0;
+	for ( int32 i = 0; i < BlockIndex && i < BlockLengths.Num(); ++i )
+	{
+		Start += BlockLengths[ i ];
+	}
+	return Start;
+}
+
+int32 FBYGRevealState::GetBlockLength( int32 BlockIndex ) const
+{
+	return BlockLengths.IsValidIndex( BlockIndex ) ? BlockLengths[ BlockIndex ] : 0;
+}
+
+int32 FBYGRevealState::GetTotalCount() const
+{
+	return GetBlockStart( BlockLengths.Num() );
+}
+
+void FBYGRevealState::SetRevealedCount( int32 Count )
+{
+	RevealedCount = Count < 0 ? INDEX_NONE : Count;
+	RevealedFraction = -1.0f;
+}
+
+void FBYGRevealState::SetRevealedFraction( float Fraction )
+{
+	RevealedCount = INDEX_NONE;
+	RevealedFraction = Fraction < 0.0f ? -1.0f : FMath::Min( Fraction, 1.0f );
+}
+
+int32 FBYGRevealState::GetRevealedCount() const
+{
+	if ( RevealedFraction >= 0.0f )
+	{
+		return FMath::FloorToInt( RevealedFraction * GetTotalCount() );
+	}
+	return RevealedCount == INDEX_NONE ? MAX_int32 : RevealedCount;
+}
+
+
+int32 FBYGRunRevealInfo::GetVisibleCount( int32 RunBeginIndex, int32 RangeBegin, int32 RangeEnd ) const
+{
+	const int32 RangeLen = RangeEnd - RangeBegin;
+	if ( !RevealState.IsValid() || RevealState->IsRevealingAll() )
+		return RangeLen;
+
+	const int32 GlobalBegin = RevealState->GetBlockStart( BlockIndex ) + LocalOffset + ( RangeBegin - RunBeginIndex );
+	return FMath::Clamp( RevealState->GetRevealedCount() - GlobalBegin, 0, RangeLen );
+}
+
+
+void FBYGRunHitTestIndex::Reset( const FGeometry& InPaintGeometry )
+{
+	Entries.Reset();
+	PaintGeometry = InPaintGeometry;
+}
+
+void FBYGRunHitTestIndex::AddRun( const FGeometry& RunGeometry, const FVector2D& Offset, const FVector2D& Size, const TSharedRef<const FBYGRunInteraction>& Interaction )
+{
+	const FVector2D TopLeft = PaintGeometry.AbsoluteToLocal( RunGeometry.LocalToAbsolute( Offset ) );
+	const FVector2D BottomRight = PaintGeometry.AbsoluteToLocal( RunGeometry.LocalToAbsolute( Offset + Size ) );
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Rect = FSlateRect( TopLeft, BottomRight );
+	Entry.Interaction = Interaction;
+}
+
+TSharedPtr<const FBYGRunInteraction> FBYGRunHitTestIndex::FindRun( const FGeometry& WidgetGeometry, const FVector2D& ScreenPosition ) const
+{
+	const FVector2D LocalPosition = WidgetGeometry.AbsoluteToLocal( ScreenPosition );
+	for ( const FEntry& Entry : Entries )
+	{
+		if ( Entry.Rect.ContainsPoint( LocalPosition ) )
+		{
+			return Entry.Interaction;
+		}
+	}
+	return nullptr;
+}
+
+
+void FBYGRunBrushInfo::GetBrushRect( const FVector2D& BoxSize, FVector2D& OutOffset, FVector2D& OutSize ) const
+{
+	// Fill takes the padded space, anything else uses the image size
+	const FVector2D Available = BoxSize - Padding.GetDesiredSize();
+	OutSize = Brush ? Brush->ImageSize : FVector2D::ZeroVector;
+	OutOffset = FVector2D( Padding.Left, Padding.Top );
+	switch ( HAlign )
+	{
+	case HAlign_Fill: OutSize.X = Available.X; break;
+	case HAlign_Center: OutOffset.X += ( Available.X - OutSize.X ) * 0.5f; break;
+	case HAlign_Right: OutOffset.X += Available.X - OutSize.X; break;
+	default: break;
+	}
+	switch ( VAlign )
+	{
+	case VAlign_Fill: OutSize.Y = Available.Y; break;
+	case VAlign_Center: OutOffset.Y += ( Available.Y - OutSize.Y ) * 0.5f; break;
+	case VAlign_Bottom: OutOffset.Y += Available.Y - OutSize.Y; break;
+	default: break;
+	}
+}
+
+
+TSharedRef<FBYGTextRun> FBYGTextRun::Create( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FTextBlockStyle& Style, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo, const TArray<FBYGRunBrushInfo>& InBrushes, const TSharedPtr<const FBYGRunInteraction>& InInteraction, const TSharedPtr<FBYGRunHitTestIndex>& InHitTestIndex )
+{
+	return MakeShareable( new FBYGTextRun( InRunInfo, InText, Style, InRange, InRevealInfo, InBrushes, InInteraction, InHitTestIndex ) );
+}
+
+FBYGTextRun::FBYGTextRun( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FTextBlockStyle& InStyle, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo, const TArray<FBYGRunBrushInfo>& InBrushes, const TSharedPtr<const FBYGRunInteraction>& InInteraction, const TSharedPtr<FBYGRunHitTestIndex>& InHitTestIndex )
+	: FSlateTextRun( InRunInfo, InText, InStyle, InRange )
+	, RevealInfo( InRevealInfo )
+	, Brushes( InBrushes )
+	, Interaction( InInteraction )
+	, HitTestIndex( InHitTestIndex )
+{
+}
+
+FVector2D FBYGTextRun::GetBrushMinSize( float Scale ) const
+{
+	FVector2D MinSize = FVector2D::ZeroVector;
+	for ( const FBYGRunBrushInfo& BrushInfo : Brushes )
+	{
+		if ( BrushInfo.bSizeToBrush && BrushInfo.Brush )
+		{
+			MinSize = FVector2D::Max( MinSize, ( BrushInfo.Brush->ImageSize + BrushInfo.Padding.GetDesiredSize() ) * Scale );
+		}
+	}
+	return MinSize;
+}
+
+FVector2D FBYGTextRun::Measure( int32 StartIndex, int32 EndIndex, float Scale, const FRunTextContext& TextContext ) const
+{
+	FVector2D Size = FSlateTextRun::Measure( StartIndex, EndIndex, Scale, TextContext );
+	// Only the whole run is sized to the brush, partial measurements are for finding wrap points
+	if ( StartIndex == Range.BeginIndex && EndIndex == Range.EndIndex )
+	{
+		Size = FVector2D::Max( Size, GetBrushMinSize( Scale ) );
+	}
+	return Size;
+}
+
+int16 FBYGTextRun::GetMaxHeight( float Scale ) const
+{
+	const int16 TextHeight = FSlateTextRun::GetMaxHeight( Scale );
+	const int16 BrushHeight = ( int16 )FMath::CeilToInt( GetBrushMinSize( Scale ).Y );
+	return FMath::Max( TextHeight, BrushHeight );
+}
+
+int16 FBYGTextRun::GetBaseLine( float Scale ) const
+{
+	// Baseline is negative, grow it downwards by half of any extra height the brush needs so the text stays centred
+	const int16 TextHeight = FSlateTextRun::GetMaxHeight( Scale );
+	const int16 Extra = GetMaxHeight( Scale ) - TextHeight;
+	return FSlateTextRun::GetBaseLine( Scale ) - Extra / 2;
+}
+
+int32 FBYGTextRun::PaintBrushes( const TSharedRef<ILayoutBlock>& Block, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const
+{
+	if ( Brushes.Num() == 0 )
+		return LayerId;
+
+	const float InverseScale = Inverse( AllottedGeometry.Scale );
+	const FVector2D BlockOffset = TransformPoint( InverseScale, Block->GetLocationOffset() );
+	const FVector2D BlockSize = TransformVector( InverseScale, Block->GetSize() );
+	const ESlateDrawEffect DrawEffects = bParentEnabled ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+
+	for ( const FBYGRunBrushInfo& BrushInfo : Brushes )
+	{
+		if ( !BrushInfo.Brush || BrushInfo.Brush->DrawAs == ESlateBrushDrawType::NoDrawType )
+			continue;
+
+		FVector2D Offset;
+		FVector2D Size;
+		BrushInfo.GetBrushRect( BlockSize, Offset, Size );
+		Offset += BlockOffset;
+
+		FSlateDrawElement::MakeBox(
+			OutDrawElements,
+			LayerId,
+			AllottedGeometry.ToPaintGeometry( Size, FSlateLayoutTransform( Offset ) ),
+			BrushInfo.Brush,
+			DrawEffects,
+			InWidgetStyle.GetColorAndOpacityTint() * BrushInfo.Brush->GetTint( InWidgetStyle ) );
+	}
+
+	return LayerId + 1;
+}
+
+int32 FBYGTextRun::OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const
+{
+	const FTextRange BlockRange = Block->GetTextRange();
+	const int32 VisibleCount = RevealInfo.GetVisibleCount( Range.BeginIndex, BlockRange.BeginIndex, BlockRange.EndIndex );
+	if ( VisibleCount <= 0 )
+		return LayerId;
+
+	// Hidden runs can't be hovered, so this comes after the reveal check
+	if ( Interaction.IsValid() && HitTestIndex.IsValid() )
+	{
+		const float InverseScale = Inverse( AllottedGeometry.Scale );
+		HitTestIndex->AddRun( AllottedGeometry, TransformPoint( InverseScale, Block->GetLocationOffset() ), TransformVector( InverseScale, Block->GetSize() ), Interaction.ToSharedRef() );
+	}
+
+	// Brushes are behind the text and all or nothing, like widget runs
+	LayerId = PaintBrushes( Block, AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled );
+
+	if ( VisibleCount >= BlockRange.Len() )
+	{
+		return FSlateTextRun::OnPaint( Args, Line, Block, DefaultStyle, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled );
+	}
+
+	// Layout stays the same as when fully revealed, we just clip off the glyphs that aren't visible yet
+	const float LayoutScale = AllottedGeometry.Scale;
+	const float VisibleWidth = Measure( BlockRange.BeginIndex, BlockRange.BeginIndex + VisibleCount, LayoutScale, FRunTextContext() ).X;
+
+	const float InverseScale = Inverse( AllottedGeometry.Scale );
+	const FVector2D ClipOffset = TransformPoint( InverseScale, Block->GetLocationOffset() );
+	const FVector2D ClipSize = TransformVector( InverseScale, FVector2D( VisibleWidth, Block->GetSize().Y ) );
+
+	OutDrawElements.PushClip( FSlateClippingZone( AllottedGeometry.ToPaintGeometry( ClipSize, FSlateLayoutTransform( ClipOffset ) ) ) );
+	const int32 OutLayerId = FSlateTextRun::OnPaint( Args, Line, Block, DefaultStyle, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled );
+	OutDrawElements.PopClip();
+
+	return OutLayerId;
+}
+
+
+TSharedRef<FBYGWidgetRun> FBYGWidgetRun::Create( const TSharedRef<FTextLayout>& TextLayout, const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FWidgetRunInfo& InWidgetInfo, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo )
+{
+	return MakeShareable( new FBYGWidgetRun( TextLayout, InRunInfo, InText, InWidgetInfo, InRange, InRevealInfo ) );
+}
+
+FBYGWidgetRun::FBYGWidgetRun( const TSharedRef<FTextLayout>& TextLayout, const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FWidgetRunInfo& InWidgetInfo, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo )
+	: FSlateWidgetRun( TextLayout, InRunInfo, InText, InWidgetInfo, InRange )
+	, RevealInfo( InRevealInfo )
+{
+}
+
+int32 FBYGWidgetRun::OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const
+{
+	// Widgets are all or nothing, and not painting them also keeps them out of hit-testing
+	const FTextRange BlockRange = Block->GetTextRange();
+	if ( RevealInfo.GetVisibleCount( Range.BeginIndex, BlockRange.BeginIndex, BlockRange.EndIndex ) <= 0 )
+		return LayerId;
+
+	return FSlateWidgetRun::OnPaint( Args, Line, Block, DefaultStyle, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled );
+}
+
+
+TSharedRef<FBYGImageRun> FBYGImageRun::Create( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FSlateBrush* InImage, int16 InBaseline, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo )
+{
+	return MakeShareable( new FBYGImageRun( InRunInfo, InText, InImage, InBaseline, InRange, InRevealInfo ) );
+}
+
+FBYGImageRun::FBYGImageRun( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FSlateBrush* InImage, int16 InBaseline, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo )
+	: FSlateImageRun( InRunInfo, InText, InImage, InBaseline, InRange )
+	, RevealInfo( InRevealInfo )
+{
+}
+
+int32 FBYGImageRun::OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const
+{
+	const FTextRange BlockRange = Block->GetTextRange();
+	if ( RevealInfo.GetVisibleCount( Range.BeginIndex, BlockRange.BeginIndex, BlockRange.EndIndex ) <= 0 )
+		return LayerId;
+
+	return FSlateImageRun::OnPaint( Args, Line, Block, DefaultStyle, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled );
+}
@@ -3,27 +3,142 @@
 #pragma once
 
 #include "Settings/BYGRichTextProperty.h"
+#include "Settings/BYGRichTextStylesheet.h"
 #include "Widget/BYGRichTextBlock.h"
 
-UWidget* UBYGRichTextTooltipProperty::CreateTooltip( UBYGRichTextBlock* OuterBlock )
+const FVector2D UBYGRichTextInlineBrushProperty::FolderIconSize = FVector2D( 20, 20 );
+
+UWidget* UBYGRichTextTooltipProperty::CreateTooltip( UBYGRichTextBlock* OuterBlock, const FBYGStyleTagData& Data ) const
 {
-	UWidget* Widget = nullptr;
+	UUserWidget* Widget = nullptr;
 	if ( UserWidgetClass && OuterBlock )
 	{
-		Widget = Cast<UUserWidget>( UUserWidget::CreateWidgetInstance( *OuterBlock, UserWidgetClass, "Tooltip" ) );
+		UWorld* World = OuterBlock->GetWorld();
+		if ( World )
+		{
+			FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+			Widget = RichTextModule.AcquireTooltipWidget( World, UserWidgetClass );
+		}
+		else
+		{
+			// e.g. the editor preview, which has nowhere to pool them
+			Widget = Cast<UUserWidget>( UUserWidget::CreateWidgetInstance( *OuterBlock, UserWidgetClass, "Tooltip" ) );
+		}
 	}
 
+	// Pooled widgets are initialized again every time, with the payload of the block they're shown for
 	if ( Widget 
 		&& UKismetSystemLibrary::DoesImplementInterface( Widget, UBYGInlineTextTooltip::StaticClass() ) )
 	{
 		IBYGInlineTextTooltip* TooltipWidget = Cast<IBYGInlineTextTooltip>( Widget );
-		FBYGStyleTagData Data;
 		TooltipWidget->InitializeTooltip( Data );
 	}
 
 	return Widget;
 }
 
+void UBYGRichTextTooltipProperty::ReleaseTooltip( UWidget* Widget ) const
+{
+	UUserWidget* UserWidget = Cast<UUserWidget>( Widget );
+	if ( UserWidget && UserWidget->GetWorld() )
+	{
+		FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+		RichTextModule.ReleaseTooltipWidget( UserWidget );
+	}
+}
+
+FBYGDelegateToolTip::FBYGDelegateToolTip( const UBYGRichTextTooltipProperty* InProperty, UBYGRichTextBlock* InOuterBlock, const TMap<FString, FString>& Payload )
+	: Property( InProperty )
+	, OuterBlock( InOuterBlock )
+{
+	Data.Pairs = Payload;
+}
+
+FBYGDelegateToolTip::FBYGDelegateToolTip( const UBYGRichTextTooltipProperty* InProperty, UBYGRichTextBlock* InOuterBlock, const FBYGStyleTagData& InData )
+	: Property( InProperty )
+	, OuterBlock( InOuterBlock )
+	, Data( InData )
+{
+}
+
+void FBYGDelegateToolTip::SetRun( const UBYGRichTextTooltipProperty* InProperty, const FBYGStyleTagData& InData )
+{
+	ReleaseContent();
+	Property = InProperty;
+	Data = InData;
+	if ( bIsOpen && Container.IsValid() )
+	{
+		Container->SetContent( GetContentWidget() );
+	}
+}
+
+TSharedRef<SWidget> FBYGDelegateToolTip::AsWidget()
+{
+	if ( !Container.IsValid() )
+	{
+		Container = SNew( SBox );
+	}
+	Container->SetContent( GetContentWidget() );
+	return Container.ToSharedRef();
+}
+
+TSharedRef<SWidget> FBYGDelegateToolTip::GetContentWidget()
+{
+	if ( CachedToolTip.IsValid() )
+	{
+		return CachedToolTip.ToSharedRef();
+	}
+
+	UWidget* Widget = Property.IsValid() ? Property->CreateTooltip( OuterBlock.Get(), Data ) : nullptr;
+	if ( Widget )
+	{
+		ContentWidget = Widget;
+		CachedToolTip = Widget->TakeWidget();
+		return CachedToolTip.ToSharedRef();
+	}
+
+	return SNullWidget::NullWidget;
+}
+
+bool FBYGDelegateToolTip::IsEmpty() const
+{
+	return !Property.IsValid() || !Property->UserWidgetClass;
+}
+
+void FBYGDelegateToolTip::OnClosed()
+{
+	bIsOpen = false;
+	if ( Container.IsValid() )
+	{
+		Container->SetContent( SNullWidget::NullWidget );
+	}
+	ReleaseContent();
+}
+
+void FBYGDelegateToolTip::ReleaseContent()
+{
+	CachedToolTip.Reset();
+	if ( ContentWidget.IsValid() && Property.IsValid() )
+	{
+		Property->ReleaseTooltip( ContentWidget.Get() );
+	}
+	ContentWidget.Reset();
+}
+
+void UBYGRichTextPropertyBase::SetOwner( const UBYGRichTextStylesheet* InStylesheet, const FName& InStyleID ) const
+{
+	OwningStylesheet = InStylesheet;
+	OwningStyleID = InStyleID;
+}
+
+void UBYGRichTextPropertyBase::NotifyValueChanged()
+{
+	if ( const UBYGRichTextStylesheet* Stylesheet = OwningStylesheet.Get() )
+	{
+		Stylesheet->NotifyPropertyChanged( this, OwningStyleID );
+	}
+}
+
 void UBYGRichTextPropertyBase::BeginDestroy()
 {
 	UE_LOG( LogTemp, Warning, TEXT( "RichTextProperty %s is being destroyed!" ), *GetName() );
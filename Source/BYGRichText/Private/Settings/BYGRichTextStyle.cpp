@@ -1,6 +1,7 @@
 // Copyright Brace Yourself Games. All Rights Reserved.
 
 #include "Settings/BYGRichTextStyle.h"
+#include "Settings/BYGRichTextStylesheet.h"
 #include <Internationalization/Regex.h>
 
 #define LOCTEXT_NAMESPACE "BYGRichTextModule"
@@ -25,6 +26,15 @@ void UBYGRichTextStyle::PostLoad()
 void UBYGRichTextStyle::AddProperty( UBYGRichTextPropertyBase* Property )
 {
 	Properties.Add( Property );
+	NotifyChanged();
+}
+
+void UBYGRichTextStyle::NotifyChanged()
+{
+	if ( UBYGRichTextStylesheet* Stylesheet = OwningStylesheet.Get() )
+	{
+		Stylesheet->NotifyStyleChanged();
+	}
 }
 
 void UBYGRichTextStyle::SortProperties()
@@ -2,6 +2,7 @@
 
 #include "Settings/BYGRichTextStylesheet.h"
 #include "Settings/BYGRichTextStyle.h"
+#include "Core/BYGRichTextLayoutCache.h"
 
 #include <Widgets/SBoxPanel.h>
 #include <Widgets/Text/SRichTextBlock.h>
@@ -30,13 +31,19 @@ UBYGRichTextStylesheet::UBYGRichTextStylesheet( const FObjectInitializer& Object
 		}
 	}
 	ensureMsgf( DefaultProperties.Num() > 0, TEXT( "We should have found properties to instantiate" ) );
+	// Class iteration order isn't stable, parser output lists the defaults in this order
+	DefaultProperties.Sort( []( const UBYGRichTextPropertyBase& A, const UBYGRichTextPropertyBase& B )
+	{
+		return A.GetTypeID().LexicalLess( B.GetTypeID() );
+	} );
 
 	RebuildLookup();
 }
 
 UBYGRichTextStyle* UBYGRichTextStylesheet::FindStyle( TCHAR const* Input, int32 CurrentIndex, TOptional<EBYGStyleDisplayType> DisplayType ) const
 {
-	TArray<UBYGRichTextStyle*> Candidates;
+	// Called for every shortcut character the parser comes across, so keep it off the heap
+	TArray<UBYGRichTextStyle*, TInlineAllocator<16>> Candidates;
 	for ( UBYGRichTextStyle* Style : Styles )
 	{
 		if ( !Style ) continue; // TODO: remove after we use custom editor?
@@ -49,8 +56,11 @@ UBYGRichTextStyle* UBYGRichTextStylesheet::FindStyle( TCHAR const* Input, int32
 	}
 
 	int32 CurrentOffset = 0;
-	while ( Candidates.Num() >= 1 && Input[ CurrentIndex ] != 0 )
+	bool bAnyLonger = true;
+	while ( Candidates.Num() >= 1 && Input[ CurrentIndex ] != 0 && bAnyLonger )
 	{
+		// Once every candidate has matched in full, reading further can't rule any out
+		bAnyLonger = false;
 		for ( int32 i = Candidates.Num() - 1; i >= 0; --i )
 		{
 			if ( Candidates[i]->HasShortcut() )
@@ -59,9 +69,10 @@ UBYGRichTextStyle* UBYGRichTextStylesheet::FindStyle( TCHAR const* Input, int32
 				{
 					if ( Candidates[ i ]->GetShortcut()[ CurrentOffset ] != Input[ CurrentIndex ] )
 					{
-						Candidates.RemoveAt( i );
+						Candidates.RemoveAt( i, 1, false );
 						continue;
 					}
+					bAnyLonger = bAnyLonger || Candidates[ i ]->GetShortcut().IsValidIndex( CurrentOffset + 1 );
 				}
 			}
 		}
@@ -159,7 +170,7 @@ void UBYGRichTextStylesheet::PostEditChangeProperty( struct FPropertyChangedEven
 	Super::PostEditChangeProperty( PropertyChangedEvent );
 	RebuildLookup();
 
-	OnStylesheetPropertiesChangedDelegate.Broadcast();
+	BroadcastChange( MakeChangeForEvent( PropertyChangedEvent ) );
 }
 
 void UBYGRichTextStylesheet::PostEditChangeChainProperty( struct FPropertyChangedChainEvent& PropertyChangedEvent )
@@ -167,7 +178,95 @@ void UBYGRichTextStylesheet::PostEditChangeChainProperty( struct FPropertyChange
 	Super::PostEditChangeChainProperty( PropertyChangedEvent );
 	RebuildLookup();
 
-	OnStylesheetPropertiesChangedDelegate.Broadcast();
+	BroadcastChange( MakeChangeForEvent( PropertyChangedEvent ) );
+}
+#endif
+
+void UBYGRichTextStylesheet::CheckNotPrewarming() const
+{
+	// Prewarm tasks read property values and inline IDs without locking, see FBYGRichTextPrewarm
+	checkf( !IsPrewarming(), TEXT( "Stylesheet %s was edited while it was being prewarmed. Wait for the prewarm future first" ), *GetName() );
+}
+
+void UBYGRichTextStylesheet::BroadcastChange( const FBYGStylesheetChange& Change ) const
+{
+	CheckNotPrewarming();
+	FBYGRichTextLayoutCache::Get().Empty();
+
+	// Only what was edited needs resolving again
+	{
+		FWriteScopeLock Lock( LookupLock );
+		if ( Change.bStructural )
+		{
+			PropertySlots.TouchAll();
+			StyleSlots.TouchAll();
+		}
+		for ( const FName& StyleID : Change.StyleIDs )
+		{
+			TouchStyle( StyleID );
+		}
+	}
+	OnStylesheetPropertiesChangedDelegate.Broadcast( Change );
+}
+
+void UBYGRichTextStylesheet::NotifyPropertyChanged( const UBYGRichTextPropertyBase* Prop, const FName& StyleID ) const
+{
+	FBYGStylesheetChange Change;
+	Change.PropertyTypeIDs.Add( Prop->GetTypeID() );
+	Change.bRestyleOnly = Prop->AffectsTextStyleOnly();
+	// Default properties are under every style
+	Change.bStructural = StyleID.IsNone();
+	if ( !StyleID.IsNone() )
+	{
+		Change.StyleIDs.Add( StyleID );
+	}
+	BroadcastChange( Change );
+}
+
+void UBYGRichTextStylesheet::NotifyStyleChanged()
+{
+	RebuildLookup();
+	BroadcastChange( FBYGStylesheetChange() );
+}
+
+#if WITH_EDITOR
+FBYGStylesheetChange UBYGRichTextStylesheet::MakeChangeForEvent( const FPropertyChangedEvent& PropertyChangedEvent ) const
+{
+	FBYGStylesheetChange Change;
+
+	// Adding, removing or reordering anything changes what the parser can find
+	if ( PropertyChangedEvent.ChangeType != EPropertyChangeType::ValueSet
+		&& PropertyChangedEvent.ChangeType != EPropertyChangeType::Interactive )
+	{
+		return Change;
+	}
+
+	const FName ChangedName = PropertyChangedEvent.GetPropertyName();
+	if ( ChangedName == NAME_None
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStylesheet, DefaultStyleName )
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStylesheet, Styles )
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStyle, ID )
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStyle, Shortcut )
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStyle, DisplayType )
+		|| ChangedName == GET_MEMBER_NAME_CHECKED( UBYGRichTextStyle, Properties ) )
+	{
+		return Change;
+	}
+
+	const int32 StyleIndex = PropertyChangedEvent.GetArrayIndex( GET_MEMBER_NAME_STRING_CHECKED( UBYGRichTextStylesheet, Styles ) );
+	const int32 PropertyIndex = PropertyChangedEvent.GetArrayIndex( GET_MEMBER_NAME_STRING_CHECKED( UBYGRichTextStyle, Properties ) );
+	if ( !Styles.IsValidIndex( StyleIndex ) || !Styles[ StyleIndex ]
+		|| !Styles[ StyleIndex ]->Properties.IsValidIndex( PropertyIndex ) || !Styles[ StyleIndex ]->Properties[ PropertyIndex ] )
+	{
+		return Change;
+	}
+
+	const UBYGRichTextPropertyBase* Prop = Styles[ StyleIndex ]->Properties[ PropertyIndex ];
+	Change.bStructural = false;
+	Change.StyleIDs.Add( Styles[ StyleIndex ]->GetID() );
+	Change.PropertyTypeIDs.Add( Prop->GetTypeID() );
+	Change.bRestyleOnly = Prop->AffectsTextStyleOnly();
+	return Change;
 }
 
 void UBYGRichTextStylesheet::Validate( FCompilerResultsLog& ResultsLog ) const
@@ -209,6 +308,22 @@ void UBYGRichTextStylesheet::Validate( FCompilerResultsLog& ResultsLog ) const
 			Message->AddToken( FTextToken::Create( FText::Format( LOCTEXT( "StyleInvalidID", "Style '{StyleName}' has an invalid shortcut" ), Args ) ) );
 			ResultsLog.AddTokenizedMessage( Message );
 		}
+		TSet<FName> PropertyTypeIDs;
+		for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+		{
+			bool bAlreadyInStyle = false;
+			if ( Prop )
+				PropertyTypeIDs.Add( Prop->GetTypeID(), &bAlreadyInStyle );
+			if ( bAlreadyInStyle )
+			{
+				FFormatNamedArguments Args;
+				Args.Add( TEXT( "StyleName" ), FText::FromName( Style->GetID() ) );
+				Args.Add( TEXT( "PropertyType" ), FText::FromName( Prop->GetTypeID() ) );
+				TSharedRef<FTokenizedMessage> Message = FTokenizedMessage::Create( EMessageSeverity::Warning );
+				Message->AddToken( FTextToken::Create( FText::Format( LOCTEXT( "DuplicatePropertyTypes", "Style '{StyleName}' has more than one {PropertyType} property, only the last is used" ), Args ) ) );
+				ResultsLog.AddTokenizedMessage( Message );
+			}
+		}
 		if ( Style->Properties.Num() == 0 )
 		{
 			FFormatNamedArguments Args;
@@ -249,37 +364,129 @@ void UBYGRichTextStylesheet::Validate( FCompilerResultsLog& ResultsLog ) const
 }
 #endif
 
-const UBYGRichTextPropertyBase* UBYGRichTextStylesheet::FindProperty( int32 InlineID ) const
+const UBYGRichTextPropertyBase* UBYGRichTextStylesheet::FindProperty( const FName& InlineID ) const
+{
+	FReadScopeLock Lock( LookupLock );
+	return PropertySlots.Resolve( PropertySlots.Find( InlineID ) );
+}
+
+TSharedRef<const FBYGResolvedRunStyle> UBYGRichTextStylesheet::ResolveRunStyle( const FString& InlineIDs ) const
 {
-	for ( int32 i = 0; i < PropertyLookup.Num(); ++i )
+	FScopeLock Lock( &ResolvedRunStylesLock );
+	// One view of the slots for the whole combination
+	FReadScopeLock LookupReadLock( LookupLock );
+	if ( const TSharedRef<const FBYGResolvedRunStyle>* Existing = ResolvedRunStyles.Find( InlineIDs ) )
 	{
-		ensure( PropertyLookup[ i ] != nullptr );
+		bool bStale = false;
+		for ( const FBYGStylesheetHandle& Handle : ( *Existing )->Handles )
+		{
+			bStale = bStale || !PropertySlots.Resolve( Handle );
+		}
+		if ( !bStale )
+		{
+			return *Existing;
+		}
 	}
 
-	const TWeakObjectPtr<const UBYGRichTextPropertyBase>* Prop = PropertyLookup.Find( InlineID );
-	if ( ensure( Prop != nullptr ) )
-		return Prop->Get();
-	return nullptr;
+	TSharedRef<FBYGResolvedRunStyle> RunStyle = MakeShared<FBYGResolvedRunStyle>();
+	TArray<FString> IDs;
+	InlineIDs.ParseIntoArray( IDs, TEXT( " " ) );
+	for ( const FString& ID : IDs )
+	{
+		const FBYGStylesheetHandle Handle = PropertySlots.Find( FName( *ID ) );
+		const UBYGRichTextPropertyBase* Prop = PropertySlots.Resolve( Handle );
+		if ( Prop )
+		{
+			Prop->ApplyToTextStyle( RunStyle->TextStyle );
+			RunStyle->bRequiresInlineTextBlock = RunStyle->bRequiresInlineTextBlock || Prop->RequiresInlineTextBlock();
+			RunStyle->Properties.Add( Prop );
+			RunStyle->Handles.Add( Handle );
+		}
+		else
+		{
+			UE_LOG( LogTemp, Error, TEXT( "Failed to find property with inline ID %s" ), *ID );
+		}
+	}
+
+	ResolvedRunStyles.Add( InlineIDs, RunStyle );
+	return RunStyle;
 }
 
-void UBYGRichTextStylesheet::RebuildLookup()
+void UBYGRichTextStylesheet::TouchStyle( const FName& StyleID ) const
+{
+	StyleSlots.Touch( StyleID );
+	if ( const UBYGRichTextStyle* Style = FindStyle( StyleID ) )
+	{
+		for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+		{
+			if ( Prop )
+			{
+				PropertySlots.Touch( FName( *Prop->GetInlineID() ) );
+			}
+		}
+	}
+}
+
+uint32 UBYGRichTextStylesheet::GetParseHash() const
 {
-	for ( int32 i = 0; i < PropertyLookup.Num(); ++i )
+	// Each default and style is hashed on its own and the hashes sorted, so the same styles in a different
+	// order hash the same
+	TArray<uint32, TInlineAllocator<32>> Hashes;
+
+	for ( const UBYGRichTextPropertyBase* Prop : DefaultProperties )
+	{
+		if ( Prop )
+		{
+			Hashes.Add( Prop->GetParseHash() );
+		}
+	}
+
+	for ( const UBYGRichTextStyle* Style : Styles )
 	{
-		ensure( PropertyLookup[ i ] != nullptr );
+		if ( !Style )
+			continue;
+		uint32 StyleHash = FCrc::StrCrc32( *Style->GetID().ToString() );
+		StyleHash = HashCombine( StyleHash, FCrc::StrCrc32( *Style->GetShortcut() ) );
+		StyleHash = HashCombine( StyleHash, GetTypeHash( static_cast<uint8>( Style->GetDisplayType() ) ) );
+		for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+		{
+			if ( Prop )
+			{
+				StyleHash = HashCombine( StyleHash, Prop->GetParseHash() );
+			}
+		}
+		Hashes.Add( StyleHash );
 	}
 
+	Hashes.Sort();
+	uint32 Hash = FCrc::StrCrc32( *DefaultStyleName.ToString() );
+	for ( const uint32 Entry : Hashes )
+	{
+		Hash = HashCombine( Hash, Entry );
+	}
+	return Hash;
+}
+
+void UBYGRichTextStylesheet::RebuildLookup()
+{
 	ensure( DefaultProperties.Num() > 0 );
+	CheckNotPrewarming();
 
-	PropertyLookup.Empty();
+	// Released before the resolved run styles are pruned, see LookupLock for the order they're taken in
+	LookupLock.WriteLock();
+
+	// Entries that are still here keep their slot and generation, so handles to them stay valid
+	PropertySlots.BeginUpdate();
+	StyleSlots.BeginUpdate();
 	int32 i = 0;
 
 	for ( const UBYGRichTextPropertyBase* Prop : DefaultProperties )
 	{
 		if ( !Prop )
 			continue;
-		PropertyLookup.Add( i, Prop );
-		Prop->SetInlineID( i );
+		Prop->SetInlineID( i, NAME_None );
+		Prop->SetOwner( this, NAME_None );
+		PropertySlots.Set( FName( *Prop->GetInlineID() ), Prop );
 		i++;
 	}
 
@@ -288,23 +495,64 @@ void UBYGRichTextStylesheet::RebuildLookup()
 		// When adding a new prop in editor (w/o custom editor), it can be null until we pick the class
 		if ( !Style )
 			continue;
+		StyleSlots.Set( Style->GetID(), Style );
+		Style->OwningStylesheet = this;
 		for ( UBYGRichTextPropertyBase* Prop : Style->Properties )
 		{
 			if ( !Prop )
 				continue;
-			PropertyLookup.Add( i, Prop );
-			Prop->SetInlineID( i );
+			Prop->SetInlineID( i, Style->GetID() );
+			Prop->SetOwner( this, Style->GetID() );
 			i++;
 
 #if WITH_EDITOR
-			Prop->OnPropertyPropertyChangedDelegate.BindLambda( [&]()
+			TWeakObjectPtr<UBYGRichTextStylesheet> WeakThis( this );
+			const FName StyleID = Style->GetID();
+			Prop->OnPropertyPropertyChangedDelegate.BindLambda( [WeakThis, StyleID, Prop]()
 			{
-				OnStylesheetPropertiesChangedDelegate.Broadcast();
+				if ( !WeakThis.IsValid() )
+					return;
+
+				// Edits made directly on a property only touch the style that owns it
+				FBYGStylesheetChange Change;
+				Change.bStructural = false;
+				Change.StyleIDs.Add( StyleID );
+				Change.PropertyTypeIDs.Add( Prop->GetTypeID() );
+				Change.bRestyleOnly = Prop->AffectsTextStyleOnly();
+				WeakThis->BroadcastChange( Change );
 			} );
 #endif
 		}
+
+		// The parser only ever uses the last property of each type in a style, see FBYGStyleStack, so that's
+		// the one its ID has to find. Validate warns about the earlier ones
+		for ( int32 PropIndex = Style->Properties.Num() - 1; PropIndex >= 0; --PropIndex )
+		{
+			if ( const UBYGRichTextPropertyBase* Prop = Style->Properties[ PropIndex ] )
+			{
+				PropertySlots.Set( FName( *Prop->GetInlineID() ), Prop );
+			}
+		}
 	}
 
+	PropertySlots.EndUpdate();
+	StyleSlots.EndUpdate();
+	LookupLock.WriteUnlock();
+
+	// Combinations using anything removed or replaced would only be resolved again
+	FScopeLock Lock( &ResolvedRunStylesLock );
+	FReadScopeLock ReadLock( LookupLock );
+	for ( auto It = ResolvedRunStyles.CreateIterator(); It; ++It )
+	{
+		for ( const FBYGStylesheetHandle& Handle : It.Value()->Handles )
+		{
+			if ( !PropertySlots.Resolve( Handle ) )
+			{
+				It.RemoveCurrent();
+				break;
+			}
+		}
+	}
 }
 
 
@@ -355,6 +603,42 @@ void UBYGRichTextStylesheet::PostCDOContruct()
 	//RebuildLookup();
 }
 
+void UBYGRichTextStylesheet::GetResourceSizeEx( FResourceSizeEx& CumulativeResourceSize )
+{
+	Super::GetResourceSizeEx( CumulativeResourceSize );
+
+	SIZE_T Size = Styles.GetAllocatedSize() + DefaultProperties.GetAllocatedSize() + PropertySlots.GetAllocatedSize() + StyleSlots.GetAllocatedSize();
+	Size += ResolvedRunStyles.GetAllocatedSize() + ResolvedRunStyles.Num() * sizeof( FBYGResolvedRunStyle );
+	// Styles and properties are instanced subobjects, their objects are only added for an estimated total
+	for ( const UBYGRichTextStyle* Style : Styles )
+	{
+		if ( Style )
+		{
+			Size += Style->Properties.GetAllocatedSize() + Style->GetShortcut().GetAllocatedSize();
+		}
+	}
+	if ( CumulativeResourceSize.GetResourceSizeMode() == EResourceSizeMode::EstimatedTotal )
+	{
+		for ( const UBYGRichTextStyle* Style : Styles )
+		{
+			if ( Style )
+			{
+				Size += Style->GetClass()->GetStructureSize();
+				for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+				{
+					Size += Prop ? Prop->GetClass()->GetStructureSize() : 0;
+				}
+			}
+		}
+		for ( const UBYGRichTextPropertyBase* Prop : DefaultProperties )
+		{
+			Size += Prop ? Prop->GetClass()->GetStructureSize() : 0;
+		}
+	}
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes( Size );
+}
+
 void UBYGRichTextStylesheet::BeginDestroy()
 {
 	Super::BeginDestroy();
@@ -6,16 +6,25 @@
 #include "Components/RichTextBlockDecorator.h"
 #include "Core/BYGInlineTextFormatDecorator.h"
 #include "Core/BYGRichTextMarkupProcessing.h"
+#include "Settings/BYGRichTextProperty.h"
+#include "Settings/BYGRichTextStylesheet.h"
+#include "Settings/BYGRichTextStyle.h"
 #include "Framework/Text/RichTextLayoutMarshaller.h"
 #include "Widgets/SBoxPanel.h"
+#include "Widgets/SInvalidationPanel.h"
 #include "Widgets/Text/SRichTextBlock.h"
+#include "Widget/SBYGRichTextDocument.h"
 #include <Modules/ModuleManager.h>
 #include "BYGRichTextModule.h"
+#include "Core/BYGRichTextMemory.h"
+#include "Async/ParallelFor.h"
 
 #define LOCTEXT_NAMESPACE "BYGRichText"
 
 UBYGRichTextBlock::UBYGRichTextBlock( const FObjectInitializer& ObjectInitializer )
 	: Super( ObjectInitializer )
+	, RevealState( MakeShared<FBYGRevealState>() )
+	, Stats( MakeShared<FBYGRichTextBlockStats>() )
 {
 	// Don't make BP variable by default, it's messy and annoying
 	bIsVariable = false;
@@ -25,19 +34,82 @@ void UBYGRichTextBlock::ReleaseSlateResources( bool bReleaseChildren )
 {
 	Super::ReleaseSlateResources( bReleaseChildren );
 
+	PendingRebuild = EBYGPendingRebuild::None;
+	if ( HasTextBinding() )
+	{
+		FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+		RichTextModule.UnregisterTextBinding( this );
+	}
 	MyVerticalBox.Reset();
+	MyDocument.Reset();
+	RunToolTip.Reset();
 	for ( TSharedPtr<SRichTextBlock>& TextBlock : MyRichTextBlocks )
 	{
 		TextBlock.Reset();
 	}
 }
 
+void UBYGRichTextBlock::GetResourceSizeEx( FResourceSizeEx& CumulativeResourceSize )
+{
+	Super::GetResourceSizeEx( CumulativeResourceSize );
+
+	SIZE_T Size = Text.ToString().GetAllocatedSize();
+	Size += BlockInfos.GetAllocatedSize();
+	for ( const FBYGTextBlockInfo& BlockInfo : BlockInfos )
+	{
+		Size += BlockInfo.GetAllocatedSize();
+	}
+	Size += SlotValues.GetAllocatedSize();
+	for ( const TPair<FName, FText>& Pair : SlotValues )
+	{
+		Size += Pair.Value.ToString().GetAllocatedSize();
+	}
+	if ( MarkupParser.IsValid() )
+	{
+		Size += sizeof( FBYGRichTextMarkupParser ) + MarkupParser->GetAllocatedSize();
+	}
+	Size += sizeof( FBYGRevealState ) + sizeof( FBYGRichTextBlockStats );
+
+	// Slate side. Runs are estimated from their counts, the text layouts hold little else per run
+	if ( MyDocument.IsValid() )
+	{
+		Size += sizeof( SBYGRichTextDocument ) + MyDocument->GetAllocatedSize();
+	}
+	Size += MyRichTextBlocks.GetAllocatedSize() + MyRichTextBlocks.Num() * sizeof( SRichTextBlock );
+	Size += Stats->GetNumRuns( EBYGRunType::Text ) * sizeof( FBYGTextRun );
+	Size += Stats->GetNumRuns( EBYGRunType::Widget ) * sizeof( FBYGWidgetRun );
+	Size += Stats->GetNumRuns( EBYGRunType::Image ) * sizeof( FBYGImageRun );
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes( Size );
+}
+
 TSharedRef<SWidget> UBYGRichTextBlock::RebuildWidget()
 {
+	// Build with the bound text rather than whatever was set in the designer
+	// Assigned rather than going through SetText, which would build the contents once more on top of the build below
+	if ( HasTextBinding() )
+	{
+		Text = TextDelegate.Execute();
+		const FString& BoundString = Text.ToString();
+		BoundTextHash = FCrc::StrCrc32( *BoundString );
+		BoundTextLen = BoundString.Len();
+		NextTextBindingPollTime = FPlatformTime::Seconds() + TextBindingInterval;
+
+		FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+		RichTextModule.RegisterTextBinding( this );
+	}
+
 	SAssignNew( MyVerticalBox, SVerticalBox );
 
 	RebuildContents();
 
+	if ( bCacheAsInvalidationRoot )
+	{
+		return SNew( SInvalidationPanel )
+			[
+				MyVerticalBox.ToSharedRef()
+			];
+	}
 	return MyVerticalBox.ToSharedRef();
 }
 
@@ -50,10 +122,13 @@ void UBYGRichTextBlock::SynchronizeProperties()
 
 void UBYGRichTextBlock::RebuildContents()
 {
-	FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+	BYG_RICHTEXT_LLM_SCOPE();
+
+	PendingRebuild = EBYGPendingRebuild::None;
+
+	const double StartTime = FPlatformTime::Seconds();
 
-	TArray< TSharedRef< class ITextDecorator > > CreatedDecorators;
-	CreateDecorators( CreatedDecorators );
+	FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
 
 	if ( RichTextStylesheetClass )
 	{
@@ -64,10 +139,12 @@ void UBYGRichTextBlock::RebuildContents()
 		}
 	}
 
-	TSharedPtr<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( this, "s" );
-	TSharedRef<FRichTextLayoutMarshaller> Marshaller = FRichTextLayoutMarshaller::Create( Parser, CreateMarkupWriter(), CreatedDecorators, RichTextModule.SlateStyleSet.Get() );
+	MarkupParser = FBYGRichTextMarkupParser::Create( this, "s" );
 
-	BlockInfos = Parser->SplitIntoBlocks( Text.ToString() );
+	BlockInfos = MarkupParser->ParseBlocks( Text.ToString() );
+	ParsedHash = MarkupParser->GetParseHash();
+	RevealState->ResetBlocks( BlockInfos.Num() );
+	Stats->ResetBlocks( BlockInfos.Num() );
 
 	MyRichTextBlocks.Empty();
 	// TODO: Need to Reset each one here?
@@ -78,9 +155,47 @@ void UBYGRichTextBlock::RebuildContents()
 		return;
 	}
 	MyVerticalBox->ClearChildren();
+	MyDocument.Reset();
 
-	for ( const FBYGTextBlockInfo& BlockInfo : BlockInfos )
+	const UBYGRichTextStylesheet* LocStylesheet = RichTextStylesheet;
+	if ( !RichTextStylesheet )
+	{
+		LocStylesheet = RichTextModule.GetFallbackStylesheet();
+	}
+
+	if ( bDrawAsSingleWidget && CanDrawAsDocument( LocStylesheet ) )
+	{
+		SAssignNew( MyDocument, SBYGRichTextDocument )
+			.OnGetRunToolTip_UObject( this, &UBYGRichTextBlock::HandleGetRunToolTip )
+			.OnRunClicked_UObject( this, &UBYGRichTextBlock::HandleRunClicked );
+		MyVerticalBox->AddSlot()
+			.AutoHeight()
+			[
+				MyDocument.ToSharedRef()
+			];
+	}
+
+	for ( int32 BlockIndex = 0; BlockIndex < BlockInfos.Num(); ++BlockIndex )
 	{
+		const FBYGTextBlockInfo& BlockInfo = BlockInfos[ BlockIndex ];
+
+		// Each block gets its own decorators so runs know which block they're in
+		TArray< TSharedRef< class ITextDecorator > > CreatedDecorators;
+		CreateDecorators( CreatedDecorators, BlockIndex );
+		TSharedRef<FRichTextLayoutMarshaller> Marshaller = FRichTextLayoutMarshaller::Create( MarkupParser, CreateMarkupWriter(), CreatedDecorators, RichTextModule.SlateStyleSet.Get() );
+
+		if ( MyDocument.IsValid() )
+		{
+			FBYGBlockLayoutStyle BlockStyle;
+			TArray<FBYGRunBrushInfo> Brushes;
+			GetDocumentBlockStyle( BlockInfo, LocStylesheet, BlockStyle, Brushes );
+			MyDocument->AddBlock( Marshaller, FText::FromString( BlockInfo.RawText ), BlockStyle, Brushes );
+			continue;
+		}
+
+		// Fill with the properties for this block, based on formatting info
+		const TMap<FName, const UBYGRichTextPropertyBase*> BlockPropertiesMap = BlockInfo.GetPropertiesWithDefaults( LocStylesheet );
+
 		TSharedPtr<SRichTextBlock> TextBlock =
 			SNew( SRichTextBlock )
 			//.TextStyle( &DefaultTextStyle )
@@ -88,24 +203,6 @@ void UBYGRichTextBlock::RebuildContents()
 
 		TSharedRef<SRichTextBlock> TextBlockRef = TextBlock.ToSharedRef();
 
-		// Fill with the properties for this block, based on formatting info
-		TMap<FName, const UBYGRichTextPropertyBase*> BlockPropertiesMap = BlockInfo.BlockPropertiesMap;
-
-		// Add any properties that should be applied, if they have not already got defaults
-		const UBYGRichTextStylesheet* LocStylesheet = RichTextStylesheet;
-		if ( !RichTextStylesheet )
-		{
-			LocStylesheet = RichTextModule.GetFallbackStylesheet();
-		}
-		for ( const UBYGRichTextPropertyBase* Prop : LocStylesheet->GetDefaultProperties() )
-		{
-			if ( !BlockPropertiesMap.Contains( Prop->GetTypeID() )
-				&& Prop->GetShouldApplyToDefault() )
-			{
-				BlockPropertiesMap.Add( Prop->GetTypeID(), Prop );
-			}
-		}
-
 		// Apply block-level formatting like margin, line-height percentage
 		for ( const auto& Pair : BlockPropertiesMap )
 		{
@@ -128,19 +225,328 @@ void UBYGRichTextBlock::RebuildContents()
 				FinalWidget
 			];
 	}
+
+	// Only once the widgets are actually rebuilt, bailing out above doesn't count
+	Stats->AddRebuild( StartTime, FPlatformTime::Seconds() - StartTime );
 }
 
 
 void UBYGRichTextBlock::SetText( const FText& InText )
 {
+	// Rebuilding would invalidate the layout of everything above us for nothing
+	if ( MyVerticalBox.IsValid() && Text.ToString().Equals( InText.ToString(), ESearchCase::CaseSensitive ) )
+	{
+		Text = InText;
+		return;
+	}
+
 	Text = InText;
 
-	RebuildWidget();
+	// RebuildWidget would make a new vertical box that nobody is displaying
+	if ( MyVerticalBox.IsValid() )
+	{
+		RebuildContents();
+	}
+}
+
+void UBYGRichTextBlock::SetTexts( const TArray<TPair<UBYGRichTextBlock*, FText>>& WidgetTexts )
+{
+	check( IsInGameThread() );
+
+	// Nothing is shared between widgets, so there's no work to save
+	if ( GetDefault<UBYGRichTextRuntimeSettings>()->MaxSharedParsedTexts <= 0 )
+	{
+		for ( const TPair<UBYGRichTextBlock*, FText>& Pair : WidgetTexts )
+		{
+			if ( Pair.Key )
+			{
+				Pair.Key->SetText( Pair.Value );
+			}
+		}
+		return;
+	}
+
+	struct FBatchParse
+	{
+		const UBYGRichTextStylesheet* Stylesheet = nullptr;
+		uint32 ParseHash = 0;
+		FString Text;
+		TSharedPtr<const FBYGParsedText> Parsed;
+		bool bParsedHere = false;
+		TArray<int32> WidgetIndices;
+	};
+	TArray<FBatchParse> Parses;
+	// Parser output only depends on the parse hash and the text
+	TMap<uint32, TMap<FString, int32, FDefaultSetAllocator, TBYGCaseSensitiveKeyFuncs<int32>>> ParseIndices;
+	TMap<const UBYGRichTextStylesheet*, uint32> StylesheetHashes;
+
+	for ( int32 i = 0; i < WidgetTexts.Num(); ++i )
+	{
+		UBYGRichTextBlock* Widget = WidgetTexts[ i ].Key;
+		if ( !Widget )
+			continue;
+
+		// Unbuilt widgets only store the text, and unchanged text does nothing, see SetText
+		const FString& NewText = WidgetTexts[ i ].Value.ToString();
+		if ( !Widget->MyVerticalBox.IsValid() || !Widget->RichTextStylesheet || Widget->Text.ToString().Equals( NewText, ESearchCase::CaseSensitive ) )
+		{
+			Widget->SetText( WidgetTexts[ i ].Value );
+			continue;
+		}
+
+		uint32* ParseHash = StylesheetHashes.Find( Widget->RichTextStylesheet );
+		if ( !ParseHash )
+		{
+			// Same element name as the widget's own parser, so the hash matches
+			ParseHash = &StylesheetHashes.Add( Widget->RichTextStylesheet, FBYGRichTextMarkupParser::Create( Widget->RichTextStylesheet, "s" )->GetParseHash() );
+		}
+
+		auto& ForHash = ParseIndices.FindOrAdd( *ParseHash );
+		int32 ParseIndex = INDEX_NONE;
+		if ( const int32* Existing = ForHash.Find( NewText ) )
+		{
+			ParseIndex = *Existing;
+		}
+		else
+		{
+			ParseIndex = Parses.AddDefaulted();
+			ForHash.Add( NewText, ParseIndex );
+			Parses[ ParseIndex ].Stylesheet = Widget->RichTextStylesheet;
+			Parses[ ParseIndex ].ParseHash = *ParseHash;
+			Parses[ ParseIndex ].Text = NewText;
+			Parses[ ParseIndex ].Parsed = FBYGRichTextParseCache::Get().Find( *ParseHash, NewText );
+		}
+		Parses[ ParseIndex ].WidgetIndices.Add( i );
+	}
+
+	// Safe off the game thread in the same way as FBYGRichTextLayoutPredictor, each task has its own parser
+	ParallelFor( Parses.Num(), [ &Parses ]( int32 Index )
+	{
+		FBatchParse& Parse = Parses[ Index ];
+		if ( !Parse.Parsed.IsValid() )
+		{
+			Parse.Parsed = FBYGRichTextMarkupParser::Create( Parse.Stylesheet, "s" )->ParseFully( Parse.Text );
+			Parse.bParsedHere = true;
+		}
+	} );
+
+	for ( const FBatchParse& Parse : Parses )
+	{
+		// Added right before it's used, so a batch bigger than the cache doesn't push out its own output
+		if ( Parse.bParsedHere )
+		{
+			FBYGRichTextParseCache::Get().AddShared( Parse.ParseHash, Parse.Text, Parse.Parsed.ToSharedRef() );
+		}
+		for ( int32 WidgetIndex : Parse.WidgetIndices )
+		{
+			WidgetTexts[ WidgetIndex ].Key->SetText( WidgetTexts[ WidgetIndex ].Value );
+		}
+	}
+}
+
+void UBYGRichTextBlock::PollTextBinding( double Time )
+{
+	if ( !HasTextBinding() || Time < NextTextBindingPollTime )
+		return;
+	NextTextBindingPollTime = Time + TextBindingInterval;
+
+	const FText NewText = TextDelegate.Execute();
+	const FString& NewString = NewText.ToString();
+	const uint32 NewHash = FCrc::StrCrc32( *NewString );
+	if ( NewHash == BoundTextHash && NewString.Len() == BoundTextLen )
+		return;
+
+	BoundTextHash = NewHash;
+	BoundTextLen = NewString.Len();
+	SetText( NewText );
+}
+
+void UBYGRichTextBlock::SetSlotValue( const FName& SlotName, const FText& Value )
+{
+	FText* Existing = SlotValues.Find( SlotName );
+	if ( Existing && Existing->ToString().Equals( Value.ToString(), ESearchCase::CaseSensitive ) )
+		return;
+
+	SlotValues.Add( SlotName, Value );
+	RefreshSlot( SlotName );
+}
+
+void UBYGRichTextBlock::ClearSlotValue( const FName& SlotName )
+{
+	if ( SlotValues.Remove( SlotName ) > 0 )
+	{
+		RefreshSlot( SlotName );
+	}
+}
+
+FBYGPredictedLayout UBYGRichTextBlock::PredictLayout( float WrapWidth, float Scale ) const
+{
+	// Same stylesheet RebuildContents would use, so this works before the widget has been built
+	const UBYGRichTextStylesheet* Stylesheet = RichTextStylesheetClass ? RichTextStylesheetClass->GetDefaultObject<UBYGRichTextStylesheet>() : GetRichTextStylesheet();
+	// Fonts round differently at each scale, so measure at the one the text is actually laid out at
+	if ( Scale <= 0.0f )
+	{
+		Scale = GetCachedGeometry().Scale > 0.0f ? GetCachedGeometry().Scale : 1.0f;
+	}
+	return FBYGRichTextLayoutPredictor::Predict( Text.ToString(), Stylesheet, WrapWidth, Scale, &SlotValues );
+}
+
+void UBYGRichTextBlock::RefreshSlot( const FName& SlotName )
+{
+	// The parser keeps the output for each block, so this only recreates the runs and lays out the block again
+	for ( int32 i = 0; i < BlockInfos.Num() && i < MyRichTextBlocks.Num(); ++i )
+	{
+		if ( BlockInfos[ i ].SlotNames.Contains( SlotName ) && MyRichTextBlocks[ i ].IsValid() )
+		{
+			MyRichTextBlocks[ i ]->Refresh();
+		}
+		if ( BlockInfos[ i ].SlotNames.Contains( SlotName ) && MyDocument.IsValid() )
+		{
+			MyDocument->RefreshBlock( i );
+		}
+	}
+}
+
+void UBYGRichTextBlock::GetDocumentBlockStyle( const FBYGTextBlockInfo& BlockInfo, const UBYGRichTextStylesheet* Stylesheet, FBYGBlockLayoutStyle& OutBlockStyle, TArray<FBYGRunBrushInfo>& OutBrushes )
+{
+	OutBlockStyle = FBYGBlockLayoutStyle();
+	OutBrushes.Reset();
+	for ( const auto& Pair : BlockInfo.GetPropertiesWithDefaults( Stylesheet ) )
+	{
+		Pair.Value->ApplyToBlockStyle( OutBlockStyle );
+
+		// Later wrappers end up outermost, so their brushes are furthest back
+		FBYGRunBrushInfo BrushInfo;
+		if ( Pair.Value->GetRunBrush( BlockInfo.Payload, BrushInfo ) )
+		{
+			OutBrushes.Insert( BrushInfo, 0 );
+		}
+	}
+}
+
+bool UBYGRichTextBlock::CanDrawAsDocument( const UBYGRichTextStylesheet* Stylesheet ) const
+{
+	if ( !Stylesheet )
+		return false;
+
+	// Block widgets are only needed for properties on block styles, inline ones use the hit-test index
+	auto NeedsWidget = []( const UBYGRichTextPropertyBase* Prop, bool bBlock )
+	{
+		return Prop && ( ( bBlock && Prop->RequiresBlockWidget() ) || Prop->RequiresInlineTextBlock() );
+	};
+
+	for ( const UBYGRichTextPropertyBase* Prop : Stylesheet->GetDefaultProperties() )
+	{
+		if ( NeedsWidget( Prop, true ) )
+			return false;
+	}
+	for ( const FName& StyleID : GetUsedStyleIDs() )
+	{
+		if ( const UBYGRichTextStyle* Style = Stylesheet->FindStyle( StyleID ) )
+		{
+			const bool bBlock = Style->GetDisplayType() == EBYGStyleDisplayType::Block;
+			for ( const UBYGRichTextPropertyBase* Prop : Style->Properties )
+			{
+				if ( NeedsWidget( Prop, bBlock ) )
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+TSharedPtr<FBYGRunHitTestIndex> UBYGRichTextBlock::GetHitTestIndex() const
+{
+	return MyDocument.IsValid() ? MyDocument->GetHitTestIndex() : TSharedPtr<FBYGRunHitTestIndex>();
+}
+
+TSharedPtr<IToolTip> UBYGRichTextBlock::HandleGetRunToolTip( const FBYGRunInteraction& Run )
+{
+#if WITH_EDITOR
+	if ( bIsSlatePreview )
+		return nullptr;
+#endif
+
+	for ( const TWeakObjectPtr<const UBYGRichTextPropertyBase>& Prop : Run.Properties )
+	{
+		TSharedPtr<IToolTip> ToolTip = Prop.IsValid() ? Prop->CreateRunToolTip( this, Run.Data ) : nullptr;
+		if ( ToolTip.IsValid() )
+		{
+			return ToolTip;
+		}
+	}
+	return nullptr;
+}
+
+TSharedRef<FBYGDelegateToolTip> UBYGRichTextBlock::GetRunToolTip( const UBYGRichTextTooltipProperty* Property, const FBYGStyleTagData& Data )
+{
+	if ( !RunToolTip.IsValid() )
+	{
+		RunToolTip = MakeShared<FBYGDelegateToolTip>( Property, this, Data );
+	}
+	else
+	{
+		RunToolTip->SetRun( Property, Data );
+	}
+	return RunToolTip.ToSharedRef();
+}
+
+void UBYGRichTextBlock::HandleRunClicked( const FBYGRunInteraction& Run )
+{
+	OnRunClickedNative.Broadcast( Run.Data );
+	OnRunClicked.Broadcast( Run.Data );
+}
+
+void UBYGRichTextBlock::SetRevealedCharacterCount( int32 Count )
+{
+	const int32 OldCount = RevealState->GetRevealedCount();
+	RevealState->SetRevealedCount( Count );
+	InvalidateRevealRange( OldCount, RevealState->GetRevealedCount() );
+}
+
+void UBYGRichTextBlock::SetRevealProgress( float Progress )
+{
+	const int32 OldCount = RevealState->GetRevealedCount();
+	RevealState->SetRevealedFraction( Progress );
+	InvalidateRevealRange( OldCount, RevealState->GetRevealedCount() );
+}
+
+void UBYGRichTextBlock::InvalidateRevealRange( int32 FromCount, int32 ToCount )
+{
+	if ( FromCount == ToCount )
+		return;
+
+	const int32 RangeBegin = FMath::Min( FromCount, ToCount );
+	const int32 RangeEnd = FMath::Max( FromCount, ToCount );
+
+	// Only paint changes, the layout is the same however much is revealed
+	if ( MyDocument.IsValid() )
+	{
+		MyDocument->InvalidatePaint();
+	}
+	for ( int32 i = 0; i < MyRichTextBlocks.Num(); ++i )
+	{
+		const int32 BlockStart = RevealState->GetBlockStart( i );
+		const int32 BlockEnd = BlockStart + RevealState->GetBlockLength( i );
+		if ( MyRichTextBlocks[ i ].IsValid() && BlockStart <= RangeEnd && BlockEnd >= RangeBegin )
+		{
+			MyRichTextBlocks[ i ]->Invalidate( EInvalidateWidgetReason::Paint );
+		}
+	}
+}
+
+void UBYGRichTextBlock::CreateDecorators( TArray< TSharedRef< class ITextDecorator > >& OutDecorators, int32 BlockIndex )
+{
+	DecoratorBlockIndex = BlockIndex;
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	CreateDecorators( OutDecorators );
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+	DecoratorBlockIndex = INDEX_NONE;
 }
 
 void UBYGRichTextBlock::CreateDecorators( TArray< TSharedRef< class ITextDecorator > >& OutDecorators )
 {
-	OutDecorators.Add( FBYGInlineTextFormatDecorator::Create( "s", this ) );
+	OutDecorators.Add( FBYGInlineTextFormatDecorator::Create( "s", this, DecoratorBlockIndex ) );
 }
 
 TSharedPtr<IRichTextMarkupParser> UBYGRichTextBlock::CreateMarkupParser()
@@ -157,6 +563,15 @@ void UBYGRichTextBlock::SetRichTextStylesheet( const UBYGRichTextStylesheet* InR
 {
 	ensure( InRichTextStylesheet );
 
+	if ( InRichTextStylesheet == RichTextStylesheet )
+		return;
+
+	const UBYGRichTextStylesheet* OldStylesheet = RichTextStylesheet;
+	if ( OldStylesheet )
+	{
+		OldStylesheet->OnStylesheetPropertiesChangedDelegate.RemoveDynamic( this, &UBYGRichTextBlock::OnRichTextStylesheetChanged );
+	}
+
 	RichTextStylesheet = InRichTextStylesheet;
 
 	if ( RichTextStylesheet )
@@ -164,6 +579,21 @@ void UBYGRichTextBlock::SetRichTextStylesheet( const UBYGRichTextStylesheet* InR
 		bHasExternallyDefinedStylesheet = true;
 		RichTextStylesheet->OnStylesheetPropertiesChangedDelegate.AddUniqueDynamic( this, &UBYGRichTextBlock::OnRichTextStylesheetChanged );
 	}
+
+	// Nothing built yet, RebuildWidget will parse with the new stylesheet
+	if ( !MyVerticalBox.IsValid() || !MarkupParser.IsValid() || !RichTextStylesheet )
+		return;
+
+	// Parsed output refers to styles by ID, so it's the same for any stylesheet with the same styles
+	// e.g. swapping between themes or colour-blind palettes
+	if ( OldStylesheet && OldStylesheet->GetParseHash() == RichTextStylesheet->GetParseHash() )
+	{
+		QueueRebuild( EBYGPendingRebuild::Retheme );
+	}
+	else
+	{
+		QueueRebuild( EBYGPendingRebuild::Full );
+	}
 }
 
 void UBYGRichTextBlock::SetRichTextStylesheetClass( TSubclassOf<UBYGRichTextStylesheet> InRichTextStylesheetClass )
@@ -189,9 +619,113 @@ void UBYGRichTextBlock::SetRichTextStylesheetClass( TSubclassOf<UBYGRichTextStyl
 	}
 }
 
-void UBYGRichTextBlock::OnRichTextStylesheetChanged()
+void UBYGRichTextBlock::OnRichTextStylesheetChanged( const FBYGStylesheetChange& Change )
+{
+	if ( !MarkupParser.IsValid() )
+	{
+		QueueRebuild( EBYGPendingRebuild::Full );
+		return;
+	}
+
+	// e.g. a property replaced by another of the same type. Handles to everything else are still valid
+	if ( Change.bStructural )
+	{
+		QueueRebuild( ParsedHash == MarkupParser->GetParseHash() ? EBYGPendingRebuild::Retheme : EBYGPendingRebuild::Full );
+		return;
+	}
+
+	// Edits to styles we never used can't change our output
+	if ( !Change.AffectsAnyStyle( GetUsedStyleIDs() ) )
+		return;
+
+	QueueRebuild( Change.bRestyleOnly ? EBYGPendingRebuild::Restyle : EBYGPendingRebuild::Full );
+}
+
+void UBYGRichTextBlock::QueueRebuild( EBYGPendingRebuild Rebuild )
+{
+	const bool bWasQueued = PendingRebuild != EBYGPendingRebuild::None;
+	PendingRebuild = FMath::Max( PendingRebuild, Rebuild );
+	if ( bWasQueued )
+		return;
+
+	FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+	RichTextModule.QueueContentsRebuild( this );
+}
+
+void UBYGRichTextBlock::FlushPendingRebuild()
+{
+	const EBYGPendingRebuild Rebuild = PendingRebuild;
+	PendingRebuild = EBYGPendingRebuild::None;
+
+	// Nothing to rebuild if Slate resources have not been created yet, RebuildWidget will handle it
+	if ( !MyVerticalBox.IsValid() )
+		return;
+
+	if ( Rebuild == EBYGPendingRebuild::Full )
+	{
+		RebuildContents();
+	}
+	else if ( Rebuild == EBYGPendingRebuild::Retheme )
+	{
+		RethemeContents();
+	}
+	else if ( Rebuild == EBYGPendingRebuild::Restyle )
+	{
+		RestyleContents();
+	}
+}
+
+void UBYGRichTextBlock::RestyleContents()
+{
+	// The parser keeps the output for each block, so refreshing only rebuilds the runs with the new text styles
+	for ( TSharedPtr<SRichTextBlock>& TextBlock : MyRichTextBlocks )
+	{
+		if ( TextBlock.IsValid() )
+		{
+			TextBlock->Refresh();
+		}
+	}
+	if ( MyDocument.IsValid() )
+	{
+		MyDocument->RefreshAllBlocks();
+	}
+}
+
+void UBYGRichTextBlock::RethemeContents()
+{
+	const UBYGRichTextStylesheet* Stylesheet = GetRichTextStylesheet();
+	for ( FBYGTextBlockInfo& BlockInfo : BlockInfos )
+	{
+		BlockInfo.ResolveProperties( Stylesheet );
+	}
+
+	// Block widgets were wrapped by the old stylesheet's properties. Parsing again is a parse cache hit
+	if ( !MyDocument.IsValid() || !CanDrawAsDocument( Stylesheet ) )
+	{
+		RebuildContents();
+		return;
+	}
+
+	for ( int32 BlockIndex = 0; BlockIndex < BlockInfos.Num(); ++BlockIndex )
+	{
+		FBYGBlockLayoutStyle BlockStyle;
+		TArray<FBYGRunBrushInfo> Brushes;
+		GetDocumentBlockStyle( BlockInfos[ BlockIndex ], Stylesheet, BlockStyle, Brushes );
+		MyDocument->SetBlockStyle( BlockIndex, BlockStyle, Brushes );
+	}
+	RestyleContents();
+}
+
+const TSet<FName>& UBYGRichTextBlock::GetUsedStyleIDs() const
+{
+	static const TSet<FName> Empty;
+	return MarkupParser.IsValid() ? MarkupParser->GetUsedStyleIDs() : Empty;
+}
+
+const TSet<FName>& UBYGRichTextBlock::GetUsedPropertyTypeIDs() const
 {
-	RebuildWidget();
+	static const TSet<FName> Empty;
+	return MarkupParser.IsValid() ? MarkupParser->GetUsedPropertyTypeIDs() : Empty;
 }
 
 #if WITH_EDITOR
@@ -0,0 +1,268 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Widget/SBYGRichTextDocument.h"
+
+#include "Framework/Text/ITextLayoutMarshaller.h"
+#include "InputCoreTypes.h"
+#include "Framework/Text/SlateTextLayout.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/SlateBrush.h"
+#include "Widgets/Text/SlateTextBlockLayout.h"
+
+SBYGRichTextDocument::SBYGRichTextDocument()
+{
+	// Paint reads the block sizes worked out in the prepass
+	SetCanTick( false );
+	bCanSupportFocus = false;
+}
+
+SBYGRichTextDocument::~SBYGRichTextDocument()
+{
+}
+
+void SBYGRichTextDocument::Construct( const FArguments& InArgs )
+{
+	TextStyle = *InArgs._TextStyle;
+	OnGetRunToolTip = InArgs._OnGetRunToolTip;
+	OnRunClicked = InArgs._OnRunClicked;
+}
+
+void SBYGRichTextDocument::AddBlock( const TSharedRef<ITextLayoutMarshaller>& Marshaller, const FText& Text, const FBYGBlockLayoutStyle& BlockStyle, const TArray<FBYGRunBrushInfo>& Brushes )
+{
+	TUniquePtr<FBlock> Block = MakeUnique<FBlock>();
+	Block->Layout = MakeUnique<FSlateTextBlockLayout>( this, TextStyle, TOptional<ETextShapingMethod>(), TOptional<ETextFlowDirection>(), FCreateSlateTextLayout(), Marshaller, nullptr );
+	Block->Text = Text;
+	Block->Style = BlockStyle;
+	Block->Brushes = Brushes;
+	Blocks.Add( MoveTemp( Block ) );
+
+	InvalidateDocument( EInvalidateWidgetReason::Layout );
+}
+
+void SBYGRichTextDocument::RefreshBlock( int32 BlockIndex )
+{
+	if ( Blocks.IsValidIndex( BlockIndex ) )
+	{
+		Blocks[ BlockIndex ]->Layout->DirtyContent();
+		Blocks[ BlockIndex ]->bDirty = true;
+		InvalidateDocument( EInvalidateWidgetReason::Layout );
+	}
+}
+
+void SBYGRichTextDocument::RefreshAllBlocks()
+{
+	for ( const TUniquePtr<FBlock>& Block : Blocks )
+	{
+		Block->Layout->DirtyContent();
+		Block->bDirty = true;
+	}
+	InvalidateDocument( EInvalidateWidgetReason::Layout );
+}
+
+void SBYGRichTextDocument::SetBlockStyle( int32 BlockIndex, const FBYGBlockLayoutStyle& BlockStyle, const TArray<FBYGRunBrushInfo>& Brushes )
+{
+	if ( Blocks.IsValidIndex( BlockIndex ) )
+	{
+		Blocks[ BlockIndex ]->Style = BlockStyle;
+		Blocks[ BlockIndex ]->Brushes = Brushes;
+		Blocks[ BlockIndex ]->bDirty = true;
+		InvalidateDocument( EInvalidateWidgetReason::Layout );
+	}
+}
+
+void SBYGRichTextDocument::InvalidatePaint()
+{
+	InvalidateDocument( EInvalidateWidgetReason::Paint );
+}
+
+void SBYGRichTextDocument::InvalidateDocument( EInvalidateWidgetReason Reason )
+{
+	if ( Reason == EInvalidateWidgetReason::Paint )
+	{
+		++Stats.NumPaintInvalidations;
+	}
+	else
+	{
+		++Stats.NumLayoutInvalidations;
+	}
+	Invalidate( Reason );
+}
+
+SIZE_T SBYGRichTextDocument::GetAllocatedSize() const
+{
+	SIZE_T Size = Blocks.GetAllocatedSize() + HitTestIndex->GetAllocatedSize();
+	for ( const TUniquePtr<FBlock>& Block : Blocks )
+	{
+		Size += sizeof( FBlock ) + sizeof( FSlateTextBlockLayout ) + Block->Brushes.GetAllocatedSize();
+		Size += Block->Text.ToString().GetAllocatedSize();
+	}
+	return Size;
+}
+
+FVector2D SBYGRichTextDocument::ComputeDesiredSize( float LayoutScaleMultiplier ) const
+{
+	FVector2D Size = FVector2D::ZeroVector;
+	for ( const TUniquePtr<FBlock>& BlockPtr : Blocks )
+	{
+		const FBlock& Block = *BlockPtr;
+		const FBYGBlockLayoutStyle& Style = Block.Style;
+		if ( !Block.bDirty && Block.LaidOutScale == LayoutScaleMultiplier && ( !Style.bAutoWrap || Block.LaidOutWidth == LastPaintWidth ) )
+		{
+			Size.X = FMath::Max( Size.X, Block.DesiredSize.X );
+			Size.Y += Block.DesiredSize.Y;
+			continue;
+		}
+
+		FVector2D BlockSize = Block.Layout->ComputeDesiredSize(
+			FSlateTextBlockLayout::FWidgetArgs( Block.Text, FText::GetEmpty(), 0.0f, Style.bAutoWrap, Style.WrappingPolicy, ETextTransformPolicy::None, Style.Margin, Style.LineHeightPercentage, Style.Justification ),
+			LayoutScaleMultiplier, TextStyle );
+
+		// Same as the overlay WrapBlock would have put around the block
+		for ( const FBYGRunBrushInfo& BrushInfo : Block.Brushes )
+		{
+			if ( BrushInfo.Brush && BrushInfo.Brush->DrawAs != ESlateBrushDrawType::NoDrawType )
+			{
+				BlockSize = FVector2D::Max( BlockSize, BrushInfo.Brush->ImageSize + BrushInfo.Padding.GetDesiredSize() );
+			}
+		}
+
+		Block.DesiredSize = BlockSize;
+		Block.bDirty = false;
+		Block.LaidOutScale = LayoutScaleMultiplier;
+		Block.LaidOutWidth = LastPaintWidth;
+		++Stats.NumBlockLayouts;
+
+		Size.X = FMath::Max( Size.X, BlockSize.X );
+		Size.Y += BlockSize.Y;
+	}
+	return Size;
+}
+
+int32 SBYGRichTextDocument::OnPaint( const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const
+{
+	const ESlateDrawEffect DrawEffects = ShouldBeEnabled( bParentEnabled ) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const float Width = AllottedGeometry.GetLocalSize().X;
+	LastPaintWidth = Width;
+	bool bNeedsWrapLayout = false;
+
+	// Runs that are painted add themselves again
+	HitTestIndex->Reset( AllottedGeometry );
+
+	int32 MaxLayerId = LayerId;
+	float Offset = 0.0f;
+	for ( const TUniquePtr<FBlock>& Block : Blocks )
+	{
+		// Stacked like an SVerticalBox with auto height slots
+		const FVector2D BlockSize( Width, Block->DesiredSize.Y );
+		const FGeometry BlockGeometry = AllottedGeometry.MakeChild( BlockSize, FSlateLayoutTransform( FVector2D( 0.0f, Offset ) ) );
+		Offset += BlockSize.Y;
+		bNeedsWrapLayout = bNeedsWrapLayout || ( Block->Style.bAutoWrap && Block->LaidOutWidth != Width );
+
+		const FSlateRect BlockRect = BlockGeometry.GetLayoutBoundingRect();
+		if ( !FSlateRect::DoRectanglesIntersect( BlockRect, MyCullingRect ) )
+			continue;
+
+		for ( const FBYGRunBrushInfo& BrushInfo : Block->Brushes )
+		{
+			if ( !BrushInfo.Brush || BrushInfo.Brush->DrawAs == ESlateBrushDrawType::NoDrawType )
+				continue;
+
+			FVector2D BrushOffset;
+			FVector2D BrushSize;
+			BrushInfo.GetBrushRect( BlockSize, BrushOffset, BrushSize );
+			FSlateDrawElement::MakeBox(
+				OutDrawElements,
+				LayerId,
+				BlockGeometry.ToPaintGeometry( BrushSize, FSlateLayoutTransform( BrushOffset ) ),
+				BrushInfo.Brush,
+				DrawEffects,
+				InWidgetStyle.GetColorAndOpacityTint() * BrushInfo.Brush->GetTint( InWidgetStyle ) );
+		}
+
+		const int32 BlockLayerId = Block->Layout->OnPaint( Args, BlockGeometry, MyCullingRect, OutDrawElements, LayerId + 1, InWidgetStyle, ShouldBeEnabled( bParentEnabled ) );
+		MaxLayerId = FMath::Max( MaxLayerId, BlockLayerId );
+	}
+
+	// Same as SRichTextBlock, wrapped blocks are only measured at the new width in the next prepass
+	if ( bNeedsWrapLayout )
+	{
+		const_cast<SBYGRichTextDocument*>( this )->InvalidateDocument( EInvalidateWidgetReason::Layout );
+	}
+
+	return MaxLayerId;
+}
+
+void SBYGRichTextDocument::SetHoveredRun( const TSharedPtr<const FBYGRunInteraction>& Run )
+{
+	if ( Run == HoveredRun )
+		return;
+
+	HoveredRun = Run;
+	HoveredRunToolTip.Reset();
+	if ( HoveredRun.IsValid() && OnGetRunToolTip.IsBound() )
+	{
+		HoveredRunToolTip = OnGetRunToolTip.Execute( *HoveredRun );
+	}
+}
+
+FReply SBYGRichTextDocument::OnMouseMove( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent )
+{
+	SetHoveredRun( HitTestIndex->FindRun( MyGeometry, MouseEvent.GetScreenSpacePosition() ) );
+	return FReply::Unhandled();
+}
+
+void SBYGRichTextDocument::OnMouseLeave( const FPointerEvent& MouseEvent )
+{
+	SLeafWidget::OnMouseLeave( MouseEvent );
+	SetHoveredRun( nullptr );
+	PressedRun.Reset();
+}
+
+FReply SBYGRichTextDocument::OnMouseButtonDown( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent )
+{
+	if ( MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton )
+	{
+		TSharedPtr<const FBYGRunInteraction> Run = HitTestIndex->FindRun( MyGeometry, MouseEvent.GetScreenSpacePosition() );
+		if ( Run.IsValid() && Run->bClickable )
+		{
+			PressedRun = Run;
+			return FReply::Handled();
+		}
+	}
+	return FReply::Unhandled();
+}
+
+FReply SBYGRichTextDocument::OnMouseButtonUp( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent )
+{
+	if ( MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton && PressedRun.IsValid() )
+	{
+		TSharedPtr<const FBYGRunInteraction> Run = HitTestIndex->FindRun( MyGeometry, MouseEvent.GetScreenSpacePosition() );
+		TSharedPtr<const FBYGRunInteraction> Pressed = PressedRun;
+		PressedRun.Reset();
+		if ( Run == Pressed )
+		{
+			OnRunClicked.ExecuteIfBound( *Run );
+			return FReply::Handled();
+		}
+	}
+	return FReply::Unhandled();
+}
+
+FCursorReply SBYGRichTextDocument::OnCursorQuery( const FGeometry& MyGeometry, const FPointerEvent& CursorEvent ) const
+{
+	if ( HoveredRun.IsValid() && HoveredRun->Cursor != EMouseCursor::Default )
+	{
+		return FCursorReply::Cursor( HoveredRun->Cursor );
+	}
+	return SLeafWidget::OnCursorQuery( MyGeometry, CursorEvent );
+}
+
+TSharedPtr<IToolTip> SBYGRichTextDocument::GetToolTip()
+{
+	// Slate asks again as the mouse moves, so a new hovered run swaps the tooltip
+	if ( HoveredRunToolTip.IsValid() )
+	{
+		return HoveredRunToolTip;
+	}
+	return SLeafWidget::GetToolTip();
+}
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 #include "UObject/GCObject.h"
+#include "Containers/List.h"
+#include "Containers/Ticker.h"
 
 class FBYGRichTextModule : public IModuleInterface, public FGCObject
 {
@@ -21,6 +23,25 @@ public:
 	const FSlateBrush* GetIconBrush( const FString& Path, const FVector2D& MaxSize );
 	class UBYGRichTextStylesheet* GetFallbackStylesheet() const { return FallbackStylesheet; }
 
+	// Tooltip widgets are reused rather than created on every hover. Free ones are kept per world
+	// and thrown away when it's cleaned up
+	class UUserWidget* AcquireTooltipWidget( UWorld* World, TSubclassOf<class UUserWidget> WidgetClass );
+	void ReleaseTooltipWidget( class UUserWidget* Widget );
+	int32 GetNumFreeTooltipWidgets() const { return FreeTooltipWidgets.Num(); }
+	void EmptyTooltipWidgetPool() { FreeTooltipWidgets.Empty(); }
+
+	// Brushes are the size-specific entries, several can share a texture
+	void GetIconCacheStats( int32& OutNumBrushes, int32& OutNumTextures, SIZE_T& OutTextureBytes ) const;
+
+	// Widgets queued here are rebuilt at most once, on the next core ticker flush
+	void QueueContentsRebuild( class UBYGRichTextBlock* Widget );
+	void FlushPendingRebuilds();
+
+	// Widgets with their Text bound are polled from here, rather than each widget ticking
+	void RegisterTextBinding( class UBYGRichTextBlock* Widget );
+	void UnregisterTextBinding( class UBYGRichTextBlock* Widget );
+	void PollTextBindings();
+
 	TSharedPtr<class FSlateStyleSet> SlateStyleSet;
 
 protected:
@@ -30,6 +51,24 @@ protected:
 
 	void OnPostEngineInit();
 
+	bool Tick( float DeltaTime );
+	FDelegateHandle TickDelegateHandle;
+
+	TSet<TWeakObjectPtr<class UBYGRichTextBlock>> PendingRebuilds;
+	TSet<TWeakObjectPtr<class UBYGRichTextBlock>> BoundTextWidgets;
+
+	struct FPooledTooltipWidget
+	{
+		class UUserWidget* Widget = nullptr;
+		// Keeps the Slate widget alive too, so it doesn't need rebuilding
+		TSharedPtr<SWidget> SlateWidget;
+	};
+	// Oldest first. A list so the oldest can be dropped, and matches taken from the middle, without moving the rest
+	TDoubleLinkedList<FPooledTooltipWidget> FreeTooltipWidgets;
+
+	void OnWorldCleanup( UWorld* World, bool bSessionEnded, bool bCleanupResources );
+	FDelegateHandle WorldCleanupHandle;
+
 	// Default stylesheet used if no stylesheet is chosen, or there are problems
 	class UBYGRichTextStylesheet* FallbackStylesheet = nullptr;
 };
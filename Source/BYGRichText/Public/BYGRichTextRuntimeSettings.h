@@ -35,10 +35,36 @@ public:
 
 	UPROPERTY(config, EditAnywhere, Category = Settings)
 	FString ParagraphSeparator;
+
+	// Surround a name with these to make a slot, e.g. { and } for {Amount}, filled in with UBYGRichTextBlock::SetSlotValue
+	// Blank by default, so text that already has braces in it isn't changed. Set both to enable slots
+	UPROPERTY(config, EditAnywhere, Category = Settings)
+	FString SlotOpenCharacter;
+	UPROPERTY(config, EditAnywhere, Category = Settings)
+	FString SlotCloseCharacter;
 	
 	UPROPERTY(config, EditAnywhere, Category = Settings, meta = ( AllowedClasses = "Font", DisplayName="Fallback Font" ))
 	FSoftObjectPath FallbackFontPath;
 
+	// Output of the BYGRichTextCompileMarkup commandlet, relative to the project directory
+	// Loaded on startup so those strings don't need to be parsed at runtime. Remember to add them to
+	// "Additional Non-Asset Directories to Package" so they are staged
+	UPROPERTY(config, EditAnywhere, Category = Performance)
+	TArray<FFilePath> CompiledMarkupFiles;
+
+	// Parser output for text parsed at runtime is shared between every widget showing the same text
+	// This many of the most recent strings are kept around. 0 disables sharing
+	UPROPERTY(config, EditAnywhere, Category = Performance, meta = ( ClampMin = 0 ))
+	int32 MaxSharedParsedTexts = 1024;
+
+	// Results of FBYGRichTextLayoutPredictor kept for the same text, wrap width and scale. 0 disables caching
+	UPROPERTY(config, EditAnywhere, Category = Performance, meta = ( ClampMin = 0 ))
+	int32 MaxCachedLayouts = 4096;
+
+	// Tooltip widgets that have been closed are kept to show the next tooltip of the same class. 0 disables pooling
+	UPROPERTY(config, EditAnywhere, Category = Performance, meta = ( ClampMin = 0 ))
+	int32 MaxPooledTooltipWidgets = 8;
+
 #if WITH_EDITOR
 	EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override
 	{
@@ -0,0 +1,52 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Fonts/SlateFontInfo.h"
+#include "HAL/CriticalSection.h"
+
+class FSlateFontCache;
+
+struct FBYGFontMetrics
+{
+	int16 Baseline = 0;
+	uint16 MaxHeight = 0;
+};
+
+// Baseline and line height per font and scale, shared by every rich text widget
+// These only change when the font cache is flushed (font asset edits, DPI changes flush and re-key by scale)
+class BYGRICHTEXT_API FBYGFontMetricsCache
+{
+public:
+	static FBYGFontMetricsCache& Get();
+
+	// Scale is the text layout scale. Widget and image runs take their baseline at 1 and scale it themselves
+	FBYGFontMetrics GetMetrics( const FSlateFontInfo& Font, float Scale );
+	int16 GetBaseline( const FSlateFontInfo& Font, float Scale ) { return GetMetrics( Font, Scale ).Baseline; }
+	uint16 GetMaxHeight( const FSlateFontInfo& Font, float Scale ) { return GetMetrics( Font, Scale ).MaxHeight; }
+
+	void Empty();
+	int32 Num() const;
+
+	// Empty the cache whenever Slate releases its font resources
+	void RegisterWithFontCache( FSlateFontCache& FontCache );
+	void UnregisterFromFontCache( FSlateFontCache& FontCache );
+
+protected:
+	FBYGFontMetrics MeasureMetrics( const FSlateFontInfo& Font, float Scale ) const;
+	void OnFontCacheReleased( const FSlateFontCache& FontCache );
+
+	struct FKey
+	{
+		FSlateFontInfo Font;
+		float Scale;
+
+		bool operator==( const FKey& Other ) const { return Scale == Other.Scale && Font.IsIdenticalTo( Other.Font ); }
+		friend uint32 GetTypeHash( const FKey& Key ) { return HashCombine( GetTypeHash( Key.Font ), GetTypeHash( Key.Scale ) ); }
+	};
+
+	mutable FCriticalSection MetricsLock;
+	TMap<FKey, FBYGFontMetrics> Metrics;
+	FDelegateHandle ReleaseResourcesHandle;
+};
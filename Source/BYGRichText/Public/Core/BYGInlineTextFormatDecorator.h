@@ -20,7 +20,8 @@ class BYGRICHTEXT_API FBYGInlineTextFormatDecorator : public ITextDecorator
 {
 public:
 
-	static TSharedRef< FBYGInlineTextFormatDecorator > Create( FString InRunName, const UBYGRichTextBlock* InOwner );
+	// BlockIndex is the block this decorator creates runs for, used to place runs for the reveal
+	static TSharedRef< FBYGInlineTextFormatDecorator > Create( FString InRunName, const UBYGRichTextBlock* InOwner, int32 InBlockIndex = INDEX_NONE );
 	virtual ~FBYGInlineTextFormatDecorator() {}
 
 	virtual bool Supports( const FTextRunParseResults& RunParseResult, const FString& Text ) const override;
@@ -28,9 +29,21 @@ public:
 
 private:
 
-	FBYGInlineTextFormatDecorator( FString InRunName, const UBYGRichTextBlock* InOwner );
+	FBYGInlineTextFormatDecorator( FString InRunName, const UBYGRichTextBlock* InOwner, int32 InBlockIndex );
+
+	// Work out where the run being created starts within the block, across all of its lines
+	int32 TrackRunOffset( const FTextRunParseResults& RunParseResult, const TSharedRef< FString >& InOutModelText );
+	// Add the run's text to the line, keeping track of the block length for the reveal
+	FTextRange AppendToModel( const TSharedRef< FString >& InOutModelText, const FString& Content );
 
 	FString RunName;
 
 	const class UBYGRichTextBlock* RichTextBlockOwner = nullptr;
+	int32 BlockIndex = INDEX_NONE;
+
+	// Runs are created in order, line by line. These reset when the layout is rebuilt
+	int32 LastOriginalBeginIndex = INDEX_NONE;
+	const FString* CurrentLineModelText = nullptr;
+	int32 CurrentLineLength = 0;
+	int32 CompletedLinesLength = 0;
 };
@@ -0,0 +1,76 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Core/BYGRingBuffer.h"
+#include "UObject/ObjectKey.h"
+
+#include "Core/BYGRichTextLayoutPredictor.h"
+
+class FSlateFontCache;
+
+struct FBYGRichTextLayoutKey
+{
+	TObjectKey<UBYGRichTextStylesheet> Stylesheet;
+	uint32 ParseHash = 0;
+	FString Text;
+	float WrapWidth = 0.0f;
+	float Scale = 1.0f;
+	// See GetSlotValuesHash
+	uint32 SlotValuesHash = 0;
+
+	bool operator==( const FBYGRichTextLayoutKey& Other ) const
+	{
+		return Stylesheet == Other.Stylesheet
+			&& ParseHash == Other.ParseHash
+			&& WrapWidth == Other.WrapWidth
+			&& Scale == Other.Scale
+			&& SlotValuesHash == Other.SlotValuesHash
+			&& Text.Equals( Other.Text, ESearchCase::CaseSensitive );
+	}
+	friend uint32 GetTypeHash( const FBYGRichTextLayoutKey& Key )
+	{
+		uint32 Hash = HashCombine( GetTypeHash( Key.Stylesheet ), Key.ParseHash );
+		Hash = HashCombine( Hash, FCrc::StrCrc32( *Key.Text ) );
+		Hash = HashCombine( Hash, GetTypeHash( Key.WrapWidth ) );
+		Hash = HashCombine( Hash, GetTypeHash( Key.Scale ) );
+		return HashCombine( Hash, Key.SlotValuesHash );
+	}
+
+	// Doesn't depend on the order the values were set in
+	static uint32 GetSlotValuesHash( const TMap<FName, FText>* SlotValues );
+};
+
+// Predicted layouts shared by everything asking about the same text at the same size, e.g. the same
+// label on every card in a shop. Emptied whenever fonts or stylesheets change
+class BYGRICHTEXT_API FBYGRichTextLayoutCache
+{
+public:
+	static FBYGRichTextLayoutCache& Get();
+
+	bool Find( const FBYGRichTextLayoutKey& Key, FBYGPredictedLayout& OutLayout ) const;
+	// Only the most recent MaxCachedLayouts are kept
+	void Add( const FBYGRichTextLayoutKey& Key, const FBYGPredictedLayout& Layout );
+	void Empty();
+	int32 Num() const;
+	// Lookups since startup or the last ResetHitCounts, not reset by Empty
+	void GetHitCounts( int64& OutHits, int64& OutMisses ) const;
+	void ResetHitCounts();
+
+	// Measurements are only valid as long as the font cache they came from
+	void RegisterWithFontCache( FSlateFontCache& FontCache );
+	void UnregisterFromFontCache( FSlateFontCache& FontCache );
+
+protected:
+	void OnFontCacheReleased( const FSlateFontCache& FontCache );
+
+	mutable FCriticalSection LayoutsLock;
+	TMap<FBYGRichTextLayoutKey, FBYGPredictedLayout> Layouts;
+	// Oldest first, so we know what to drop
+	TBYGRingBuffer<FBYGRichTextLayoutKey> LayoutOrder;
+	mutable int64 NumHits = 0;
+	mutable int64 NumMisses = 0;
+	FDelegateHandle ReleaseResourcesHandle;
+};
@@ -0,0 +1,33 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBYGRichTextStylesheet;
+struct FBYGParsedText;
+
+struct FBYGPredictedLayout
+{
+	// Desired size of a UBYGRichTextBlock showing the text in a container of the wrap width, in slate units
+	FVector2D DesiredSize = FVector2D::ZeroVector;
+	// One entry per block, including its margin
+	TArray<float> BlockHeights;
+	TArray<int32> BlockLineCounts;
+};
+
+// Works out how big rich text will be without creating any widgets, e.g. for sizing list rows up front
+// Uses the same parser output and font metrics as the widget, with a simplified version of Slate's line breaking:
+// lines only break after whitespace, trailing whitespace doesn't count towards the width, and inline widgets and
+// icons are never split. Block wrappers like backgrounds are assumed not to add any size
+// Safe to call from worker threads, as long as the stylesheet isn't being edited at the same time
+class BYGRICHTEXT_API FBYGRichTextLayoutPredictor
+{
+public:
+	// Blocks only wrap if their Line Wrapping property says so, like the widget. A WrapWidth of 0 or less never wraps
+	// Slots show their value from SlotValues if there is one, otherwise their placeholder
+	// Results are kept in FBYGRichTextLayoutCache, so asking again about the same text and size is cheap
+	static FBYGPredictedLayout Predict( const FString& Markup, const UBYGRichTextStylesheet* Stylesheet, float WrapWidth, float Scale = 1.0f, const TMap<FName, FText>* SlotValues = nullptr );
+	// For text that has already been parsed, e.g. with FBYGRichTextMarkupParser::ParseFully
+	static FBYGPredictedLayout Predict( const FBYGParsedText& Parsed, const UBYGRichTextStylesheet* Stylesheet, float WrapWidth, float Scale = 1.0f, const TMap<FName, FText>* SlotValues = nullptr );
+};
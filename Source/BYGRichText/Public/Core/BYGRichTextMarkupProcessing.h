@@ -8,10 +8,12 @@
 
 #include "BYGStyleTagData.h"
 
-#include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextParseCache.h"
 
 class UWidget;
 class UBYGRichTextPropertyBase;
+class UBYGRichTextStyle;
+class UBYGRichTextStylesheet;
 
 struct FBYGTextBlockInfo
 {
@@ -26,10 +28,40 @@ struct FBYGTextBlockInfo
 	TArray<FName> StylesApplied;
 	TMap<FString, FString> Payload;
 	TMap<FName, const UBYGRichTextPropertyBase*> BlockPropertiesMap;
+	// {Slot} tokens in this block, so setting a slot value only refreshes the blocks that show it
+	TArray<FName> SlotNames;
 	void OverwriteProperties( const FName& StyleName, const TArray<UBYGRichTextPropertyBase*>& NewBlockProperties );
+	// Fill BlockPropertiesMap from StylesApplied, for blocks that were loaded rather than parsed
+	void ResolveProperties( const UBYGRichTextStylesheet* Stylesheet );
+	// BlockPropertiesMap plus any of the stylesheet's default properties that should always apply
+	TMap<FName, const UBYGRichTextPropertyBase*> GetPropertiesWithDefaults( const UBYGRichTextStylesheet* Stylesheet ) const;
+	// Heap memory owned by the block, not including sizeof( FBYGTextBlockInfo )
+	SIZE_T GetAllocatedSize() const;
 	int32 InlineStyleStackCount = 0;
 };
 
+// Output of the inline parse of a single block: the text the decorators read, and the runs within it
+struct FBYGParsedBlockRuns
+{
+	TArray<FTextLineParseResults> Lines;
+	FString Output;
+
+	SIZE_T GetAllocatedSize() const;
+};
+
+// Everything the parser produces for one input string. Holds no UObject pointers so it can be
+// cached, shared between widgets and written to disk
+struct FBYGParsedText
+{
+	// BlockPropertiesMap is left empty, see FBYGTextBlockInfo::ResolveProperties
+	TArray<FBYGTextBlockInfo> Blocks;
+	// Parallel to Blocks
+	TArray<FBYGParsedBlockRuns> BlockRuns;
+
+	TArray<FName> UsedStyleIDs;
+	TArray<FName> UsedPropertyTypeIDs;
+};
+
 
 // There are two parts to our parser
 // 1) Extracting the block-level formatting info: margins, alignment
@@ -38,18 +70,73 @@ class BYGRICHTEXT_API FBYGRichTextMarkupParser : public IRichTextMarkupParser //
 {
 public:
 	static TSharedRef<FBYGRichTextMarkupParser> Create( class UBYGRichTextBlock* InTextBlockOwner, const FString& XMLElementName );
+	// For parsing without a widget, e.g. when compiling markup offline
+	static TSharedRef<FBYGRichTextMarkupParser> Create( const UBYGRichTextStylesheet* InStylesheet, const FString& XMLElementName );
 
 	virtual void Process( TArray<FTextLineParseResults>& Results, const FString& Input, FString& Output ) override;
 
 	TArray<FBYGTextBlockInfo> SplitIntoBlocks( const FString& Input );
 
+	// Same as SplitIntoBlocks, but shares parser output through FBYGRichTextParseCache with anything
+	// else that has parsed the same text
+	TArray<FBYGTextBlockInfo> ParseBlocks( const FString& Input );
+	// Run both parsing passes over the whole input, producing something that can be cached
+	TSharedRef<FBYGParsedText> ParseFully( const FString& Input );
+
+	// Changes whenever anything that affects the parser output changes: stylesheet structure,
+	// delimiter settings, element name. Pre-parsed output is only valid for the same hash
+	uint32 GetParseHash() const;
+
+	const UBYGRichTextStylesheet* GetStylesheet() const;
+
+	// Styles and property types used by everything parsed since the last call to SplitIntoBlocks
+	const TSet<FName>& GetUsedStyleIDs() const { return UsedStyleIDs; }
+	const TSet<FName>& GetUsedPropertyTypeIDs() const { return UsedPropertyTypeIDs; }
+
+	// Heap memory owned by this parser. Output shared through the parse cache isn't counted
+	SIZE_T GetAllocatedSize() const;
+
 protected:
-	FBYGRichTextMarkupParser( class UBYGRichTextBlock* TextBlockOwner, const FString& InXMLElementName );
+	FBYGRichTextMarkupParser( class UBYGRichTextBlock* TextBlockOwner, const UBYGRichTextStylesheet* InStylesheet, const FString& InXMLElementName );
 
+	// The inline pass on its own: our markup for one block to the XML FDefaultRichTextMarkupParser reads
+	// Builds into buffers kept between calls, so once warm it only allocates for the returned string
 	FString ConvertInputToInlineXML( const FString& Input );
+	// Process without looking in or adding to ProcessedInputs
+	void ProcessUncached( TArray<FTextLineParseResults>& Results, const FString& Input, FString& Output );
+
+	// Specialized on the delimiters from UBYGRichTextRuntimeSettings, see BYGDelimiters.h
+	template <typename DelimitersType>
+	TArray<FBYGTextBlockInfo> SplitIntoBlocks( const FString& Input, const DelimitersType& Delimiters );
+	template <typename DelimitersType>
+	FString ConvertInputToInlineXML( const FString& Input, const DelimitersType& Delimiters );
+
+	// Use parsed output instead of parsing, as if we had just parsed it ourselves
+	void ApplyParsedText( const TSharedRef<const FBYGParsedText>& Parsed );
+
+	void RecordStyleUsage( const UBYGRichTextStyle* Style );
+	void RecordPropertyUsage( const UBYGRichTextPropertyBase* Prop );
 
 	class UBYGRichTextBlock* TextBlockOwner = nullptr;
+	const UBYGRichTextStylesheet* Stylesheet = nullptr;
 	FString XMLElementName = "";
+
+	TSet<FName> UsedStyleIDs;
+	TSet<FName> UsedPropertyTypeIDs;
+
+	// Output of Process for each input we've seen. Restyling only re-runs the decorators, and the
+	// marshaller calls Process again with the same input, so we can skip the tokenizing
+	TMap<FString, FBYGParsedBlockRuns, FDefaultSetAllocator, TBYGCaseSensitiveKeyFuncs<FBYGParsedBlockRuns>> ProcessedInputs;
+	// Shared output from the parse cache, read instead of copying it into ProcessedInputs
+	TSharedPtr<const FBYGParsedText> SharedParsed;
+
+	// Reused by ConvertInputToInlineXML, see there
+	FString InlineXMLBuffer;
+	FString TokenBuffer;
+
+	// Tests that read the inline pass on its own
+	friend class FBYGRichTextParseSlotsTest;
+	friend class FBYGRichTextParseAllocationsTest;
 };
 
 
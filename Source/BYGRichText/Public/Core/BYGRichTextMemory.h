@@ -0,0 +1,13 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/LowLevelMemStats.h"
+
+// Everything allocated while parsing markup, creating runs and caching icons shows up under
+// BYGRichText in LLM captures (-llm), instead of being spread across UI and EngineMisc
+DECLARE_LLM_MEMORY_STAT_EXTERN( TEXT( "BYGRichText" ), STAT_BYGRichTextLLM, STATGROUP_LLMFULL, BYGRICHTEXT_API );
+
+#define BYG_RICHTEXT_LLM_SCOPE() LLM_SCOPED_TAG_WITH_STAT( STAT_BYGRichTextLLM, ELLMTracker::Default )
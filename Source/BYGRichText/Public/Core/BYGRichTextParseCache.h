@@ -0,0 +1,68 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Core/BYGRingBuffer.h"
+
+struct FBYGParsedText;
+
+// Parsed output depends on case (e.g. the text itself), so unlike TMap<FString> the keys must match exactly
+template <typename ValueType>
+struct TBYGCaseSensitiveKeyFuncs : BaseKeyFuncs<TPair<FString, ValueType>, FString, false>
+{
+	static const FString& GetSetKey( const TPair<FString, ValueType>& Element ) { return Element.Key; }
+	static bool Matches( const FString& A, const FString& B ) { return A.Equals( B, ESearchCase::CaseSensitive ); }
+	static uint32 GetKeyHash( const FString& Key ) { return FCrc::StrCrc32( *Key ); }
+};
+
+using FBYGParsedTextMap = TMap<FString, TSharedRef<const FBYGParsedText>, FDefaultSetAllocator, TBYGCaseSensitiveKeyFuncs<TSharedRef<const FBYGParsedText>>>;
+using FBYGCompiledMarkupMap = TMap<FString, TSharedRef<FBYGParsedText>, FDefaultSetAllocator, TBYGCaseSensitiveKeyFuncs<TSharedRef<FBYGParsedText>>>;
+
+enum class EBYGCompiledMarkupVersion : int32
+{
+	Initial = 1,
+	SlotNames,
+
+	// Add new versions above here
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+// Holds parser output keyed by the parse hash it was made with and the source text
+// Filled from markup compiled offline by UBYGRichTextCompileMarkupCommandlet, so shipped strings
+// can skip parsing at runtime. Text parsed live is added too, so every widget showing the same
+// text shares one copy of the parser output
+class BYGRICHTEXT_API FBYGRichTextParseCache
+{
+public:
+	static FBYGRichTextParseCache& Get();
+
+	TSharedPtr<const FBYGParsedText> Find( uint32 ParseHash, const FString& Text ) const;
+	void Add( uint32 ParseHash, const FString& Text, TSharedRef<const FBYGParsedText> Parsed );
+	// Parsed at runtime rather than compiled. Only the most recent MaxSharedParsedTexts are kept
+	void AddShared( uint32 ParseHash, const FString& Text, TSharedRef<const FBYGParsedText> Parsed );
+	void Empty();
+	// Only what was parsed at runtime, compiled markup can't be parsed again without the commandlet
+	void EmptyShared();
+	int32 Num() const;
+	int32 NumShared() const;
+	// Lookups since startup or the last ResetHitCounts
+	void GetHitCounts( int64& OutHits, int64& OutMisses ) const;
+	void ResetHitCounts();
+
+	// Returns false if the file is missing, from a different version or corrupt
+	bool LoadCompiledFile( const FString& Filename );
+	static bool SaveCompiledFile( const FString& Filename, const FString& StylesheetPath, uint32 ParseHash, const FBYGCompiledMarkupMap& Entries );
+
+protected:
+	mutable FCriticalSection CacheLock;
+	TMap<uint32, FBYGParsedTextMap> Entries;
+	TMap<uint32, FBYGParsedTextMap> SharedEntries;
+	// Oldest first, so we know what to drop
+	TBYGRingBuffer<TPair<uint32, FString>> SharedOrder;
+
+	mutable int64 NumHits = 0;
+	mutable int64 NumMisses = 0;
+};
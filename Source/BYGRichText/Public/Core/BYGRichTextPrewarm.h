@@ -0,0 +1,23 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+class UBYGRichTextStylesheet;
+
+// Parses text ahead of time, e.g. behind a loading screen, so the first time a menu opens its widgets
+// find their parser output in FBYGRichTextParseCache instead of parsing on the game thread
+// Call on the game thread, the work happens on the thread pool. The stylesheet is kept alive until it's done,
+// and editing it before the future is ready is fatal, see UBYGRichTextStylesheet::IsPrewarming
+class BYGRICHTEXT_API FBYGRichTextPrewarm
+{
+public:
+	// With bPredictLayout, layouts at WrapWidth and Scale are worked out too, filling FBYGRichTextLayoutCache
+	// and the font metrics cache, see FBYGRichTextLayoutPredictor
+	// Only the most recent MaxSharedParsedTexts stay cached, so warm what's about to be shown rather than everything
+	static TFuture<void> PrewarmTexts( const UBYGRichTextStylesheet* Stylesheet, const TArray<FText>& Texts, bool bPredictLayout = false, float WrapWidth = 0.0f, float Scale = 1.0f );
+	// Every entry of each string table, in the current culture. The tables must already be loaded
+	static TFuture<void> PrewarmStringTables( const UBYGRichTextStylesheet* Stylesheet, const TArray<FName>& TableIds, bool bPredictLayout = false, float WrapWidth = 0.0f, float Scale = 1.0f );
+};
@@ -0,0 +1,45 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/BYGRingBuffer.h"
+
+enum class EBYGRunType : uint8
+{
+	Text,
+	Widget,
+	Image,
+};
+
+// What a UBYGRichTextBlock has built and how long it took, reported by the BYGRichText.* console commands
+// Shared with the decorators so they can count the runs they create
+class BYGRICHTEXT_API FBYGRichTextBlockStats
+{
+public:
+	// Same as FBYGRevealState, run counts are per block because blocks are laid out again separately
+	void ResetBlocks( int32 NumBlocks );
+	void ClearBlock( int32 BlockIndex );
+	void AddRun( int32 BlockIndex, EBYGRunType Type );
+	int32 GetNumRuns( EBYGRunType Type ) const;
+
+	void AddRebuild( double StartTime, double Duration );
+	int32 GetNumRebuilds() const { return NumRebuilds; }
+	double GetTotalRebuildSeconds() const { return TotalRebuildSeconds; }
+	// Only the last MaxRecentRebuilds are kept, which is plenty for finding widgets rebuilding every frame
+	void GetRebuildsSince( double Time, int32& OutCount, double& OutSeconds ) const;
+
+	static const int32 MaxRecentRebuilds = 64;
+
+protected:
+	struct FBlockRuns
+	{
+		int32 Counts[ 3 ] = { 0, 0, 0 };
+	};
+	TArray<FBlockRuns> BlockRuns;
+
+	int32 NumRebuilds = 0;
+	double TotalRebuildSeconds = 0.0;
+	// Start time and duration, oldest first
+	TBYGRingBuffer<TPair<double, double>> RecentRebuilds;
+};
@@ -0,0 +1,76 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Oldest-first queue for the caches' eviction order. Adding and dropping the oldest are O(1), where
+// TArray::RemoveAt( 0 ) moves everything after it down on every insert once a cache is full
+// Grows like a TArray, so the capacity settles at the largest size a cache was allowed to reach
+template<typename ElementType>
+class TBYGRingBuffer
+{
+public:
+	int32 Num() const { return Count; }
+
+	void Add( ElementType&& Element )
+	{
+		if ( Count == Elements.Num() )
+		{
+			Grow();
+		}
+		Elements[ ( Head + Count ) % Elements.Num() ] = MoveTemp( Element );
+		++Count;
+	}
+	void Add( const ElementType& Element )
+	{
+		Add( ElementType( Element ) );
+	}
+
+	// 0 is the oldest
+	const ElementType& operator[]( int32 Index ) const
+	{
+		check( Index >= 0 && Index < Count );
+		return Elements[ ( Head + Index ) % Elements.Num() ];
+	}
+
+	const ElementType& First() const
+	{
+		return ( *this )[ 0 ];
+	}
+
+	void PopFirst()
+	{
+		check( Count > 0 );
+		// Let go of whatever it holds now rather than when the slot is reused
+		Elements[ Head ] = ElementType();
+		Head = ( Head + 1 ) % Elements.Num();
+		--Count;
+	}
+
+	void Empty()
+	{
+		Elements.Empty();
+		Head = 0;
+		Count = 0;
+	}
+
+	SIZE_T GetAllocatedSize() const { return Elements.GetAllocatedSize(); }
+
+protected:
+	void Grow()
+	{
+		TArray<ElementType> Grown;
+		Grown.SetNum( FMath::Max( 8, Elements.Num() * 2 ) );
+		for ( int32 i = 0; i < Count; ++i )
+		{
+			Grown[ i ] = MoveTemp( Elements[ ( Head + i ) % Elements.Num() ] );
+		}
+		Elements = MoveTemp( Grown );
+		Head = 0;
+	}
+
+	TArray<ElementType> Elements;
+	int32 Head = 0;
+	int32 Count = 0;
+};
@@ -2,16 +2,22 @@
 
 #pragma once
 
+#include "CoreMinimal.h"
+
 #include "BYGStyleTagData.generated.h"
 
+// What a style tag in the markup carried, e.g. passed to tooltips and OnRunClicked
 USTRUCT( BlueprintType )
-struct FBYGStyleTagData
+struct BYGRICHTEXT_API FBYGStyleTagData
 {
 	GENERATED_BODY()
 
 public:
-	FString ID;
-	FString Content;
-	TMap<FString, FString> Pairs;
+	UPROPERTY( BlueprintReadOnly, Category = "Rich Text" )
+		FString ID;
+	UPROPERTY( BlueprintReadOnly, Category = "Rich Text" )
+		FString Content;
+	UPROPERTY( BlueprintReadOnly, Category = "Rich Text" )
+		TMap<FString, FString> Pairs;
 };
 
@@ -0,0 +1,35 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Fonts/SlateFontInfo.h"
+
+class FSlateFontMeasure;
+
+// Font measurement without going through FSlateApplication, so layout maths can run in commandlets,
+// under -nullrhi, in tests and off the game thread
+class BYGRICHTEXT_API IBYGTextMeasure
+{
+public:
+	virtual ~IBYGTextMeasure() {}
+
+	virtual FVector2D Measure( const FString& Text, int32 BeginIndex, int32 EndIndex, const FSlateFontInfo& Font, float Scale = 1.0f ) const = 0;
+	FVector2D Measure( const FString& Text, const FSlateFontInfo& Font, float Scale = 1.0f ) const { return Measure( Text, 0, Text.Len(), Font, Scale ); }
+
+	virtual int16 GetBaseline( const FSlateFontInfo& Font, float Scale = 1.0f ) const = 0;
+	virtual uint16 GetMaxCharacterHeight( const FSlateFontInfo& Font, float Scale = 1.0f ) const = 0;
+};
+
+class BYGRICHTEXT_API FBYGTextMeasure
+{
+public:
+	// The renderer's measure service when we're on the game thread and have one, otherwise the headless one
+	static TSharedRef<IBYGTextMeasure> Get();
+
+	// Measures with FreeType through a private font cache that never creates textures. Safe from any thread
+	static TSharedRef<IBYGTextMeasure> GetHeadless();
+
+	// Release the headless font cache and the renderer's measure, called when the module shuts down
+	static void Shutdown();
+};
@@ -0,0 +1,162 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Framework/Text/SlateTextRun.h"
+#include "Framework/Text/SlateWidgetRun.h"
+#include "Framework/Text/SlateImageRun.h"
+#include "Layout/Margin.h"
+#include "Types/SlateEnums.h"
+#include "GenericPlatform/ICursor.h"
+#include "Core/BYGStyleTagData.h"
+
+struct FSlateBrush;
+class UBYGRichTextPropertyBase;
+
+// How much of a UBYGRichTextBlock is visible, shared by all of its runs so revealing more only repaints
+// Characters are counted over the model text of each block in order, excluding line breaks
+// Inline widgets count as a single character
+class BYGRICHTEXT_API FBYGRevealState
+{
+public:
+	// Called when the contents are rebuilt, lengths are filled in again as the runs are created
+	void ResetBlocks( int32 NumBlocks );
+	// Runs report where they end, so we know the length of each block once it's laid out
+	void ExtendBlock( int32 BlockIndex, int32 LocalEnd );
+	// When a block is laid out again, its length can change (e.g. a new slot value)
+	void ClearBlock( int32 BlockIndex );
+
+	int32 GetBlockStart( int32 BlockIndex ) const;
+	int32 GetBlockLength( int32 BlockIndex ) const;
+	int32 GetTotalCount() const;
+
+	// INDEX_NONE shows everything
+	void SetRevealedCount( int32 Count );
+	// 0-1 of the total, resolved against the laid out length so it stays correct before layout has happened
+	void SetRevealedFraction( float Fraction );
+
+	bool IsRevealingAll() const { return RevealedCount == INDEX_NONE && RevealedFraction < 0.0f; }
+	int32 GetRevealedCount() const;
+
+protected:
+	TArray<int32> BlockLengths;
+	int32 RevealedCount = INDEX_NONE;
+	float RevealedFraction = -1.0f;
+};
+
+// Where a run sits within its block, so it can work out how much of itself to draw
+struct FBYGRunRevealInfo
+{
+	TSharedPtr<const FBYGRevealState> RevealState;
+	int32 BlockIndex = INDEX_NONE;
+	// Offset of the start of this run within its block, in model characters
+	int32 LocalOffset = 0;
+
+	// Number of characters starting at RangeBegin (relative to the run) that are visible
+	int32 GetVisibleCount( int32 RunBeginIndex, int32 RangeBegin, int32 RangeEnd ) const;
+};
+
+// A brush painted by a text run behind its glyphs, aligned within each laid out block of the run
+struct FBYGRunBrushInfo
+{
+	const FSlateBrush* Brush = nullptr;
+	EHorizontalAlignment HAlign = HAlign_Fill;
+	EVerticalAlignment VAlign = VAlign_Fill;
+	FMargin Padding;
+	// Make the run at least as big as the brush, for icons rather than highlights
+	bool bSizeToBrush = false;
+
+	// Where the brush is drawn within a box, following the same rules as an SOverlay slot
+	void GetBrushRect( const FVector2D& BoxSize, FVector2D& OutOffset, FVector2D& OutSize ) const;
+};
+
+// What a run does when the mouse is over it, e.g. show a tooltip or act as a link
+struct FBYGRunInteraction
+{
+	// Content and payload of the run, the same as an inline tooltip widget would be given
+	FBYGStyleTagData Data;
+	// Weak as the runs can outlive a stylesheet edit that replaces them, until the block is rebuilt
+	TArray<TWeakObjectPtr<const UBYGRichTextPropertyBase>> Properties;
+	int32 BlockIndex = INDEX_NONE;
+	bool bClickable = false;
+	EMouseCursor::Type Cursor = EMouseCursor::Default;
+};
+
+// Where interactive runs were last painted, so hovering and clicking them doesn't need a widget per run
+// Runs add themselves as they paint, and the widget painting them resets it first
+// Rects are kept in the widget's local space so they stay correct if it moves without repainting
+class BYGRICHTEXT_API FBYGRunHitTestIndex
+{
+public:
+	void Reset( const FGeometry& InPaintGeometry );
+	// Offset and Size are in the local space of RunGeometry, e.g. a block of a laid out run
+	void AddRun( const FGeometry& RunGeometry, const FVector2D& Offset, const FVector2D& Size, const TSharedRef<const FBYGRunInteraction>& Interaction );
+	TSharedPtr<const FBYGRunInteraction> FindRun( const FGeometry& WidgetGeometry, const FVector2D& ScreenPosition ) const;
+	int32 Num() const { return Entries.Num(); }
+	SIZE_T GetAllocatedSize() const { return Entries.GetAllocatedSize(); }
+
+protected:
+	struct FEntry
+	{
+		FSlateRect Rect;
+		TSharedPtr<const FBYGRunInteraction> Interaction;
+	};
+	TArray<FEntry> Entries;
+	FGeometry PaintGeometry;
+};
+
+// Text run that clips itself to the revealed characters at paint time, and can paint brushes behind itself
+// so backgrounds and inline images don't need a nested widget and text layout
+class BYGRICHTEXT_API FBYGTextRun : public FSlateTextRun
+{
+public:
+	// Interactive runs add themselves to HitTestIndex each time they're painted
+	static TSharedRef<FBYGTextRun> Create( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FTextBlockStyle& Style, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo, const TArray<FBYGRunBrushInfo>& InBrushes = TArray<FBYGRunBrushInfo>(), const TSharedPtr<const FBYGRunInteraction>& InInteraction = nullptr, const TSharedPtr<FBYGRunHitTestIndex>& InHitTestIndex = nullptr );
+
+	virtual FVector2D Measure( int32 StartIndex, int32 EndIndex, float Scale, const FRunTextContext& TextContext ) const override;
+	virtual int16 GetMaxHeight( float Scale ) const override;
+	virtual int16 GetBaseLine( float Scale ) const override;
+
+	virtual int32 OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const override;
+
+protected:
+	FBYGTextRun( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FTextBlockStyle& InStyle, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo, const TArray<FBYGRunBrushInfo>& InBrushes, const TSharedPtr<const FBYGRunInteraction>& InInteraction, const TSharedPtr<FBYGRunHitTestIndex>& InHitTestIndex );
+
+	int32 PaintBrushes( const TSharedRef<ILayoutBlock>& Block, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const;
+	// Largest size any sized-to-brush brush needs, in layout units
+	FVector2D GetBrushMinSize( float Scale ) const;
+
+	FBYGRunRevealInfo RevealInfo;
+	TArray<FBYGRunBrushInfo> Brushes;
+	TSharedPtr<const FBYGRunInteraction> Interaction;
+	TSharedPtr<FBYGRunHitTestIndex> HitTestIndex;
+};
+
+// Widget run that stays hidden until the reveal reaches it
+class BYGRICHTEXT_API FBYGWidgetRun : public FSlateWidgetRun
+{
+public:
+	static TSharedRef<FBYGWidgetRun> Create( const TSharedRef<FTextLayout>& TextLayout, const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FWidgetRunInfo& InWidgetInfo, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo );
+
+	virtual int32 OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const override;
+
+protected:
+	FBYGWidgetRun( const TSharedRef<FTextLayout>& TextLayout, const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FWidgetRunInfo& InWidgetInfo, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo );
+
+	FBYGRunRevealInfo RevealInfo;
+};
+
+// Image run for icons with no text, so they need no widgets at all
+class BYGRICHTEXT_API FBYGImageRun : public FSlateImageRun
+{
+public:
+	static TSharedRef<FBYGImageRun> Create( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FSlateBrush* InImage, int16 InBaseline, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo );
+
+	virtual int32 OnPaint( const FPaintArgs& Args, const FTextLayout::FLineView& Line, const TSharedRef<ILayoutBlock>& Block, const FTextBlockStyle& DefaultStyle, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const override;
+
+protected:
+	FBYGImageRun( const FRunInfo& InRunInfo, const TSharedRef<const FString>& InText, const FSlateBrush* InImage, int16 InBaseline, const FTextRange& InRange, const FBYGRunRevealInfo& InRevealInfo );
+
+	FBYGRunRevealInfo RevealInfo;
+};
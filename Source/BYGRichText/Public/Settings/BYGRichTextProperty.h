@@ -10,6 +10,7 @@
 #include "Internationalization/TextTransformer.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "Widgets/Images/SImage.h"
+#include "Widgets/Layout/SBox.h"
 #include "Widgets/SOverlay.h"
 #include "Widgets/Text/SRichTextBlock.h"
 #include "BYGRichTextModule.h"
@@ -27,6 +28,19 @@ enum class EBYGBrushLocationType
 
 DECLARE_DELEGATE( FBYGOnPropertyPropertyChangedSignature );
 
+class UBYGRichTextStylesheet;
+
+// Block-level layout settings as plain data, mirroring what ApplyToTextBlock sets on an SRichTextBlock
+// Defaults match an SRichTextBlock that has had nothing applied
+struct FBYGBlockLayoutStyle
+{
+	FMargin Margin;
+	float LineHeightPercentage = 1.0f;
+	bool bAutoWrap = false;
+	ETextWrappingPolicy WrappingPolicy = ETextWrappingPolicy::DefaultWrapping;
+	ETextJustify::Type Justification = ETextJustify::Left;
+};
+
 UCLASS( Abstract )
 class BYGRICHTEXT_API UBYGRichTextPropertyBase : public UObject
 {
@@ -39,8 +53,14 @@ public:
 	// Block only
 	virtual void ApplyToTextBlock( TSharedRef<SRichTextBlock>& TextBlock ) const {}
 	virtual TSharedRef<SWidget> WrapBlock( TSharedRef<SWidget>& Widget, UBYGRichTextBlock* OuterBlock, const TMap<FString, FString>& Payload ) const { return Widget; }
+	// Same as ApplyToTextBlock but without a widget, so layout can be worked out ahead of time
+	virtual void ApplyToBlockStyle( FBYGBlockLayoutStyle& Style ) const {}
 	// Inline only
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const {}
+	// Brush for the text run to paint itself, instead of wrapping the run in a widget
+	virtual bool GetRunBrush( const TMap<FString, FString>& Payload, FBYGRunBrushInfo& OutBrushInfo ) const { return false; }
+	// Smallest size the run needs for its brush including padding, without loading anything so it's safe off the game thread
+	virtual FVector2D GetRunMinSize( const TMap<FString, FString>& Payload ) const { return FVector2D::ZeroVector; }
 	// Some properties can only be applied to Block, some to Inline, some to both.
 	virtual bool GetSupportsDisplayType( EBYGStyleDisplayType Style ) const { return true; }
 
@@ -48,26 +68,48 @@ public:
 	// Useful for providing sensible defaults for new users. e.g. seeing text in a default typeface rather than broken glyphs
 	bool GetShouldApplyToDefault() const { return bShouldApplyToDefault; }
 	virtual bool RequiresInlineTextBlock() const { return false; }
+	// True if WrapBlock needs the block to be a real widget, rather than something drawn like GetRunBrush
+	virtual bool RequiresBlockWidget() const { return false; }
+	// Inline runs using interactive properties respond to the mouse without needing a widget. The widget finds
+	// the run under the mouse and asks its properties for a tooltip, or reports clicks through OnRunClicked
+	virtual bool IsRunInteractive() const { return false; }
+	virtual TSharedPtr<IToolTip> CreateRunToolTip( UBYGRichTextBlock* OuterBlock, const FBYGStyleTagData& Data ) const { return nullptr; }
+	virtual bool IsRunClickable() const { return false; }
+	virtual EMouseCursor::Type GetRunCursor() const { return EMouseCursor::Default; }
+	// True if this property only changes the FTextBlockStyle of inline runs. Editing it restyles existing
+	// runs instead of reparsing the markup and rebuilding the widget
+	virtual bool AffectsTextStyleOnly() const { return false; }
 
 	// We have to use this, and not GetClass()->GetFName() because BP-defined instances of properties were returning different names
 	// and we need this as a "unique" identifier of this "class" of property
 	// Maybe there's a better way of doing this, this will have to do for now.
 	virtual FName GetTypeID() const { return TypeID; }
 
+	// Covers everything about this property that changes the parser output. Properties that
+	// modify the string in TransformString must include those settings too
+	// The inline ID is made from the owning style's ID and our type, which the stylesheet hashes already
+	virtual uint32 GetParseHash() const
+	{
+		return FCrc::StrCrc32( *GetTypeID().ToString() );
+	}
+
 	// This is something we can used to uniquely identify a property, it is generated by the system, you don't need to touch it
-	FString GetInlineID() const
+	// Written into the parser output, e.g. "strong.TextColor", or only the type for the stylesheet's default properties
+	// Doesn't depend on the order of anything, so parsed text stays valid for any stylesheet with the same styles
+	const FString& GetInlineID() const
 	{
 		ensure( !CachedInlineID.IsEmpty() );
 		return CachedInlineID;
 	}
 	// Because mutable
-	void SetInlineID( int32 InID ) const
+	void SetInlineID( int32 InID, const FName& StyleID ) const
 	{
-		if ( InID == InlineID ) return;
 		InlineID = InID;
 		ensure( InlineID != INDEX_NONE );
-		CachedInlineID = FString::Printf( TEXT( "%d" ), InlineID );
+		CachedInlineID = StyleID.IsNone() ? GetTypeID().ToString() : FString::Printf( TEXT( "%s.%s" ), *StyleID.ToString(), *GetTypeID().ToString() );
 	}
+	// Set by the stylesheet when it looks us up, so setters can tell it about runtime changes
+	void SetOwner( const UBYGRichTextStylesheet* InStylesheet, const FName& InStyleID ) const;
 
 	void BeginDestroy() override;
 
@@ -81,6 +123,10 @@ public:
 #endif
 
 protected:
+	// Called by setters, drops anything the owning stylesheet cached from our old values. Editor
+	// changes go through PostEditChangeProperty instead
+	void NotifyValueChanged();
+
 	bool bShouldApplyToDefault = false;
 	// Wuff, mutable here is stinky code
 	UPROPERTY()
@@ -89,6 +135,9 @@ protected:
 	UPROPERTY()
 		mutable FString CachedInlineID;
 	FName TypeID = FName("Base");
+	mutable TWeakObjectPtr<const UBYGRichTextStylesheet> OwningStylesheet;
+	// None for the stylesheet's default properties
+	mutable FName OwningStyleID;
 
 	friend class FBYGRichTextStyleCustomization;
 	friend class FBYGRichTextStylesheetIDs;
@@ -108,11 +157,12 @@ public:
 		bShouldApplyToDefault = true;
 		TypeID = "TextColor";
 	}
+	virtual bool AffectsTextStyleOnly() const override { return true; }
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const
 	{
 		Style.SetColorAndOpacity( TextColor );
 	}
-	void SetColor( const FLinearColor& InTextColor ) { TextColor = InTextColor; }
+	void SetColor( const FLinearColor& InTextColor ) { TextColor = InTextColor; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -139,12 +189,13 @@ public:
 			ensure(FontObject);
 		}
 	}
+	virtual bool AffectsTextStyleOnly() const override { return true; }
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const
 	{
 		Style.Font.FontObject = FontObject;
 	}
 
-	void SetFont( const UObject* InFont ) { FontObject = InFont; }
+	void SetFont( const UObject* InFont ) { FontObject = InFont; NotifyValueChanged(); }
 
 
 protected:
@@ -165,12 +216,13 @@ public:
 	{
 		TypeID = "TypeVariant";
 	}
+	virtual bool AffectsTextStyleOnly() const override { return true; }
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const
 	{
 		Style.SetTypefaceFontName( TypefaceFontName );
 	}
 
-	void SetName( const FName& InName ) { TypefaceFontName = InName; }
+	void SetName( const FName& InName ) { TypefaceFontName = InName; NotifyValueChanged(); }
 	FName GetName() const { return TypefaceFontName; }
 
 protected:
@@ -202,12 +254,13 @@ public:
 		bShouldApplyToDefault = true;
 		TypeID = "Size";
 	}
+	virtual bool AffectsTextStyleOnly() const override { return true; }
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const
 	{
 		Style.SetFontSize( Size );
 	}
 
-	void SetSize( uint16 InSize ) { Size = InSize; }
+	void SetSize( uint16 InSize ) { Size = InSize; NotifyValueChanged(); }
 	uint16 GetSize() const { return Size; }
 
 protected:
@@ -240,7 +293,11 @@ public:
 			Str = FTextTransformer::ToLower( Str );
 		}
 	}
-	void SetCase( ETextTransformPolicy InCase ) { Case = InCase; }
+	virtual uint32 GetParseHash() const override
+	{
+		return HashCombine( Super::GetParseHash(), GetTypeHash( static_cast<uint8>( Case ) ) );
+	}
+	void SetCase( ETextTransformPolicy InCase ) { Case = InCase; NotifyValueChanged(); }
 	ETextTransformPolicy GetCase() const { return Case; }
 
 protected:
@@ -261,14 +318,15 @@ public:
 	{
 		TypeID = "Shadow";
 	}
+	virtual bool AffectsTextStyleOnly() const override { return true; }
 	virtual void ApplyToTextStyle( FTextBlockStyle& Style ) const
 	{
 		Style.SetShadowColorAndOpacity( ShadowColor );
 		Style.SetShadowOffset( ShadowOffset );
 	}
 
-	void SetColor( const FLinearColor& InShadowColor ) { ShadowColor = InShadowColor; }
-	void SetOffset( const FIntPoint& InShadowOffset ) { ShadowOffset = InShadowOffset; }
+	void SetColor( const FLinearColor& InShadowColor ) { ShadowColor = InShadowColor; NotifyValueChanged(); }
+	void SetOffset( const FIntPoint& InShadowOffset ) { ShadowOffset = InShadowOffset; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -295,8 +353,12 @@ public:
 	{
 		TextBlock->SetJustification( Justification );
 	}
+	virtual void ApplyToBlockStyle( FBYGBlockLayoutStyle& Style ) const override
+	{
+		Style.Justification = Justification;
+	}
 
-	void SetJustification( TEnumAsByte<ETextJustify::Type> InJustification ) { Justification = InJustification; }
+	void SetJustification( TEnumAsByte<ETextJustify::Type> InJustification ) { Justification = InJustification; NotifyValueChanged(); }
 	virtual bool GetSupportsDisplayType( EBYGStyleDisplayType Style ) const override { return Style == EBYGStyleDisplayType::Block; }
 
 //protected:
@@ -321,8 +383,12 @@ public:
 	{
 		TextBlock->SetMargin( Margin );
 	}
+	virtual void ApplyToBlockStyle( FBYGBlockLayoutStyle& Style ) const override
+	{
+		Style.Margin = Margin;
+	}
 
-	void SetMargin( const FMargin& InMargin ) { Margin = InMargin; }
+	void SetMargin( const FMargin& InMargin ) { Margin = InMargin; NotifyValueChanged(); }
 	FMargin GetMargin() const { return Margin; }
 
 protected:
@@ -346,8 +412,12 @@ public:
 	{
 		TextBlock->SetLineHeightPercentage( LineHeight );
 	}
+	virtual void ApplyToBlockStyle( FBYGBlockLayoutStyle& Style ) const override
+	{
+		Style.LineHeightPercentage = LineHeight;
+	}
 
-	void SetLineHeight( float InLineHeight ) { LineHeight = InLineHeight; }
+	void SetLineHeight( float InLineHeight ) { LineHeight = InLineHeight; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -371,8 +441,13 @@ public:
 		TextBlock->SetWrappingPolicy( WrappingPolicy );
 		TextBlock->SetAutoWrapText( bAutoWrap );
 	}
-	void SetAutoWrap( bool bInAutoWrap ) { bAutoWrap = bInAutoWrap; }
-	void SetTextWrappingPolicy( ETextWrappingPolicy InWrappingPolicy ) { WrappingPolicy = InWrappingPolicy; }
+	virtual void ApplyToBlockStyle( FBYGBlockLayoutStyle& Style ) const override
+	{
+		Style.WrappingPolicy = WrappingPolicy;
+		Style.bAutoWrap = bAutoWrap;
+	}
+	void SetAutoWrap( bool bInAutoWrap ) { bAutoWrap = bInAutoWrap; NotifyValueChanged(); }
+	void SetTextWrappingPolicy( ETextWrappingPolicy InWrappingPolicy ) { WrappingPolicy = InWrappingPolicy; NotifyValueChanged(); }
 	virtual bool GetSupportsDisplayType( EBYGStyleDisplayType Style ) const override { return Style == EBYGStyleDisplayType::Block; }
 
 protected:
@@ -420,12 +495,20 @@ public:
 		return NewOverlay;
 	}
 
-	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; }
-	void SetHAlign( TEnumAsByte<EHorizontalAlignment> InImageHAlign ) { ImageHAlign = InImageHAlign; }
-	void SetVAlign( TEnumAsByte<EVerticalAlignment> InImageVAlign ) { ImageVAlign = InImageVAlign; }
-	void SetMargin( const FMargin& InImagePadding ) { ImagePadding = InImagePadding; }
+	virtual bool GetRunBrush( const TMap<FString, FString>& Payload, FBYGRunBrushInfo& OutBrushInfo ) const override
+	{
+		OutBrushInfo.Brush = &Brush;
+		OutBrushInfo.HAlign = ImageHAlign;
+		OutBrushInfo.VAlign = ImageVAlign;
+		OutBrushInfo.Padding = ImagePadding;
+		return true;
+	}
+
+	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; NotifyValueChanged(); }
+	void SetHAlign( TEnumAsByte<EHorizontalAlignment> InImageHAlign ) { ImageHAlign = InImageHAlign; NotifyValueChanged(); }
+	void SetVAlign( TEnumAsByte<EVerticalAlignment> InImageVAlign ) { ImageVAlign = InImageVAlign; NotifyValueChanged(); }
+	void SetMargin( const FMargin& InImagePadding ) { ImagePadding = InImagePadding; NotifyValueChanged(); }
 
-	virtual bool RequiresInlineTextBlock() const { return true; }
 protected:
 	UPROPERTY( EditAnywhere )
 		EBYGBrushLocationType BrushLocationType = EBYGBrushLocationType::Single;
@@ -474,7 +557,7 @@ public:
 	{
 		TypeID = "InlineBrush";
 	}
-	virtual TSharedRef<SWidget> WrapBlock( TSharedRef<SWidget>& TextBlock, UBYGRichTextBlock* OuterBlock, const TMap<FString, FString>& Payload ) const override
+	const FSlateBrush* ResolveBrush( const TMap<FString, FString>& Payload ) const
 	{
 		const FSlateBrush* BrushToUse = &Brush;
 		if ( BrushLocationType == EBYGBrushLocationType::Folder )
@@ -482,7 +565,7 @@ public:
 			// Find the file from the img payload
 			FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
 			// GetIconBrush will return a null brush if the icon is not found at this path
-			const FVector2D Size = FVector2D( 20, 20 );
+			const FVector2D Size = FolderIconSize;
 			
 			FString DirName = BrushDirectory.Path;
 			if ( !DirName.EndsWith( "/" ) )
@@ -492,6 +575,28 @@ public:
 			const FString PayloadImgName = Payload.Contains( "img" ) ? Payload[ "img" ] : "";
 			BrushToUse = RichTextModule.GetIconBrush( FString::Printf( TEXT( "%s%s%s%s.%s%s%s" ), *DirName, *Prefix, *PayloadImgName, *Suffix, *Prefix, *PayloadImgName, *Suffix ), Size );
 		}
+		return BrushToUse;
+	}
+
+	virtual bool GetRunBrush( const TMap<FString, FString>& Payload, FBYGRunBrushInfo& OutBrushInfo ) const override
+	{
+		OutBrushInfo.Brush = ResolveBrush( Payload );
+		OutBrushInfo.HAlign = ImageHAlign;
+		OutBrushInfo.VAlign = ImageVAlign;
+		OutBrushInfo.Padding = ImagePadding;
+		OutBrushInfo.bSizeToBrush = true;
+		return true;
+	}
+
+	virtual FVector2D GetRunMinSize( const TMap<FString, FString>& Payload ) const override
+	{
+		const FVector2D ImageSize = BrushLocationType == EBYGBrushLocationType::Folder ? FolderIconSize : Brush.ImageSize;
+		return ImageSize + ImagePadding.GetDesiredSize();
+	}
+
+	virtual TSharedRef<SWidget> WrapBlock( TSharedRef<SWidget>& TextBlock, UBYGRichTextBlock* OuterBlock, const TMap<FString, FString>& Payload ) const override
+	{
+		const FSlateBrush* BrushToUse = ResolveBrush( Payload );
 
 		TSharedRef<SOverlay> NewOverlay = SNew( SOverlay )
 		+ SOverlay::Slot()
@@ -512,13 +617,15 @@ public:
 		return NewOverlay;
 	}
 
-	void SetBrushDirectory( const FString& InDirectoryPath ) { BrushDirectory.Path = InDirectoryPath; }
-	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; }
-	void SetHAlign( TEnumAsByte<EHorizontalAlignment> InImageHAlign ) { ImageHAlign = InImageHAlign; }
-	void SetVAlign( TEnumAsByte<EVerticalAlignment> InImageVAlign ) { ImageVAlign = InImageVAlign; }
-	void SetMargin( const FMargin& InImagePadding ) { ImagePadding = InImagePadding; }
+	void SetBrushDirectory( const FString& InDirectoryPath ) { BrushDirectory.Path = InDirectoryPath; NotifyValueChanged(); }
+	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; NotifyValueChanged(); }
+
+	// Icons loaded from a folder are always brushed at this size
+	static const FVector2D FolderIconSize;
+	void SetHAlign( TEnumAsByte<EHorizontalAlignment> InImageHAlign ) { ImageHAlign = InImageHAlign; NotifyValueChanged(); }
+	void SetVAlign( TEnumAsByte<EVerticalAlignment> InImageVAlign ) { ImageVAlign = InImageVAlign; NotifyValueChanged(); }
+	void SetMargin( const FMargin& InImagePadding ) { ImagePadding = InImagePadding; NotifyValueChanged(); }
 
-	virtual bool RequiresInlineTextBlock() const { return true; }
 protected:
 	UPROPERTY( EditAnywhere, Category = "File" )
 		EBYGBrushLocationType BrushLocationType = EBYGBrushLocationType::Single;
@@ -539,46 +646,34 @@ protected:
 };
 
 
-/**
-* Interface for tool tips.
-*/
+class UBYGRichTextTooltipProperty;
 
-DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam( UWidget*, FBYGGetWidget, UBYGRichTextBlock*, Owner );
+// Creates its content from the property when it opens, and hands it back to be reused when it closes
+// Inline runs share one per block, see UBYGRichTextBlock::GetRunToolTip, and SetRun points it at the hovered run
 class FBYGDelegateToolTip : public IToolTip
 {
 public:
+	FBYGDelegateToolTip( const UBYGRichTextTooltipProperty* InProperty, UBYGRichTextBlock* InOuterBlock, const TMap<FString, FString>& Payload );
+	FBYGDelegateToolTip( const UBYGRichTextTooltipProperty* InProperty, UBYGRichTextBlock* InOuterBlock, const FBYGStyleTagData& InData );
+
+	// Show another run's tooltip. Slate keeps the same tooltip open when moving between runs, so if it's
+	// showing, the content is swapped in place
+	void SetRun( const UBYGRichTextTooltipProperty* InProperty, const FBYGStyleTagData& InData );
+	const FBYGStyleTagData& GetData() const { return Data; }
 
 	/**
 	* Gets the widget that this tool tip represents.
 	*
 	* @return The tool tip widget.
 	*/
-	virtual TSharedRef<class SWidget> AsWidget() override
-	{
-		return GetContentWidget();
-	}
+	virtual TSharedRef<class SWidget> AsWidget() override;
 
 	/**
 	* Gets the tool tip's content widget.
 	*
 	* @return The content widget.
 	*/
-	virtual TSharedRef<SWidget> GetContentWidget() override
-	{
-		if ( CachedToolTip.IsValid() )
-		{
-			return CachedToolTip.ToSharedRef();
-		}
-
-		UWidget* Widget = ToolTipWidgetDelegate.Execute( OuterBlock.Get() );
-		if ( Widget )
-		{
-			CachedToolTip = Widget->TakeWidget();
-			return CachedToolTip.ToSharedRef();
-		}
-
-		return SNullWidget::NullWidget;
-	}
+	virtual TSharedRef<SWidget> GetContentWidget() override;
 
 	/**
 	* Sets the tool tip's content widget.
@@ -595,10 +690,7 @@ public:
 	*
 	* @return true if the tool tip has no content to display, false otherwise.
 	*/
-	virtual bool IsEmpty() const override
-	{
-		return !ToolTipWidgetDelegate.IsBound();
-	}
+	virtual bool IsEmpty() const override;
 
 	/**
 	* Checks whether this tool tip can be made interactive by the user (by holding Ctrl).
@@ -610,26 +702,27 @@ public:
 		return false;
 	}
 
-	virtual void OnClosed() override
-	{
-		//TODO Notify interface implementing widget of closure
-
-		CachedToolTip.Reset();
-	}
+	virtual void OnClosed() override;
 
 	virtual void OnOpening() override
 	{
-		//TODO Notify interface implementing widget of opening
+		bIsOpen = true;
 	}
 
-	TWeakObjectPtr<UBYGRichTextBlock> OuterBlock;
-
-public:
-	FBYGGetWidget ToolTipWidgetDelegate;
+private:
+	// Hands the content widget back to the pool
+	void ReleaseContent();
 
+	TWeakObjectPtr<const UBYGRichTextTooltipProperty> Property;
+	TWeakObjectPtr<UBYGRichTextBlock> OuterBlock;
+	// Passed to IBYGInlineTextTooltip::InitializeTooltip each time the tooltip opens
+	FBYGStyleTagData Data;
 
-private:
+	// What Slate shows, so the content can change while it's open
+	TSharedPtr<SBox> Container;
 	TSharedPtr<SWidget> CachedToolTip;
+	TWeakObjectPtr<UWidget> ContentWidget;
+	bool bIsOpen = false;
 };
 
 UCLASS( EditInlineNew, meta = ( DisplayName = "Tooltip", DisplayOrder = 52 ) )
@@ -641,12 +734,12 @@ public:
 	UBYGRichTextTooltipProperty( const FObjectInitializer& ObjectInitializer )
 		: Super( ObjectInitializer )
 	{
-		ToolTipWidgetDelegate.BindUFunction( this, GET_FUNCTION_NAME_CHECKED( UBYGRichTextTooltipProperty, CreateTooltip ) );
 		TypeID = "Tooltip";
 	}
 
-	UFUNCTION()
-		UWidget* CreateTooltip( UBYGRichTextBlock* InOuter );
+	// Widgets come from the module's pool when the block is in a world, so hovering doesn't create garbage
+	UWidget* CreateTooltip( UBYGRichTextBlock* InOuter, const FBYGStyleTagData& Data ) const;
+	void ReleaseTooltip( UWidget* Widget ) const;
 
 	virtual TSharedRef<SWidget> WrapBlock( TSharedRef<SWidget>& TextBlock, UBYGRichTextBlock* InOuterBlock, const TMap<FString, FString>& Payload ) const override
 	{
@@ -655,12 +748,20 @@ public:
 			return TextBlock;
 #endif
 
-		TSharedRef<FBYGDelegateToolTip> ToolTip = MakeShareable( new FBYGDelegateToolTip() );
-		ToolTip->ToolTipWidgetDelegate = ToolTipWidgetDelegate;
-		ToolTip->OuterBlock = InOuterBlock;
-		TextBlock.Get().SetToolTip( ToolTip );
+		// One per block, the content widget is only created while it's open
+		TextBlock.Get().SetToolTip( MakeShared<FBYGDelegateToolTip>( this, InOuterBlock, Payload ) );
 		return TextBlock;
 	}
+	virtual bool RequiresBlockWidget() const override { return true; }
+
+	// Inline tooltips come from the hit-test index, so the run stays plain text
+	virtual bool IsRunInteractive() const override { return true; }
+	virtual TSharedPtr<IToolTip> CreateRunToolTip( UBYGRichTextBlock* OuterBlock, const FBYGStyleTagData& Data ) const override
+	{
+		if ( !OuterBlock )
+			return nullptr;
+		return OuterBlock->GetRunToolTip( this, Data );
+	}
 
 	virtual TSharedRef<SWidget> CreateInline( TSharedRef<SWidget>& TextBlock, UBYGRichTextBlock* InOuterBlock )
 	{
@@ -669,21 +770,37 @@ public:
 			return TextBlock;
 #endif
 
-		TSharedRef<FBYGDelegateToolTip> ToolTip = MakeShareable( new FBYGDelegateToolTip() );
-		ToolTip->ToolTipWidgetDelegate = ToolTipWidgetDelegate;
-		ToolTip->OuterBlock = InOuterBlock;
-		TextBlock.Get().SetToolTip( ToolTip );
+		TextBlock.Get().SetToolTip( InOuterBlock->GetRunToolTip( this, FBYGStyleTagData() ) );
 		return TextBlock;
 	}
 
 	// UserWidgetClass can optionally implement BYGInlineTooltip interface to receive information
 	UPROPERTY( EditAnywhere )
 		TSubclassOf<UUserWidget> UserWidgetClass;
+};
 
-protected:
-	//TWeakObjectPtr<UWidget> OuterBlock;
 
-	FBYGGetWidget ToolTipWidgetDelegate;
+// Makes inline runs clickable, handle them with UBYGRichTextBlock::OnRunClicked
+UCLASS( EditInlineNew, meta = ( DisplayName = "Link", DisplayOrder = 53 ) )
+class BYGRICHTEXT_API UBYGRichTextLinkProperty : public UBYGRichTextPropertyBase
+{
+	GENERATED_BODY()
+
+public:
+	UBYGRichTextLinkProperty( const FObjectInitializer& ObjectInitializer )
+		: Super( ObjectInitializer )
+	{
+		TypeID = "Link";
+	}
+
+	virtual bool GetSupportsDisplayType( EBYGStyleDisplayType Style ) const override { return Style == EBYGStyleDisplayType::Inline; }
+	virtual bool IsRunInteractive() const override { return true; }
+	virtual bool IsRunClickable() const override { return true; }
+	virtual EMouseCursor::Type GetRunCursor() const override { return Cursor; }
+
+protected:
+	UPROPERTY( EditAnywhere )
+		TEnumAsByte<EMouseCursor::Type> Cursor = EMouseCursor::Hand;
 };
 
 
@@ -699,7 +816,7 @@ public:
 	{
 		Style.SetStrikeBrush( Brush );
 	}
-	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; }
+	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -717,8 +834,8 @@ public:
 		Style.SetHighlightColor( Color );
 		Style.SetHighlightShape( Brush );
 	}
-	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; }
-	void SetColor( const FLinearColor& InColor ) { Color = InColor; }
+	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; NotifyValueChanged(); }
+	void SetColor( const FLinearColor& InColor ) { Color = InColor; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -737,7 +854,7 @@ public:
 	{
 		Style.SetUnderlineBrush( Brush );
 	}
-	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; }
+	void SetBrush( const FSlateBrush& InBrush ) { Brush = InBrush; NotifyValueChanged(); }
 
 protected:
 	UPROPERTY( EditAnywhere )
@@ -8,6 +8,7 @@
 #include "BYGRIchTextStyle.generated.h"
 
 class UBYGRichTextPropertyBase;
+class UBYGRichTextStylesheet;
 
 DECLARE_DELEGATE( FBYGOnStylePropertyChangedSignature );
 
@@ -25,6 +26,7 @@ public:
 	void SetID( const FName& InID )
 	{
 		if ( IsValidID( InID ) ) ID = InID;
+		NotifyChanged();
 	}
 
 	void AddProperty( UBYGRichTextPropertyBase* Property );
@@ -48,12 +50,14 @@ public:
 	void SetDisplayType( EBYGStyleDisplayType InDisplayType )
 	{
 		DisplayType = InDisplayType;
+		NotifyChanged();
 	}
 
-	FString GetShortcut() const { return Shortcut; }
+	const FString& GetShortcut() const { return Shortcut; }
 	void SetShortcut( const FString& InShortcut )
 	{
 		Shortcut = ValidateShortcut( InShortcut );
+		NotifyChanged();
 	}
 
 	static bool IsValidID( const FName& InID );
@@ -64,6 +68,11 @@ public:
 protected:
 	static FString ValidateShortcut( const FString& InShortcut );
 
+	// Anything set at runtime changes what the parser finds, so the owning stylesheet looks everything up again
+	void NotifyChanged();
+	// Set by the stylesheet when it looks us up
+	TWeakObjectPtr<UBYGRichTextStylesheet> OwningStylesheet;
+
 	void SortProperties();
 
 	// The unique identifier of the style
@@ -87,5 +96,6 @@ protected:
 	void PostLoad() override;
 
 	friend class FBYGRichTextStyleCustomization;
+	friend class UBYGRichTextStylesheet;
 };
 
@@ -5,15 +5,30 @@
 #include "CoreMinimal.h"
 #include "BYGRichTextProperty.h"
 #include "BYGStyleDisplayType.h"
+#include "BYGStylesheetChange.h"
+#include "BYGStylesheetHandle.h"
 #include "Framework/Text/ITextLayoutMarshaller.h"
 #include "Framework/Text/RichTextLayoutMarshaller.h"
+#include "Misc/ScopeRWLock.h"
+#include "Styling/SlateTypes.h"
 #include <Engine/DataAsset.h>
 #include "BYGRIchTextStylesheet.generated.h"
 
-DECLARE_DYNAMIC_MULTICAST_DELEGATE( FBYGOnStylesheetPropertiesChangedSignature );
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam( FBYGOnStylesheetPropertiesChangedSignature, const FBYGStylesheetChange&, Change );
 
 class UBYGRichTextStyle;
 
+// The properties behind one ids attribute from the parser, and the text style they make together
+// Every run with the same ids shares one of these, see UBYGRichTextStylesheet::ResolveRunStyle
+struct FBYGResolvedRunStyle
+{
+	TArray<const UBYGRichTextPropertyBase*> Properties;
+	// Parallel to Properties, the combination is resolved again once any of these go stale
+	TArray<FBYGStylesheetHandle> Handles;
+	FTextBlockStyle TextStyle;
+	bool bRequiresInlineTextBlock = false;
+};
+
 /**
  * Stylesheet allows for definition of multiple styles
  */
@@ -28,7 +43,36 @@ public:
 	UBYGRichTextStyle* FindStyle( TCHAR const* Input, int32 CurrentIndex, TOptional<EBYGStyleDisplayType> DisplayType = TOptional<EBYGStyleDisplayType>() ) const;
 	UBYGRichTextStyle* FindStyle( const FName& ID ) const;
 
-	const UBYGRichTextPropertyBase* FindProperty( int32 InlineID ) const;
+	const UBYGRichTextPropertyBase* FindProperty( const FName& InlineID ) const;
+	// Properties for the space-separated inline IDs the parser wrote for a run. Cached until one of the
+	// properties is removed or edited, so each combination is only resolved once per stylesheet
+	TSharedRef<const FBYGResolvedRunStyle> ResolveRunStyle( const FString& InlineIDs ) const;
+
+	// Handles survive RebuildLookup, see FBYGStylesheetHandle
+	FBYGStylesheetHandle FindPropertyHandle( const FName& InlineID ) const
+	{
+		FReadScopeLock Lock( LookupLock );
+		return PropertySlots.Find( InlineID );
+	}
+	const UBYGRichTextPropertyBase* ResolveProperty( const FBYGStylesheetHandle& Handle ) const
+	{
+		FReadScopeLock Lock( LookupLock );
+		return PropertySlots.Resolve( Handle );
+	}
+	FBYGStylesheetHandle FindStyleHandle( const FName& StyleID ) const
+	{
+		FReadScopeLock Lock( LookupLock );
+		return StyleSlots.Find( StyleID );
+	}
+	const UBYGRichTextStyle* ResolveStyle( const FBYGStylesheetHandle& Handle ) const
+	{
+		FReadScopeLock Lock( LookupLock );
+		return StyleSlots.Resolve( Handle );
+	}
+
+	// Hash of everything in the stylesheet that affects how markup is parsed
+	// Uses strings rather than FName indices so it is stable between runs
+	uint32 GetParseHash() const;
 
 	TSharedPtr<SWidget> RebuildWidget( const FText& InText, TSharedRef<FRichTextLayoutMarshaller> Marshaller );
 
@@ -48,6 +92,7 @@ public:
 	virtual void PostLoad() override;
 	virtual void PostCDOContruct() override;
 	virtual void PostEditImport() override;
+	virtual void GetResourceSizeEx( FResourceSizeEx& CumulativeResourceSize ) override;
 
 #if WITH_EDITOR
 	virtual bool Modify( bool bAlwaysMarkDirty = true ) override;
@@ -56,11 +101,24 @@ public:
 
 	// Custom validation for Blueprint error logs
 	void Validate( FCompilerResultsLog& ResultsLog ) const;
+
+	// Work out which styles an editor change touched, falls back to a structural change if we can't tell
+	FBYGStylesheetChange MakeChangeForEvent( const FPropertyChangedEvent& PropertyChangedEvent ) const;
 #endif
 
+	// Tell widgets about a change. Predicted layouts depend on property values, which aren't part of the
+	// parse hash, so they are dropped first
+	void BroadcastChange( const FBYGStylesheetChange& Change ) const;
+	// From the setters on our styles and properties, so runtime edits drop the same caches editor ones do
+	void NotifyPropertyChanged( const UBYGRichTextPropertyBase* Prop, const FName& StyleID ) const;
+	void NotifyStyleChanged();
+
 	// So we can have const stuff and still register for changes
 	mutable FBYGOnStylesheetPropertiesChangedSignature OnStylesheetPropertiesChangedDelegate;
 
+	// True while FBYGRichTextPrewarm is parsing against this stylesheet on other threads. Editing it then is fatal
+	bool IsPrewarming() const { return NumPrewarmsInFlight.GetValue() > 0; }
+
 
 protected:
 	UPROPERTY( EditDefaultsOnly )
@@ -73,11 +131,30 @@ protected:
 		TArray<const UBYGRichTextPropertyBase*> DefaultProperties;
 
 	// Properties should be owned by the styles, not through this lookup
-	//UPROPERTY( Transient )
-	TMap<int32, TWeakObjectPtr<const UBYGRichTextPropertyBase>> PropertyLookup;
+	// By inline ID and style ID. Unchanged entries keep their handles when the lookup is rebuilt
+	// Mutable as BroadcastChange touches them
+	mutable TBYGStylesheetSlots<UBYGRichTextPropertyBase> PropertySlots;
+	mutable TBYGStylesheetSlots<UBYGRichTextStyle> StyleSlots;
+	// Guards the slots and the properties' inline IDs. Layouts are predicted, prewarmed and parsed on worker
+	// threads, which only read. Take it after ResolvedRunStylesLock, never the other way round
+	mutable FRWLock LookupLock;
+
+	// Make handles to a style and its properties stale, after their values were edited
+	// LookupLock must be held for writing
+	void TouchStyle( const FName& StyleID ) const;
+
+	// Keyed by the ids attribute. Locked as layouts can be predicted from worker threads
+	mutable TMap<FString, TSharedRef<const FBYGResolvedRunStyle>> ResolvedRunStyles;
+	mutable FCriticalSection ResolvedRunStylesLock;
+
+	// Prewarm tasks still reading the stylesheet, counted by FBYGRichTextPrewarm
+	mutable FThreadSafeCounter NumPrewarmsInFlight;
+	// Checked before anything the prewarm tasks read is changed
+	void CheckNotPrewarming() const;
 
 	// Hacky way of allowing customization from the editor
 	friend class FBYGRichTextStyleCustomization;
+	friend class FBYGRichTextPrewarm;
 };
 
 
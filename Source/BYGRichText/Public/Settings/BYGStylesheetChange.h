@@ -0,0 +1,43 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BYGStylesheetChange.generated.h"
+
+// Describes what changed in a stylesheet, so widgets can skip or cheapen their rebuild
+USTRUCT()
+struct BYGRICHTEXT_API FBYGStylesheetChange
+{
+	GENERATED_BODY()
+
+public:
+	// Styles whose properties were edited. Only meaningful if bStructural is false
+	UPROPERTY()
+		TArray<FName> StyleIDs;
+
+	// Type IDs of the edited properties
+	UPROPERTY()
+		TArray<FName> PropertyTypeIDs;
+
+	// Styles were added, removed or had their ID, shortcut or display type changed.
+	// Any widget using the stylesheet must reparse
+	UPROPERTY()
+		bool bStructural = true;
+
+	// All edited properties only affect FTextBlockStyle, existing runs can be restyled without a reparse
+	UPROPERTY()
+		bool bRestyleOnly = false;
+
+	bool AffectsAnyStyle( const TSet<FName>& UsedStyleIDs ) const
+	{
+		if ( bStructural )
+			return true;
+		for ( const FName& StyleID : StyleIDs )
+		{
+			if ( UsedStyleIDs.Contains( StyleID ) )
+				return true;
+		}
+		return false;
+	}
+};
@@ -0,0 +1,136 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+// Refers to a property or style in a UBYGRichTextStylesheet. Stays valid while that entry is unchanged, however
+// much else is added, removed or reordered around it. Once the entry is removed, replaced or edited the handle
+// resolves to nothing, and the caller finds it again by ID
+struct FBYGStylesheetHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+
+	bool operator==( const FBYGStylesheetHandle& Other ) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=( const FBYGStylesheetHandle& Other ) const { return !( *this == Other ); }
+};
+
+// Entries by ID, where an ID keeps its slot for as long as it's in the stylesheet
+// Each slot has a generation that moves on whenever what's in it changes, which is what invalidates handles
+template<typename ObjectType>
+class TBYGStylesheetSlots
+{
+public:
+	FBYGStylesheetHandle Find( const FName& ID ) const
+	{
+		FBYGStylesheetHandle Handle;
+		if ( const int32* Index = Indices.Find( ID ) )
+		{
+			Handle.Index = *Index;
+			Handle.Generation = Slots[ *Index ].Generation;
+		}
+		return Handle;
+	}
+
+	const ObjectType* Resolve( const FBYGStylesheetHandle& Handle ) const
+	{
+		if ( !Slots.IsValidIndex( Handle.Index ) )
+			return nullptr;
+		const FSlot& Slot = Slots[ Handle.Index ];
+		return Slot.bUsed && Slot.Generation == Handle.Generation ? Slot.Object.Get() : nullptr;
+	}
+
+	// Set every current entry between these, anything that wasn't set is removed
+	void BeginUpdate()
+	{
+		for ( FSlot& Slot : Slots )
+		{
+			Slot.bSeen = false;
+		}
+	}
+
+	// False if the ID was already set in this update, the first one is kept
+	bool Set( const FName& ID, const ObjectType* Object )
+	{
+		if ( const int32* Index = Indices.Find( ID ) )
+		{
+			FSlot& Slot = Slots[ *Index ];
+			if ( Slot.bSeen )
+				return false;
+			if ( Slot.Object.Get() != Object )
+			{
+				Slot.Object = Object;
+				++Slot.Generation;
+			}
+			Slot.bSeen = true;
+			return true;
+		}
+
+		const int32 Index = FreeIndices.Num() > 0 ? FreeIndices.Pop( false ) : Slots.AddDefaulted();
+		FSlot& Slot = Slots[ Index ];
+		Slot.ID = ID;
+		Slot.Object = Object;
+		++Slot.Generation;
+		Slot.bUsed = true;
+		Slot.bSeen = true;
+		Indices.Add( ID, Index );
+		return true;
+	}
+
+	void EndUpdate()
+	{
+		for ( int32 Index = 0; Index < Slots.Num(); ++Index )
+		{
+			FSlot& Slot = Slots[ Index ];
+			if ( !Slot.bUsed || Slot.bSeen )
+				continue;
+			Indices.Remove( Slot.ID );
+			Slot.Object.Reset();
+			Slot.bUsed = false;
+			++Slot.Generation;
+			FreeIndices.Add( Index );
+		}
+	}
+
+	// The entry's values changed, so anything resolved from it is out of date
+	void Touch( const FName& ID )
+	{
+		if ( const int32* Index = Indices.Find( ID ) )
+		{
+			++Slots[ *Index ].Generation;
+		}
+	}
+
+	void TouchAll()
+	{
+		for ( FSlot& Slot : Slots )
+		{
+			++Slot.Generation;
+		}
+	}
+
+	int32 Num() const { return Indices.Num(); }
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Slots.GetAllocatedSize() + Indices.GetAllocatedSize() + FreeIndices.GetAllocatedSize();
+	}
+
+private:
+	struct FSlot
+	{
+		FName ID;
+		TWeakObjectPtr<const ObjectType> Object;
+		// Starts at 1 when first used, so a default handle never resolves
+		uint32 Generation = 0;
+		bool bUsed = false;
+		bool bSeen = false;
+	};
+	TArray<FSlot> Slots;
+	TMap<FName, int32> Indices;
+	TArray<int32> FreeIndices;
+};
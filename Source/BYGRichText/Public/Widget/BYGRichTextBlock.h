@@ -3,7 +3,11 @@
 #pragma once
 
 #include "Components/Widget.h"
+#include "Core/BYGRichTextLayoutPredictor.h"
 #include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextStats.h"
+#include "Core/BYGTextRun.h"
+#include "Settings/BYGStylesheetChange.h"
 #include "BYGRichTextBlock.generated.h"
 
 UENUM()
@@ -13,12 +17,30 @@ enum class EBYGRichTextOverflowBehavior : uint8
 	Clip,
 };
 
+// How much work a queued stylesheet change needs, ordered so the larger value wins when merging
+enum class EBYGPendingRebuild : uint8
+{
+	None,
+	// Only FTextBlockStyle changed, re-run the decorators on the existing blocks
+	Restyle,
+	// Swapped to a stylesheet with the same styles, resolve the blocks against it and restyle
+	Retheme,
+	// Reparse the text and rebuild every block
+	Full,
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam( FBYGOnRunClickedDynamicSignature, const FBYGStyleTagData&, Data );
+DECLARE_MULTICAST_DELEGATE_OneParam( FBYGOnRunClickedSignature, const FBYGStyleTagData& );
+
 class SRichTextBlock;
+class SBYGRichTextDocument;
 class URichTextBlockDecorator;
 class ITextDecorator;
 class IRichTextMarkupParser;
 class IRichTextMarkupWriter;
 class UBYGRichTextStylesheet;
+class UBYGRichTextTooltipProperty;
+class FBYGDelegateToolTip;
 
 /**
  * 
@@ -39,15 +61,70 @@ public:
 	virtual void ReleaseSlateResources( bool bReleaseChildren ) override;
 	// End of UVisual interface
 
+	// UObject interface
+	virtual void GetResourceSizeEx( FResourceSizeEx& CumulativeResourceSize ) override;
+	// End of UObject interface
+
 	void SetText( const FText& InText );
 	inline FText GetText() { return Text; }
 
+	// Set the text of many widgets at once, e.g. refreshing every row of a leaderboard
+	// Each distinct text is parsed once, in parallel, then the widgets are updated on the game thread
+	static void SetTexts( const TArray<TPair<UBYGRichTextBlock*, FText>>& WidgetTexts );
+
+	// Read a Text binding if it's due, and set the text if it changed. Called by the module each frame
+	void PollTextBinding( double Time );
+	bool HasTextBinding() const { return TextDelegate.IsBound() && !IsDesignTime(); }
+
+	// Typewriter-style reveal. The full text is laid out once, and only the first Count characters are painted
+	// Counts characters in the displayed text, not the markup. INDEX_NONE shows everything
+	void SetRevealedCharacterCount( int32 Count );
+	// Same as above but 0-1 of the whole text, negative shows everything
+	void SetRevealProgress( float Progress );
+	// Number of characters that can be revealed, only valid once the text has been laid out
+	int32 GetRevealableCharacterCount() const { return RevealState->GetTotalCount(); }
+	TSharedRef<FBYGRevealState> GetRevealState() const { return RevealState.ToSharedRef(); }
+
+	TSharedRef<FBYGRichTextBlockStats> GetStats() const { return Stats.ToSharedRef(); }
+	int32 GetNumBlocks() const { return BlockInfos.Num(); }
+
+	// Fill in a {Name} slot in the markup. Only blocks containing the slot are refreshed, the markup isn't parsed again
+	void SetSlotValue( const FName& SlotName, const FText& Value );
+	void ClearSlotValue( const FName& SlotName );
+	const FText* FindSlotValue( const FName& SlotName ) const { return SlotValues.Find( SlotName ); }
+
+	// Only valid when drawing as a single widget and the Slate widget has been built
+	TSharedPtr<SBYGRichTextDocument> GetDocumentWidget() const { return MyDocument; }
+	// Where interactive runs are found under the mouse, null if not drawing as a single widget
+	TSharedPtr<FBYGRunHitTestIndex> GetHitTestIndex() const;
+	// The tooltip every inline run in this block shows, pointed at the given property and payload.
+	// Created once, so hovering doesn't allocate a new one per run
+	TSharedRef<FBYGDelegateToolTip> GetRunToolTip( const UBYGRichTextTooltipProperty* Property, const FBYGStyleTagData& Data );
+
+	// A run with a Link property was clicked, with its content and payload
+	UPROPERTY( BlueprintAssignable, Category = "Rich Text|Event" )
+		FBYGOnRunClickedDynamicSignature OnRunClicked;
+	// Same as OnRunClicked, for C++ listeners that bind lambdas or raw pointers
+	FBYGOnRunClickedSignature OnRunClickedNative;
+
+	// Desired size this widget would have at the given wrap width, without laying it out. See FBYGRichTextLayoutPredictor
+	// A Scale of 0 uses the layout scale the widget was last drawn at, DPI included
+	FBYGPredictedLayout PredictLayout( float WrapWidth, float Scale = 0.0f ) const;
+
 
 	// TODO should store unmodifiable rich text stylesheet instance in the module?
 	const UBYGRichTextStylesheet* GetRichTextStylesheet() const;
 	void SetRichTextStylesheet( const UBYGRichTextStylesheet* InRichTextStylesheet );
 	void SetRichTextStylesheetClass( TSubclassOf<UBYGRichTextStylesheet> InRichTextStylesheetClass );
 
+	// Rebuild the contents if a stylesheet change has queued a rebuild since the last flush
+	void FlushPendingRebuild();
+	bool IsRebuildPending() const { return PendingRebuild != EBYGPendingRebuild::None; }
+
+	// Styles and property types referenced by the last parse, used to ignore unrelated stylesheet edits
+	const TSet<FName>& GetUsedStyleIDs() const;
+	const TSet<FName>& GetUsedPropertyTypeIDs() const;
+
 
 #if WITH_EDITOR
 	// UWidget interface
@@ -68,10 +145,40 @@ protected:
 	// End of UWidget interface
 
 	UFUNCTION()
-		void OnRichTextStylesheetChanged();
+		void OnRichTextStylesheetChanged( const FBYGStylesheetChange& Change );
 
 	void RebuildContents();
 
+	// Stylesheet changes can arrive many times per frame (e.g. dragging a slider in the details panel)
+	// so they only mark the widget dirty, and the module flushes it once per frame
+	void QueueRebuild( EBYGPendingRebuild Rebuild );
+	EBYGPendingRebuild PendingRebuild = EBYGPendingRebuild::None;
+
+	// Re-run the decorators on the existing blocks without reparsing
+	void RestyleContents();
+	// Point the parsed blocks at the current stylesheet's properties, then restyle
+	void RethemeContents();
+
+	// How the document draws a block, from its block properties
+	static void GetDocumentBlockStyle( const FBYGTextBlockInfo& BlockInfo, const UBYGRichTextStylesheet* Stylesheet, FBYGBlockLayoutStyle& OutBlockStyle, TArray<FBYGRunBrushInfo>& OutBrushes );
+
+	// Refresh the runs of blocks that show this slot
+	void RefreshSlot( const FName& SlotName );
+
+	// Repaint the blocks with characters between the two counts
+	void InvalidateRevealRange( int32 FromCount, int32 ToCount );
+
+	// False if any style the text uses needs a real widget per block, e.g. for tooltips
+	bool CanDrawAsDocument( const UBYGRichTextStylesheet* Stylesheet ) const;
+
+	TSharedPtr<IToolTip> HandleGetRunToolTip( const FBYGRunInteraction& Run );
+	void HandleRunClicked( const FBYGRunInteraction& Run );
+
+	// Called once per block, so runs know which block they're in. By default calls the old overload below
+	virtual void CreateDecorators( TArray< TSharedRef<ITextDecorator> >& OutDecorators, int32 BlockIndex );
+	// Still called, so existing overrides keep working. The default decorator it adds knows the block
+	// through DecoratorBlockIndex
+	UE_DEPRECATED( 4.26, "Override CreateDecorators( OutDecorators, BlockIndex ) instead." )
 	virtual void CreateDecorators( TArray< TSharedRef<ITextDecorator> >& OutDecorators );
 	virtual TSharedPtr<IRichTextMarkupParser> CreateMarkupParser();
 	virtual TSharedPtr<IRichTextMarkupWriter> CreateMarkupWriter();
@@ -80,6 +187,25 @@ protected:
 	UPROPERTY( EditAnywhere, Category = "Rich Text", meta = ( MultiLine = "true", DisplayOrder = 0 ) )
 		FText Text;
 
+	// A bindable delegate to allow logic to drive the text of the widget. Polled every TextBindingInterval
+	// rather than every frame, and the text is only parsed again when the result changed
+	UPROPERTY()
+		FGetText TextDelegate;
+
+	PROPERTY_BINDING_IMPLEMENTATION( FText, Text );
+
+	// Seconds between reads of a Text binding. 0 reads it every frame
+	UPROPERTY( EditAnywhere, Category = "Rich Text", AdvancedDisplay, meta = ( DisplayOrder = 32, ClampMin = 0 ) )
+		float TextBindingInterval = 0.1f;
+
+	// Block whose decorators are being made, for the deprecated CreateDecorators overload
+	int32 DecoratorBlockIndex = INDEX_NONE;
+
+	// Of the last text read from the binding, so an unchanged result is cheap to spot
+	uint32 BoundTextHash = 0;
+	int32 BoundTextLen = INDEX_NONE;
+	double NextTextBindingPollTime = 0.0;
+
 	// Defines the visual style of the text. Must be set.
 	UPROPERTY( EditAnywhere, Category = "Rich Text", meta = ( DisplayOrder = 20 ) )
 		TSubclassOf<UBYGRichTextStylesheet> RichTextStylesheetClass;
@@ -87,9 +213,35 @@ protected:
 		const UBYGRichTextStylesheet* RichTextStylesheet;
 	bool bHasExternallyDefinedStylesheet = false;
 
+	// Draw every block in one widget rather than a widget per block. Text using styles that need
+	// a widget per block (e.g. tooltips) still gets one
+	UPROPERTY( EditAnywhere, Category = "Rich Text", AdvancedDisplay, meta = ( DisplayOrder = 30 ) )
+		bool bDrawAsSingleWidget = true;
+
+	// Wrap the contents in an invalidation panel so they're only painted again when they change
+	// Not needed with global invalidation, where every widget already works that way
+	UPROPERTY( EditAnywhere, Category = "Rich Text", AdvancedDisplay, meta = ( DisplayOrder = 31 ) )
+		bool bCacheAsInvalidationRoot = false;
+
 
 	TArray<FBYGTextBlockInfo> BlockInfos;
 
+	// Always valid, shared with the runs so they can read it at paint time
+	TSharedPtr<FBYGRevealState> RevealState;
+
+	TMap<FName, FText> SlotValues;
+
+	// Always valid, shared with the decorators so they can count runs
+	TSharedPtr<FBYGRichTextBlockStats> Stats;
+
+	TSharedPtr<FBYGRichTextMarkupParser> MarkupParser;
+	// Parse hash BlockInfos were parsed with. Parser output only names styles, so it's still good while this matches
+	uint32 ParsedHash = 0;
+
 	TSharedPtr<SVerticalBox> MyVerticalBox;
 	TArray<TSharedPtr<SRichTextBlock> >MyRichTextBlocks;
+	// Used instead of MyRichTextBlocks when drawing as a single widget
+	TSharedPtr<SBYGRichTextDocument> MyDocument;
+	// See GetRunToolTip
+	TSharedPtr<FBYGDelegateToolTip> RunToolTip;
 };
@@ -0,0 +1,115 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+#include "Styling/CoreStyle.h"
+#include "Styling/SlateTypes.h"
+#include "Core/BYGTextRun.h"
+#include "Settings/BYGRichTextProperty.h"
+
+class FSlateTextBlockLayout;
+class ITextLayoutMarshaller;
+
+DECLARE_DELEGATE_RetVal_OneParam( TSharedPtr<IToolTip>, FBYGOnGetRunToolTip, const FBYGRunInteraction& );
+DECLARE_DELEGATE_OneParam( FBYGOnRunClicked, const FBYGRunInteraction& );
+
+struct FBYGRichTextDocumentStats
+{
+	// Blocks whose size had to be worked out again in a prepass
+	int32 NumBlockLayouts = 0;
+	int32 NumLayoutInvalidations = 0;
+	int32 NumPaintInvalidations = 0;
+};
+
+// Draws every block of a UBYGRichTextBlock in one widget, instead of an SRichTextBlock per block
+// wrapped in overlays for their backgrounds. Each block still has its own text layout, as margins,
+// justification and line height are per layout, but those aren't widgets
+// Can't show inline widgets, UBYGRichTextBlock only uses this when nothing needs one
+class BYGRICHTEXT_API SBYGRichTextDocument : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS( SBYGRichTextDocument )
+		: _TextStyle( &FCoreStyle::Get().GetWidgetStyle<FTextBlockStyle>( "NormalText" ) )
+	{}
+		// Used for text that no run covers, same as the SRichTextBlock default
+		SLATE_STYLE_ARGUMENT( FTextBlockStyle, TextStyle )
+		// Tooltip for an interactive run when the mouse moves over it
+		SLATE_EVENT( FBYGOnGetRunToolTip, OnGetRunToolTip )
+		SLATE_EVENT( FBYGOnRunClicked, OnRunClicked )
+	SLATE_END_ARGS()
+
+	SBYGRichTextDocument();
+	virtual ~SBYGRichTextDocument();
+
+	void Construct( const FArguments& InArgs );
+
+	// Brushes are drawn behind the block, the same as the overlays WrapBlock would have added
+	void AddBlock( const TSharedRef<ITextLayoutMarshaller>& Marshaller, const FText& Text, const FBYGBlockLayoutStyle& BlockStyle, const TArray<FBYGRunBrushInfo>& Brushes );
+	int32 GetNumBlocks() const { return Blocks.Num(); }
+
+	// Create the runs of a block again, e.g. for new slot values or text styles. The text isn't parsed again
+	void RefreshBlock( int32 BlockIndex );
+	void RefreshAllBlocks();
+	// New block properties for an existing block, e.g. after swapping stylesheets. Lays the block out again
+	void SetBlockStyle( int32 BlockIndex, const FBYGBlockLayoutStyle& BlockStyle, const TArray<FBYGRunBrushInfo>& Brushes );
+	// Repaint without laying out again, e.g. when the revealed character count changes
+	void InvalidatePaint();
+
+	const FBYGRichTextDocumentStats& GetStats() const { return Stats; }
+	// Heap memory held for the blocks, including their text layouts. Runs are counted by the owner
+	SIZE_T GetAllocatedSize() const;
+
+	// Interactive runs add themselves to this as they paint
+	TSharedRef<FBYGRunHitTestIndex> GetHitTestIndex() const { return HitTestIndex; }
+	TSharedPtr<const FBYGRunInteraction> GetHoveredRun() const { return HoveredRun; }
+
+	// SWidget interface
+	virtual int32 OnPaint( const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled ) const override;
+	virtual FVector2D ComputeDesiredSize( float LayoutScaleMultiplier ) const override;
+	virtual FReply OnMouseMove( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent ) override;
+	virtual void OnMouseLeave( const FPointerEvent& MouseEvent ) override;
+	virtual FReply OnMouseButtonDown( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent ) override;
+	virtual FReply OnMouseButtonUp( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent ) override;
+	virtual FCursorReply OnCursorQuery( const FGeometry& MyGeometry, const FPointerEvent& CursorEvent ) const override;
+	virtual TSharedPtr<IToolTip> GetToolTip() override;
+	// End of SWidget interface
+
+protected:
+	struct FBlock
+	{
+		TUniquePtr<FSlateTextBlockLayout> Layout;
+		FText Text;
+		FBYGBlockLayoutStyle Style;
+		TArray<FBYGRunBrushInfo> Brushes;
+		// Mutable as the layout is worked out in ComputeDesiredSize, which Slate only gives us as const. Same
+		// as STextBlock, the prepass is the one place to lay out, so these are a cache of it
+		// From the last ComputeDesiredSize, used to stack the blocks when painting
+		mutable FVector2D DesiredSize = FVector2D::ZeroVector;
+		// What DesiredSize was worked out for, it's reused until one of these changes
+		mutable bool bDirty = true;
+		mutable float LaidOutScale = 0.0f;
+		mutable float LaidOutWidth = 0.0f;
+	};
+
+	void InvalidateDocument( EInvalidateWidgetReason Reason );
+	void SetHoveredRun( const TSharedPtr<const FBYGRunInteraction>& Run );
+
+	FTextBlockStyle TextStyle;
+	TArray<TUniquePtr<FBlock>> Blocks;
+
+	// Wrapping blocks depend on the width from the last paint, like STextBlock
+	mutable float LastPaintWidth = 0.0f;
+	mutable FBYGRichTextDocumentStats Stats;
+
+	TSharedRef<FBYGRunHitTestIndex> HitTestIndex = MakeShared<FBYGRunHitTestIndex>();
+	TSharedPtr<const FBYGRunInteraction> HoveredRun;
+	// Created when a run is hovered, Slate asks for it through GetToolTip
+	TSharedPtr<IToolTip> HoveredRunToolTip;
+	// Run the mouse went down on, clicks only count if it comes up on the same one
+	TSharedPtr<const FBYGRunInteraction> PressedRun;
+
+	FBYGOnGetRunToolTip OnGetRunToolTip;
+	FBYGOnRunClicked OnRunClicked;
+};
@@ -26,6 +26,7 @@ public class BYGRichTextEditor : ModuleRules
 			new string[] {
                 "SlateCore",
 				"BYGRichText",
+				"BYGRichTextUncooked",
                 "EditorStyle",
 				"SlateCore",
                 "Projects",
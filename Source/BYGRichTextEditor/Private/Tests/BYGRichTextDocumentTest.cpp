@@ -0,0 +1,324 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Input/HittestGrid.h"
+#include "Misc/App.h"
+#include "Rendering/DrawElements.h"
+#include "Types/PaintArgs.h"
+#include "Widgets/SWindow.h"
+
+#include "Settings/BYGRichTextStylesheet.h"
+#include "Settings/BYGRichTextStyle.h"
+#include "Widget/BYGRichTextBlock.h"
+#include "Widget/SBYGRichTextDocument.h"
+
+static const int DocumentTestFlags = (
+	EAutomationTestFlags::EditorContext
+	| EAutomationTestFlags::ClientContext
+	| EAutomationTestFlags::ProductFilter );
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentInvalidationTest, "BYG.RichText.Document.Invalidation", DocumentTestFlags )
+bool FBYGRichTextDocumentInvalidationTest::RunTest( const FString& Parameters )
+{
+	// Laying out text needs the renderer's font cache
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRichTextStylesheet( Stylesheet );
+	Block->SetText( FText::FromString( "First paragraph\r\n\r\nSecond paragraph" ) );
+	TSharedRef<SWidget> Widget = Block->TakeWidget();
+
+	TSharedPtr<SBYGRichTextDocument> Document = Block->GetDocumentWidget();
+	if ( !TestTrue( "Drawn as a single widget", Document.IsValid() ) )
+		return false;
+	TestEqual( "Both blocks are in the document", Document->GetNumBlocks(), 2 );
+
+	Widget->SlatePrepass( 1.0f );
+	const FBYGRichTextDocumentStats First = Document->GetStats();
+	TestEqual( "Each block laid out once", First.NumBlockLayouts, 2 );
+
+	Widget->SlatePrepass( 1.0f );
+	TestEqual( "Unchanged text isn't laid out again", Document->GetStats().NumBlockLayouts, First.NumBlockLayouts );
+
+	Block->SetText( FText::FromString( "First paragraph\r\n\r\nSecond paragraph" ) );
+	TestTrue( "Same text keeps the document", Block->GetDocumentWidget() == Document );
+	TestEqual( "Same text doesn't invalidate layout", Document->GetStats().NumLayoutInvalidations, First.NumLayoutInvalidations );
+	TestEqual( "Same text doesn't invalidate paint", Document->GetStats().NumPaintInvalidations, First.NumPaintInvalidations );
+
+	Block->SetRevealedCharacterCount( 5 );
+	TestEqual( "Reveal invalidates paint", Document->GetStats().NumPaintInvalidations, First.NumPaintInvalidations + 1 );
+	TestEqual( "Reveal doesn't invalidate layout", Document->GetStats().NumLayoutInvalidations, First.NumLayoutInvalidations );
+	Block->SetRevealedCharacterCount( 5 );
+	TestEqual( "Same reveal doesn't invalidate", Document->GetStats().NumPaintInvalidations, First.NumPaintInvalidations + 1 );
+	Widget->SlatePrepass( 1.0f );
+	TestEqual( "Reveal doesn't lay out again", Document->GetStats().NumBlockLayouts, First.NumBlockLayouts );
+
+	Block->SetSlotValue( "Name", FText::FromString( "Unused" ) );
+	Widget->SlatePrepass( 1.0f );
+	TestEqual( "Slot that isn't in the text doesn't lay out again", Document->GetStats().NumBlockLayouts, First.NumBlockLayouts );
+
+	Widget->SlatePrepass( 2.0f );
+	TestEqual( "New scale lays out every block", Document->GetStats().NumBlockLayouts, First.NumBlockLayouts + 2 );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentRethemeTest, "BYG.RichText.Document.Retheme", DocumentTestFlags )
+bool FBYGRichTextDocumentRethemeTest::RunTest( const FString& Parameters )
+{
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	auto MakeTheme = []()
+	{
+		UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+		return Stylesheet;
+	};
+	UBYGRichTextStylesheet* Light = MakeTheme();
+	UBYGRichTextStylesheet* Dark = MakeTheme();
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRichTextStylesheet( Light );
+	Block->SetText( FText::FromString( "First paragraph\r\n\r\nSecond paragraph" ) );
+	TSharedRef<SWidget> Widget = Block->TakeWidget();
+	TSharedPtr<SBYGRichTextDocument> Document = Block->GetDocumentWidget();
+	if ( !TestTrue( "Drawn as a single widget", Document.IsValid() ) )
+		return false;
+	const int32 NumRebuilds = Block->GetStats()->GetNumRebuilds();
+
+	Block->SetRichTextStylesheet( Dark );
+	TestTrue( "Swapping stylesheets is queued", Block->IsRebuildPending() );
+	Block->FlushPendingRebuild();
+	TestTrue( "Same styles keep the document", Block->GetDocumentWidget() == Document );
+	TestEqual( "Same styles don't rebuild", Block->GetStats()->GetNumRebuilds(), NumRebuilds );
+	TestTrue( "Uses the new stylesheet", Block->GetRichTextStylesheet() == Dark );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentFallbackTest, "BYG.RichText.Document.Fallback", DocumentTestFlags )
+bool FBYGRichTextDocumentFallbackTest::RunTest( const FString& Parameters )
+{
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+	{
+		// Inline tooltips are found through the hit-test index
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "tip" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Style->Properties.Add( NewObject<UBYGRichTextTooltipProperty>() );
+		Stylesheet->AddStyle( Style );
+	}
+	{
+		// Block tooltips are set on the block's widget, see RequiresBlockWidget
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "note" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Block );
+		Style->Properties.Add( NewObject<UBYGRichTextTooltipProperty>() );
+		Stylesheet->AddStyle( Style );
+	}
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRichTextStylesheet( Stylesheet );
+	Block->SetText( FText::FromString( "Plain text with a [tip]tooltip[/]" ) );
+	TSharedRef<SWidget> Widget = Block->TakeWidget();
+
+	TSharedPtr<SBYGRichTextDocument> Document = Block->GetDocumentWidget();
+	if ( !TestTrue( "Inline tooltips are drawn as a document", Document.IsValid() ) )
+		return false;
+	TestEqual( "One block", Document->GetNumBlocks(), 1 );
+	Widget->SlatePrepass( 1.0f );
+	const FVector2D DocumentSize = Widget->GetDesiredSize();
+	TestTrue( "Document has a size", DocumentSize.X > 0.0f && DocumentSize.Y > 0.0f );
+	TestEqual( "Block size is worked out in the prepass", Document->GetStats().NumBlockLayouts, 1 );
+
+	Block->SetText( FText::FromString( "[note]A paragraph with a tooltip[/]\r\n\r\nPlain text" ) );
+	TestFalse( "Block tooltips need a widget per block", Block->GetDocumentWidget().IsValid() );
+	Widget->SlatePrepass( 1.0f );
+	TestTrue( "Per-block widgets still lay out", Widget->GetDesiredSize().Y > 0.0f );
+
+	Block->SetText( FText::FromString( "Plain text with a [tip]tooltip[/]" ) );
+	TestTrue( "Back to a document once nothing needs a widget", Block->GetDocumentWidget().IsValid() );
+	Widget->SlatePrepass( 1.0f );
+	TestEqual( "Same text, same size", Widget->GetDesiredSize(), DocumentSize );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentLinkTest, "BYG.RichText.Document.Link", DocumentTestFlags )
+bool FBYGRichTextDocumentLinkTest::RunTest( const FString& Parameters )
+{
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "link" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Style->Properties.Add( NewObject<UBYGRichTextLinkProperty>() );
+		Stylesheet->AddStyle( Style );
+	}
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRichTextStylesheet( Stylesheet );
+	Block->SetText( FText::FromString( "[link id:glossary]Glossary[/] and plain text" ) );
+	TArray<FBYGStyleTagData> Clicks;
+	Block->OnRunClickedNative.AddLambda( [ &Clicks ]( const FBYGStyleTagData& Data )
+	{
+		Clicks.Add( Data );
+	} );
+	TSharedRef<SWidget> Widget = Block->TakeWidget();
+	TSharedPtr<SBYGRichTextDocument> Document = Block->GetDocumentWidget();
+	if ( !TestTrue( "Links are drawn as a document", Document.IsValid() ) )
+		return false;
+
+	// Runs add themselves to the hit-test index as they're painted
+	Widget->SlatePrepass( 1.0f );
+	const FGeometry Geometry = FGeometry::MakeRoot( FVector2D( 400.0f, Document->GetDesiredSize().Y ), FSlateLayoutTransform() );
+	TSharedRef<SWindow> Window = SNew( SWindow );
+	FSlateWindowElementList ElementList( Window );
+	FHittestGrid HittestGrid;
+	Widget->Paint( FPaintArgs( nullptr, HittestGrid, FVector2D::ZeroVector, FApp::GetCurrentTime(), 0.0f ), Geometry, Geometry.GetLayoutBoundingRect(), ElementList, 0, FWidgetStyle(), true );
+	TestEqual( "Only the link is interactive", Document->GetHitTestIndex()->Num(), 1 );
+
+	// The link is the first run, the plain text is past the end of the line
+	const FVector2D OnLink( 4.0f, Geometry.GetLocalSize().Y * 0.5f );
+	const FVector2D OffLink( 399.0f, Geometry.GetLocalSize().Y * 0.5f );
+	auto MakeEvent = []( const FVector2D& Position )
+	{
+		return FPointerEvent( 0, Position, Position, TSet<FKey>(), EKeys::LeftMouseButton, 0.0f, FModifierKeysState() );
+	};
+
+	Document->OnMouseMove( Geometry, MakeEvent( OffLink ) );
+	TestFalse( "Plain text isn't hovered", Document->GetHoveredRun().IsValid() );
+	TestTrue( "Default cursor off the link", Document->OnCursorQuery( Geometry, MakeEvent( OffLink ) ).GetCursorType() != EMouseCursor::Hand );
+
+	Document->OnMouseMove( Geometry, MakeEvent( OnLink ) );
+	if ( !TestTrue( "Link is hovered", Document->GetHoveredRun().IsValid() ) )
+		return false;
+	TestEqual( "Link cursor", Document->OnCursorQuery( Geometry, MakeEvent( OnLink ) ).GetCursorType(), EMouseCursor::Hand );
+	TestTrue( "Link run sees its property", Document->GetHoveredRun()->Properties.Num() == 1 && Document->GetHoveredRun()->Properties[ 0 ].IsValid() );
+
+	Document->OnMouseButtonDown( Geometry, MakeEvent( OnLink ) );
+	Document->OnMouseButtonUp( Geometry, MakeEvent( OffLink ) );
+	TestEqual( "Releasing off the link isn't a click", Clicks.Num(), 0 );
+
+	TestTrue( "Pressing a link is handled", Document->OnMouseButtonDown( Geometry, MakeEvent( OnLink ) ).IsEventHandled() );
+	Document->OnMouseButtonUp( Geometry, MakeEvent( OnLink ) );
+	if ( !TestEqual( "Clicking the link fires OnRunClicked", Clicks.Num(), 1 ) )
+		return false;
+	TestEqual( "With the link's content", Clicks[ 0 ].Content, FString( "Glossary" ) );
+	TestEqual( "And payload", Clicks[ 0 ].Pairs.FindRef( "id" ), FString( "glossary" ) );
+
+	// Blueprints bind to the dynamic one, and read the payload from the struct
+	const FMulticastDelegateProperty* DynamicEvent = FindFProperty<FMulticastDelegateProperty>( UBYGRichTextBlock::StaticClass(), "OnRunClicked" );
+	TestTrue( "OnRunClicked can be bound in Blueprints", DynamicEvent && DynamicEvent->HasAnyPropertyFlags( CPF_BlueprintAssignable ) );
+	TestNotNull( "Payload is visible to Blueprints", FindFProperty<FMapProperty>( FBYGStyleTagData::StaticStruct(), "Pairs" ) );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentHitTestTest, "BYG.RichText.Document.HitTest", DocumentTestFlags | EAutomationTestFlags::CommandletContext )
+bool FBYGRichTextDocumentHitTestTest::RunTest( const FString& Parameters )
+{
+	const FGeometry Root = FGeometry::MakeRoot( FVector2D( 200.0f, 100.0f ), FSlateLayoutTransform() );
+	// A second block, as the document lays them out
+	const FGeometry BlockGeometry = Root.MakeChild( FVector2D( 200.0f, 20.0f ), FSlateLayoutTransform( FVector2D( 0.0f, 40.0f ) ) );
+
+	TSharedRef<FBYGRunInteraction> Link = MakeShared<FBYGRunInteraction>();
+	Link->Data.Content = "glossary";
+	Link->bClickable = true;
+
+	FBYGRunHitTestIndex Index;
+	Index.Reset( Root );
+	Index.AddRun( BlockGeometry, FVector2D( 10.0f, 0.0f ), FVector2D( 50.0f, 20.0f ), Link );
+
+	TestTrue( "Finds the run under the mouse", Index.FindRun( Root, FVector2D( 20.0f, 50.0f ) ) == Link );
+	TestFalse( "Nothing beside the run", Index.FindRun( Root, FVector2D( 100.0f, 50.0f ) ).IsValid() );
+	TestFalse( "Nothing in another block", Index.FindRun( Root, FVector2D( 20.0f, 10.0f ) ).IsValid() );
+
+	// The widget moved without painting again, e.g. its parent scrolled
+	const FGeometry Moved = FGeometry::MakeRoot( FVector2D( 200.0f, 100.0f ), FSlateLayoutTransform( FVector2D( 30.0f, 0.0f ) ) );
+	TestTrue( "Follows the widget when it moves", Index.FindRun( Moved, FVector2D( 50.0f, 50.0f ) ) == Link );
+
+	Index.Reset( Root );
+	TestEqual( "Painting again starts over", Index.Num(), 0 );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDocumentRunToolTipTest, "BYG.RichText.Document.RunToolTip", DocumentTestFlags | EAutomationTestFlags::CommandletContext )
+bool FBYGRichTextDocumentRunToolTipTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	const UBYGRichTextTooltipProperty* First = NewObject<UBYGRichTextTooltipProperty>();
+	const UBYGRichTextTooltipProperty* Second = NewObject<UBYGRichTextTooltipProperty>();
+
+	FBYGStyleTagData FirstData;
+	FirstData.Content = "first";
+	FBYGStyleTagData SecondData;
+	SecondData.Content = "second";
+	SecondData.Pairs.Add( "id", "second" );
+
+	TSharedPtr<IToolTip> FirstToolTip = First->CreateRunToolTip( Block, FirstData );
+	if ( !TestTrue( "Tooltip runs have a tooltip", FirstToolTip.IsValid() ) )
+		return false;
+	TSharedPtr<IToolTip> SecondToolTip = Second->CreateRunToolTip( Block, SecondData );
+	TestTrue( "Runs in a block share one tooltip", FirstToolTip == SecondToolTip );
+	const FBYGStyleTagData& SharedData = StaticCastSharedPtr<FBYGDelegateToolTip>( SecondToolTip )->GetData();
+	TestEqual( "Pointed at the last hovered run", SharedData.Content, FString( "second" ) );
+	TestEqual( "With its payload", SharedData.Pairs.FindRef( "id" ), FString( "second" ) );
+
+	UBYGRichTextBlock* OtherBlock = NewObject<UBYGRichTextBlock>();
+	TestTrue( "Other blocks have their own", First->CreateRunToolTip( OtherBlock, FirstData ) != FirstToolTip );
+
+	return true;
+}
@@ -0,0 +1,334 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#include "Core/BYGRichTextLayoutCache.h"
+#include "Core/BYGRichTextLayoutPredictor.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGRichTextPrewarm.h"
+#include "Core/BYGTextMeasure.h"
+#include "Core/BYGTextRun.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Commandlets/Commandlet.h"
+#include "Internationalization/StringTable.h"
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "Settings/BYGRichTextStylesheet.h"
+#include "Settings/BYGRichTextStyle.h"
+#include "Styling/CoreStyle.h"
+
+static const int LayoutTestFlags = (
+	EAutomationTestFlags::EditorContext
+	| EAutomationTestFlags::CommandletContext
+	| EAutomationTestFlags::ClientContext
+	| EAutomationTestFlags::ProductFilter );
+
+static UBYGRichTextStylesheet* CreateLayoutTestStylesheet()
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "h1" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Block );
+		Style->SetShortcut( "#" );
+		UBYGRichTextSizeProperty* Size = NewObject<UBYGRichTextSizeProperty>();
+		Size->SetSize( 40 );
+		Style->Properties.Add( Size );
+		Stylesheet->AddStyle( Style );
+	}
+	return Stylesheet;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextLayoutPredictTest, "BYG.RichText.Layout.Predict", LayoutTestFlags )
+bool FBYGRichTextLayoutPredictTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = CreateLayoutTestStylesheet();
+
+	const FString LongText = "The quick brown fox jumps over the lazy dog and keeps running until the end of the line";
+
+	const FBYGPredictedLayout OneLine = FBYGRichTextLayoutPredictor::Predict( "Hello World", Stylesheet, 0.0f );
+	TestEqual( "Single block", OneLine.BlockHeights.Num(), 1 );
+	TestEqual( "Single line", OneLine.BlockLineCounts[ 0 ], 1 );
+	TestTrue( "Has a size", OneLine.DesiredSize.X > 0.0f && OneLine.DesiredSize.Y > 0.0f );
+
+	const FBYGPredictedLayout Unwrapped = FBYGRichTextLayoutPredictor::Predict( LongText, Stylesheet, 0.0f );
+	const FBYGPredictedLayout Wrapped = FBYGRichTextLayoutPredictor::Predict( LongText, Stylesheet, Unwrapped.DesiredSize.X / 3.0f );
+	TestEqual( "No wrap width is one line", Unwrapped.BlockLineCounts[ 0 ], 1 );
+	TestTrue( "Wraps onto more lines", Wrapped.BlockLineCounts[ 0 ] >= 3 );
+	TestTrue( "Wrapped fits in the wrap width", Wrapped.DesiredSize.X <= Unwrapped.DesiredSize.X / 3.0f );
+	TestEqual( "Each wrapped line is as tall as the unwrapped line", Wrapped.DesiredSize.Y, Unwrapped.DesiredSize.Y * Wrapped.BlockLineCounts[ 0 ], 0.5f );
+
+	const FBYGPredictedLayout Blocks = FBYGRichTextLayoutPredictor::Predict( "# Heading\r\n\r\nBody", Stylesheet, 0.0f );
+	TestEqual( "Two blocks", Blocks.BlockHeights.Num(), 2 );
+	TestTrue( "Bigger font is taller", Blocks.BlockHeights[ 0 ] > Blocks.BlockHeights[ 1 ] );
+	TestEqual( "Blocks are stacked", Blocks.DesiredSize.Y, Blocks.BlockHeights[ 0 ] + Blocks.BlockHeights[ 1 ], 0.01f );
+
+	const FBYGPredictedLayout Scaled = FBYGRichTextLayoutPredictor::Predict( "Hello World", Stylesheet, 0.0f, 2.0f );
+	TestEqual( "Scale is removed from the result", Scaled.DesiredSize.Y, OneLine.DesiredSize.Y, 1.0f );
+
+	// Worker threads measure with the headless font cache, which should agree with the renderer
+	const float WrapWidth = Unwrapped.DesiredSize.X / 3.0f;
+	FBYGRichTextLayoutCache::Get().Empty();
+	const FBYGPredictedLayout Worker = Async( EAsyncExecution::ThreadPool, [ LongText, Stylesheet, WrapWidth ]()
+	{
+		return FBYGRichTextLayoutPredictor::Predict( LongText, Stylesheet, WrapWidth );
+	} ).Get();
+	TestEqual( "Same lines on a worker thread", Worker.BlockLineCounts[ 0 ], Wrapped.BlockLineCounts[ 0 ] );
+	TestEqual( "Same size on a worker thread", Worker.DesiredSize, Wrapped.DesiredSize, 0.5f );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextLayoutHeadlessMeasureTest, "BYG.RichText.Layout.HeadlessMeasure", LayoutTestFlags )
+bool FBYGRichTextLayoutHeadlessMeasureTest::RunTest( const FString& Parameters )
+{
+	// Doesn't touch FSlateApplication, so this runs the same in commandlets and under -nullrhi
+	const TSharedRef<IBYGTextMeasure> Measure = FBYGTextMeasure::GetHeadless();
+	TestTrue( "Headless measure is shared", &FBYGTextMeasure::GetHeadless().Get() == &Measure.Get() );
+	TestTrue( "Measure is created once", &FBYGTextMeasure::Get().Get() == &FBYGTextMeasure::Get().Get() );
+
+	const FSlateFontInfo Font = FCoreStyle::GetDefaultFontStyle( "Regular", 10 );
+	const FVector2D Short = Measure->Measure( "Hello", Font );
+	const FVector2D Long = Measure->Measure( "Hello World", Font );
+	TestTrue( "Text has a size", Short.X > 0.0f && Short.Y > 0.0f );
+	TestTrue( "Longer text is wider", Long.X > Short.X );
+	TestEqual( "Same line height", Long.Y, Short.Y );
+	TestEqual( "Part of a string", Measure->Measure( "Hello World", 0, 5, Font ), Short );
+	TestTrue( "Bigger at a bigger scale", Measure->Measure( "Hello", Font, 2.0f ).X > Short.X * 1.5f );
+	TestTrue( "Baseline is below the top", Measure->GetBaseline( Font ) < 0 );
+	TestTrue( "Has a line height", Measure->GetMaxCharacterHeight( Font ) > 0 );
+
+	// Same answer off the game thread
+	const FVector2D OffThread = Async( EAsyncExecution::ThreadPool, [ Font ]()
+	{
+		return FBYGTextMeasure::Get()->Measure( "Hello", Font );
+	} ).Get();
+	TestEqual( "Measures the same off the game thread", OffThread, Short );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextLayoutSharedTest, "BYG.RichText.Layout.Shared", LayoutTestFlags )
+bool FBYGRichTextLayoutSharedTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = CreateLayoutTestStylesheet();
+	FBYGRichTextParseCache::Get().Empty();
+	FBYGRichTextLayoutCache::Get().Empty();
+
+	TSharedRef<FBYGRichTextMarkupParser> First = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+	TSharedRef<FBYGRichTextMarkupParser> Second = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+	First->ParseBlocks( "Requires level 10" );
+	Second->ParseBlocks( "Requires level 10" );
+	TestEqual( "Same text is parsed once", FBYGRichTextParseCache::Get().NumShared(), 1 );
+
+	TArray<FTextLineParseResults> Results;
+	FString Output;
+	Second->ParseBlocks( "REQUIRES LEVEL 10" );
+	Second->Process( Results, "REQUIRES LEVEL 10", Output );
+	TestEqual( "Text differing in case is parsed separately", FBYGRichTextParseCache::Get().NumShared(), 2 );
+	TestTrue( "Output keeps its case", Output.Contains( "REQUIRES LEVEL 10", ESearchCase::CaseSensitive ) );
+
+	const FBYGPredictedLayout Predicted = FBYGRichTextLayoutPredictor::Predict( "Requires level 10", Stylesheet, 200.0f );
+	TestEqual( "Layout is cached", FBYGRichTextLayoutCache::Get().Num(), 1 );
+	const FBYGPredictedLayout Again = FBYGRichTextLayoutPredictor::Predict( "Requires level 10", Stylesheet, 200.0f );
+	TestEqual( "Same layout from the cache", Again.DesiredSize, Predicted.DesiredSize );
+	TestEqual( "Still one layout", FBYGRichTextLayoutCache::Get().Num(), 1 );
+	FBYGRichTextLayoutPredictor::Predict( "Requires level 10", Stylesheet, 100.0f );
+	TestEqual( "Wrap width is part of the key", FBYGRichTextLayoutCache::Get().Num(), 2 );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextLayoutPrewarmTest, "BYG.RichText.Layout.Prewarm", LayoutTestFlags )
+bool FBYGRichTextLayoutPrewarmTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = CreateLayoutTestStylesheet();
+	FBYGRichTextParseCache::Get().Empty();
+	FBYGRichTextLayoutCache::Get().Empty();
+
+	TFuture<void> Prewarm = FBYGRichTextPrewarm::PrewarmTexts( Stylesheet, {
+		FText::FromString( "# Inventory" ),
+		FText::FromString( "Requires level 10" ),
+		FText::FromString( "Requires level 10" ),
+	} );
+	Prewarm.Wait();
+	TestFalse( "The stylesheet can be edited once the future is ready", Stylesheet->IsPrewarming() );
+	TestEqual( "Each distinct text is parsed once", FBYGRichTextParseCache::Get().NumShared(), 2 );
+	TestEqual( "Layout isn't predicted unless asked", FBYGRichTextLayoutCache::Get().Num(), 0 );
+
+	FBYGRichTextParseCache::Get().ResetHitCounts();
+	FBYGRichTextMarkupParser::Create( Stylesheet, "s" )->ParseBlocks( "Requires level 10" );
+	int64 Hits = 0;
+	int64 Misses = 0;
+	FBYGRichTextParseCache::Get().GetHitCounts( Hits, Misses );
+	TestEqual( "Parsing afterwards hits the cache", Hits, ( int64 )1 );
+	TestEqual( "Parsing afterwards doesn't miss", Misses, ( int64 )0 );
+
+	FBYGRichTextPrewarm::PrewarmTexts( Stylesheet, { FText::FromString( "# Inventory" ) }, true, 200.0f ).Wait();
+	TestEqual( "Layout is predicted when asked", FBYGRichTextLayoutCache::Get().Num(), 1 );
+
+	LOCTABLE_NEW( "BYGRichTextPrewarmTest", "BYGRichTextPrewarmTest" );
+	LOCTABLE_SETSTRING( "BYGRichTextPrewarmTest", "Title", "# Settings" );
+	LOCTABLE_SETSTRING( "BYGRichTextPrewarmTest", "Back", "Back" );
+	FBYGRichTextPrewarm::PrewarmStringTables( Stylesheet, { "BYGRichTextPrewarmTest" } ).Wait();
+	TestEqual( "Every string table entry is parsed", FBYGRichTextParseCache::Get().NumShared(), 4 );
+	FStringTableRegistry::Get().UnregisterStringTable( "BYGRichTextPrewarmTest" );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextCompiledMarkupTest, "BYG.RichText.CompiledMarkup", LayoutTestFlags )
+bool FBYGRichTextCompiledMarkupTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = CreateLayoutTestStylesheet();
+	TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+	const uint32 ParseHash = Parser->GetParseHash();
+
+	FBYGCompiledMarkupMap Compiled;
+	for ( const FString& String : { FString( "# Inventory\r\n\r\nRequires level 10" ), FString( "OK" ), FString( "ok" ) } )
+	{
+		Compiled.Add( String, Parser->ParseFully( String ) );
+	}
+	TestEqual( "Strings differing in case are compiled separately", Compiled.Num(), 3 );
+
+	const FString Filename = FPaths::Combine( FPaths::AutomationTransientDir(), TEXT( "BYGRichTextCompiledMarkupTest.bygm" ) );
+	TestTrue( "Saved", FBYGRichTextParseCache::SaveCompiledFile( Filename, "BYGRichTextCompiledMarkupTest", ParseHash, Compiled ) );
+
+	FBYGRichTextParseCache::Get().Empty();
+	TestTrue( "Loaded", FBYGRichTextParseCache::Get().LoadCompiledFile( Filename ) );
+	TestEqual( "Every string is loaded", FBYGRichTextParseCache::Get().Num(), Compiled.Num() );
+
+	for ( const TPair<FString, TSharedRef<FBYGParsedText>>& Pair : Compiled )
+	{
+		const TSharedPtr<const FBYGParsedText> Loaded = FBYGRichTextParseCache::Get().Find( ParseHash, Pair.Key );
+		if ( !TestTrue( FString::Printf( TEXT( "'%s' is in the cache" ), *Pair.Key ), Loaded.IsValid() ) )
+			continue;
+
+		const FBYGParsedText& Expected = *Pair.Value;
+		if ( !TestEqual( "Same number of blocks", Loaded->Blocks.Num(), Expected.Blocks.Num() ) )
+			continue;
+		for ( int32 i = 0; i < Expected.Blocks.Num(); ++i )
+		{
+			TestEqual( "Same raw text", Loaded->Blocks[ i ].RawText, Expected.Blocks[ i ].RawText );
+			TestEqual( "Same block styles", Loaded->Blocks[ i ].StylesApplied, Expected.Blocks[ i ].StylesApplied );
+			TestEqual( "Same inline output", Loaded->BlockRuns[ i ].Output, Expected.BlockRuns[ i ].Output );
+			TestEqual( "Same number of lines", Loaded->BlockRuns[ i ].Lines.Num(), Expected.BlockRuns[ i ].Lines.Num() );
+		}
+		TestEqual( "Same styles used", Loaded->UsedStyleIDs, Expected.UsedStyleIDs );
+		TestEqual( "Same property types used", Loaded->UsedPropertyTypeIDs, Expected.UsedPropertyTypeIDs );
+	}
+
+	TestFalse( "A different parse hash doesn't find anything", FBYGRichTextParseCache::Get().Find( ParseHash + 1, "OK" ).IsValid() );
+
+	FBYGRichTextParseCache::Get().Empty();
+	IFileManager::Get().Delete( *Filename );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextCompileMarkupCommandletTest, "BYG.RichText.CompileMarkupCommandlet", LayoutTestFlags )
+bool FBYGRichTextCompileMarkupCommandletTest::RunTest( const FString& Parameters )
+{
+	// Found the same way -run=BYGRichTextCompileMarkup finds it, so this fails if its module isn't loaded
+	UClass* CommandletClass = FindObject<UClass>( ANY_PACKAGE, TEXT( "BYGRichTextCompileMarkupCommandlet" ) );
+	if ( !TestNotNull( "Commandlet is loaded", CommandletClass ) )
+		return false;
+
+	UStringTable* StringTable = NewObject<UStringTable>( GetTransientPackage(), MakeUniqueObjectName( GetTransientPackage(), UStringTable::StaticClass(), "BYGRichTextCompileMarkupTest" ) );
+	StringTable->GetMutableStringTable()->SetSourceString( "Title", "# Inventory" );
+	StringTable->GetMutableStringTable()->SetSourceString( "Hint", "Press *E* to open" );
+
+	// A native stylesheet class, so there's nothing to load from disk
+	const FString StylesheetPath = UBYGRichTextStylesheet::StaticClass()->GetPathName();
+	const FString Filename = FPaths::Combine( FPaths::ConvertRelativePathToFull( FPaths::AutomationTransientDir() ), TEXT( "BYGRichTextCompileMarkupCommandletTest.bygm" ) );
+	UCommandlet* Commandlet = NewObject<UCommandlet>( GetTransientPackage(), CommandletClass );
+	const int32 Result = Commandlet->Main( FString::Printf( TEXT( "-Stylesheet=%s -StringTables=%s -Output=\"%s\"" ), *StylesheetPath, *StringTable->GetPathName(), *Filename ) );
+	TestEqual( "Commandlet succeeds", Result, 0 );
+
+	FBYGRichTextParseCache::Get().Empty();
+	TestTrue( "Output can be loaded", FBYGRichTextParseCache::Get().LoadCompiledFile( Filename ) );
+	const uint32 ParseHash = FBYGRichTextMarkupParser::Create( GetDefault<UBYGRichTextStylesheet>(), "s" )->GetParseHash();
+	TestTrue( "Has the first string", FBYGRichTextParseCache::Get().Find( ParseHash, "# Inventory" ).IsValid() );
+	TestTrue( "Has the second string", FBYGRichTextParseCache::Get().Find( ParseHash, "Press *E* to open" ).IsValid() );
+
+	AddExpectedError( TEXT( "Usage: -run=BYGRichTextCompileMarkup" ), EAutomationExpectedErrorFlags::Contains, 1 );
+	TestEqual( "Missing arguments fail", Commandlet->Main( FString::Printf( TEXT( "-Stylesheet=%s" ), *StylesheetPath ) ), 1 );
+
+	FBYGRichTextParseCache::Get().Empty();
+	IFileManager::Get().Delete( *Filename );
+	StringTable->MarkPendingKill();
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextLayoutRunBrushesTest, "BYG.RichText.Layout.RunBrushes", LayoutTestFlags )
+bool FBYGRichTextLayoutRunBrushesTest::RunTest( const FString& Parameters )
+{
+	FSlateBrush Brush;
+	Brush.ImageSize = FVector2D( 48.0f, 48.0f );
+	const TMap<FString, FString> Payload;
+
+	// Backgrounds and icons are painted by the text run, not a nested text block
+	UBYGRichTextBackgroundBrushProperty* Background = NewObject<UBYGRichTextBackgroundBrushProperty>();
+	Background->SetBrush( Brush );
+	Background->SetHAlign( HAlign_Fill );
+	Background->SetVAlign( VAlign_Center );
+	Background->SetMargin( FMargin( 2.0f ) );
+	FBYGRunBrushInfo BackgroundInfo;
+	TestFalse( "Background doesn't need a text block", Background->RequiresInlineTextBlock() );
+	TestTrue( "Background has a run brush", Background->GetRunBrush( Payload, BackgroundInfo ) );
+	TestNotNull( "Background brush", BackgroundInfo.Brush );
+	TestEqual( "Background alignment", BackgroundInfo.VAlign, VAlign_Center );
+	TestEqual( "Background padding", BackgroundInfo.Padding, FMargin( 2.0f ) );
+	TestFalse( "Backgrounds don't size the run", BackgroundInfo.bSizeToBrush );
+
+	UBYGRichTextInlineBrushProperty* Inline = NewObject<UBYGRichTextInlineBrushProperty>();
+	Inline->SetBrush( Brush );
+	FBYGRunBrushInfo InlineInfo;
+	TestFalse( "Inline image doesn't need a text block", Inline->RequiresInlineTextBlock() );
+	TestTrue( "Inline image has a run brush", Inline->GetRunBrush( Payload, InlineInfo ) );
+	TestTrue( "Inline images size the run", InlineInfo.bSizeToBrush );
+	TestEqual( "Predicted size matches the brush", Inline->GetRunMinSize( Payload ), FVector2D( 48.0f, 48.0f ) );
+
+	// Measuring glyphs needs the font service
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	FTextBlockStyle Style;
+	Style.SetFont( FCoreStyle::GetDefaultFontStyle( "Regular", 10 ) );
+	const TSharedRef<const FString> Text = MakeShared<const FString>( "Hi there" );
+	const FTextRange Range( 0, Text->Len() );
+
+	TSharedRef<FBYGTextRun> PlainRun = FBYGTextRun::Create( FRunInfo(), Text, Style, Range, FBYGRunRevealInfo() );
+	TSharedRef<FBYGTextRun> IconRun = FBYGTextRun::Create( FRunInfo(), Text, Style, Range, FBYGRunRevealInfo(), { InlineInfo } );
+	TSharedRef<FBYGTextRun> BackgroundRun = FBYGTextRun::Create( FRunInfo(), Text, Style, Range, FBYGRunRevealInfo(), { BackgroundInfo } );
+
+	TestTrue( "Plain text is shorter than the icon", PlainRun->GetMaxHeight( 1.0f ) < 48 );
+	TestEqual( "Icon run is as tall as the brush", IconRun->GetMaxHeight( 1.0f ), ( int16 )48 );
+	TestEqual( "Icon run scales with the layout", IconRun->GetMaxHeight( 2.0f ), ( int16 )96 );
+	TestEqual( "Background run keeps the text height", BackgroundRun->GetMaxHeight( 1.0f ), PlainRun->GetMaxHeight( 1.0f ) );
+	TestTrue( "Text is centred on the taller icon", IconRun->GetBaseLine( 1.0f ) < PlainRun->GetBaseLine( 1.0f ) );
+
+	return true;
+}
@@ -5,6 +5,9 @@
 #include "Misc/AutomationTest.h"
 
 #include "Widget/BYGRichTextBlock.h"
+#include "Core/BYGRichTextLayoutCache.h"
+#include "Core/BYGRichTextLayoutPredictor.h"
+#include "Async/Async.h"
 #include <Framework/Text/ITextDecorator.h>
 #include "Settings/BYGRichTextStylesheet.h"
 #include <Tests/AutomationEditorCommon.h>
@@ -283,3 +286,190 @@ void UBYGRichTextStylesheet::FillWithMarkdown()
 	}
 }
 #endif
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextStylesheetThemes, "BYG.RichText.StylesheetThemes", StylesheetTestFlags )
+bool FBYGRichTextStylesheetThemes::RunTest( const FString& Parameters )
+{
+	// Same styles with different colours, added in a different order
+	auto MakeTheme = []( const FLinearColor& StrongColor, bool bReversed )
+	{
+		UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+		UBYGRichTextStyle* Default = NewObject<UBYGRichTextStyle>();
+		Default->SetID( "default" );
+		UBYGRichTextStyle* Strong = NewObject<UBYGRichTextStyle>();
+		Strong->SetID( "strong" );
+		Strong->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Strong->SetShortcut( "*" );
+		UBYGRichTextColorProperty* Color = NewObject<UBYGRichTextColorProperty>();
+		Color->SetColor( StrongColor );
+		Strong->Properties.Add( Color );
+
+		Stylesheet->AddStyle( bReversed ? Strong : Default );
+		Stylesheet->AddStyle( bReversed ? Default : Strong );
+		Stylesheet->SetDefaultStyleName( "default" );
+		return Stylesheet;
+	};
+	UBYGRichTextStylesheet* Light = MakeTheme( FLinearColor::Black, false );
+	UBYGRichTextStylesheet* Dark = MakeTheme( FLinearColor::Red, true );
+
+	TestEqual( "Same styles parse the same", Light->GetParseHash(), Dark->GetParseHash() );
+
+	FString LightOut;
+	FString DarkOut;
+	TArray<FTextLineParseResults> Results;
+	FBYGRichTextMarkupParser::Create( Light, "s" )->Process( Results, "Hello *World*", LightOut );
+	FBYGRichTextMarkupParser::Create( Dark, "s" )->Process( Results, "Hello *World*", DarkOut );
+	TestEqual( "Parser output doesn't depend on the order of styles", LightOut, DarkOut );
+	TestTrue( "Refers to properties by style", LightOut.Contains( "strong.TextColor" ) );
+
+	const TSharedRef<const FBYGResolvedRunStyle> LightRun = Light->ResolveRunStyle( "strong.TextColor" );
+	const TSharedRef<const FBYGResolvedRunStyle> DarkRun = Dark->ResolveRunStyle( "strong.TextColor" );
+	TestEqual( "Resolves against its own stylesheet", DarkRun->TextStyle.ColorAndOpacity.GetSpecifiedColor(), FLinearColor::Red );
+	TestTrue( "Themes don't share resolved styles", LightRun != DarkRun );
+	TestTrue( "Combinations are resolved once", Dark->ResolveRunStyle( "strong.TextColor" ) == DarkRun );
+
+	// The parser applies the last property of a type in a style, so the ID has to find that one
+	UBYGRichTextColorProperty* Override = NewObject<UBYGRichTextColorProperty>();
+	Override->SetColor( FLinearColor::Green );
+	Dark->FindStyle( "strong" )->AddProperty( Override );
+	TestTrue( "Last property of a type wins", Dark->FindProperty( "strong.TextColor" ) == Override );
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextStylesheetHandles, "BYG.RichText.StylesheetHandles", StylesheetTestFlags )
+bool FBYGRichTextStylesheetHandles::RunTest( const FString& Parameters )
+{
+	auto MakeStyle = []( const FName& ID )
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( ID );
+		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Style->Properties.Add( NewObject<UBYGRichTextColorProperty>() );
+		return Style;
+	};
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	Stylesheet->AddStyle( MakeStyle( "first" ) );
+	Stylesheet->AddStyle( MakeStyle( "second" ) );
+
+	const FBYGStylesheetHandle Handle = Stylesheet->FindPropertyHandle( "second.TextColor" );
+	const FBYGStylesheetHandle StyleHandle = Stylesheet->FindStyleHandle( "second" );
+	const UBYGRichTextPropertyBase* Prop = Stylesheet->ResolveProperty( Handle );
+	TestNotNull( "Finds the property", Prop );
+	const TSharedRef<const FBYGResolvedRunStyle> RunStyle = Stylesheet->ResolveRunStyle( "second.TextColor" );
+
+	Stylesheet->AddStyle( MakeStyle( "third" ) );
+	Stylesheet->RemoveStyle( "first" );
+	TestTrue( "Unrelated edits keep the handle", Stylesheet->ResolveProperty( Handle ) == Prop );
+	TestNotNull( "Unrelated edits keep the style handle", Stylesheet->ResolveStyle( StyleHandle ) );
+	TestTrue( "Unrelated edits keep resolved runs", Stylesheet->ResolveRunStyle( "second.TextColor" ) == RunStyle );
+
+	Stylesheet->RemoveStyle( "second" );
+	TestNull( "Removed properties don't resolve", Stylesheet->ResolveProperty( Handle ) );
+	TestNull( "Removed styles don't resolve", Stylesheet->ResolveStyle( StyleHandle ) );
+
+	Stylesheet->AddStyle( MakeStyle( "second" ) );
+	TestNull( "A replacement doesn't resolve through the old handle", Stylesheet->ResolveProperty( Handle ) );
+	TestNotNull( "The replacement has its own handle", Stylesheet->ResolveProperty( Stylesheet->FindPropertyHandle( "second.TextColor" ) ) );
+	TestTrue( "Runs using it are resolved again", Stylesheet->ResolveRunStyle( "second.TextColor" ) != RunStyle );
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextStylesheetRuntimeEdits, "BYG.RichText.StylesheetRuntimeEdits", StylesheetTestFlags )
+bool FBYGRichTextStylesheetRuntimeEdits::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	UBYGRichTextStyle* Default = NewObject<UBYGRichTextStyle>();
+	Default->SetID( "default" );
+	UBYGRichTextStyle* Strong = NewObject<UBYGRichTextStyle>();
+	Strong->SetID( "strong" );
+	Strong->SetShortcut( "*" );
+	UBYGRichTextColorProperty* Color = NewObject<UBYGRichTextColorProperty>();
+	Color->SetColor( FLinearColor::Red );
+	Strong->Properties.Add( Color );
+	Stylesheet->AddStyle( Default );
+	Stylesheet->AddStyle( Strong );
+	Stylesheet->SetDefaultStyleName( "default" );
+
+	const FBYGStylesheetHandle Handle = Stylesheet->FindPropertyHandle( "strong.TextColor" );
+	const FBYGStylesheetHandle DefaultHandle = Stylesheet->FindStyleHandle( "default" );
+	const TSharedRef<const FBYGResolvedRunStyle> RunStyle = Stylesheet->ResolveRunStyle( "strong.TextColor" );
+	FBYGRichTextLayoutCache::Get().Empty();
+	FBYGRichTextLayoutPredictor::Predict( "Hello *World*", Stylesheet, 0.0f );
+	TestEqual( "Layout is cached", FBYGRichTextLayoutCache::Get().Num(), 1 );
+
+	// Outside the editor there's no PostEditChangeProperty, the setters have to do it
+	Color->SetColor( FLinearColor::Blue );
+	TestNull( "Setting a value makes handles to the property stale", Stylesheet->ResolveProperty( Handle ) );
+	TestNotNull( "Other styles keep their handles", Stylesheet->ResolveStyle( DefaultHandle ) );
+	TestTrue( "The property has a new handle", Stylesheet->ResolveProperty( Stylesheet->FindPropertyHandle( "strong.TextColor" ) ) == Color );
+	const TSharedRef<const FBYGResolvedRunStyle> NewRunStyle = Stylesheet->ResolveRunStyle( "strong.TextColor" );
+	TestTrue( "Runs using it are resolved again", NewRunStyle != RunStyle );
+	TestEqual( "With the new value", NewRunStyle->TextStyle.ColorAndOpacity.GetSpecifiedColor(), FLinearColor::Blue );
+	TestEqual( "Predicted layouts are dropped", FBYGRichTextLayoutCache::Get().Num(), 0 );
+
+	const uint32 ParseHash = Stylesheet->GetParseHash();
+	Strong->SetShortcut( "_" );
+	TestTrue( "Style setters change the parse hash", Stylesheet->GetParseHash() != ParseHash );
+	TestNull( "Style setters make every handle stale", Stylesheet->ResolveStyle( DefaultHandle ) );
+
+	Strong->SetID( "bold" );
+	TestTrue( "Properties are looked up under the new ID", Stylesheet->FindProperty( "bold.TextColor" ) == Color );
+	TestNull( "And not the old one", Stylesheet->FindProperty( "strong.TextColor" ) );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextStylesheetConcurrentLookup, "BYG.RichText.StylesheetConcurrentLookup", StylesheetTestFlags )
+bool FBYGRichTextStylesheetConcurrentLookup::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	UBYGRichTextStyle* Default = NewObject<UBYGRichTextStyle>();
+	Default->SetID( "default" );
+	UBYGRichTextStyle* Strong = NewObject<UBYGRichTextStyle>();
+	Strong->SetID( "strong" );
+	UBYGRichTextColorProperty* Color = NewObject<UBYGRichTextColorProperty>();
+	Strong->Properties.Add( Color );
+	Stylesheet->AddStyle( Default );
+	Stylesheet->AddStyle( Strong );
+	Stylesheet->SetDefaultStyleName( "default" );
+
+	// Workers look things up the way predicted layouts do, while the game thread rebuilds and touches the lookup
+	FThreadSafeBool bStop = false;
+	FThreadSafeCounter NumMissing;
+	TArray<TFuture<void>> Readers;
+	for ( int32 i = 0; i < 4; ++i )
+	{
+		Readers.Add( Async( EAsyncExecution::ThreadPool, [ Stylesheet, &bStop, &NumMissing ]()
+		{
+			while ( !bStop )
+			{
+				const TSharedRef<const FBYGResolvedRunStyle> RunStyle = Stylesheet->ResolveRunStyle( "strong.TextColor" );
+				if ( RunStyle->Properties.Num() != 1 || !Stylesheet->FindProperty( "strong.TextColor" ) )
+				{
+					NumMissing.Increment();
+				}
+			}
+		} ) );
+	}
+
+	for ( int32 i = 0; i < 200; ++i )
+	{
+		Stylesheet->RebuildLookup();
+		Stylesheet->NotifyPropertyChanged( Color, "strong" );
+		Stylesheet->BroadcastChange( FBYGStylesheetChange() );
+	}
+	bStop = true;
+	for ( TFuture<void>& Reader : Readers )
+	{
+		Reader.Wait();
+	}
+
+	TestEqual( "Readers never see a half-rebuilt lookup", NumMissing.GetValue(), 0 );
+	TestTrue( "Lookup still works", Stylesheet->FindProperty( "strong.TextColor" ) == Color );
+
+	return true;
+}
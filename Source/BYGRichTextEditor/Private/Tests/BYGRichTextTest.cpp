@@ -7,6 +7,17 @@
 #include "Widget/BYGRichTextBlock.h"
 #include <Framework/Text/ITextDecorator.h>
 #include "Settings/BYGRichTextStylesheet.h"
+#include "Settings/BYGRichTextStyle.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Core/BYGRingBuffer.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "BYGRichTextRuntimeSettings.h"
+#include "BYGRichTextModule.h"
+#include "BYGRichTextTestTextSource.h"
+#include "BYGRichTextTestTooltipWidget.h"
+#include "Engine/World.h"
+#include "Misc/ScopeExit.h"
 #include <Tests/AutomationEditorCommon.h>
 #include <FunctionalTestBase.h>
 
@@ -20,74 +31,86 @@ static const int TestFlags = (
 FBYGRichTextParseTestBase::FBYGRichTextParseTestBase( const FString& InName, const bool bInComplexTask )
 	: FFunctionalTestBase( InName, bInComplexTask )
 {
+	// Properties are listed in the order of the defaults, which are sorted by type. Only strong has a property
+	const FString Default = TEXT( "Justification LineHeightPercent LineWrap Size TextColor Typeface" );
+	const FString Strong = TEXT( "Justification LineHeightPercent LineWrap Size strong\\.TextColor Typeface" );
+
 	TestData = {
 		{ "No formatting", {
 			"Hello World",
-			"<s ids=\"0 1 2 3 4 5\">Hello World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello World</>" ), *Default ),
 		} },
 		{ "Inline shortcut tag", {
 			"Hello *World*",
-			"<s ids=\"0 1 2 3 4 5\">Hello </><s ids=\"[0-9 ]+\">World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello </><s ids=\"%s\">World</>" ), *Default, *Strong ),
 		} },
 		{ "Inline tags", {
 			"Hello [strong]World[/]",
-			"<s ids=\"[0-9 ]+\">Hello </><s ids=\"[0-9 ]+\">World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello </><s ids=\"%s\">World</>" ), *Default, *Strong ),
 		} },
 		{ "Escape characters", {
 			"Hello \\[style\\]World",
-			"<s ids=\"[0-9 ]+\">Hello \\[style\\]World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello \\[style\\]World</>" ), *Default ),
 		} },
 		{ "End tab without starting", {
 			"Hello[/] World",
-			"<s ids=\"[0-9 ]+\">Hello World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello World</>" ), *Default ),
 		} },
 		{ "Tag with spaces", {
 			"[ strong ]Hello[/] World",
-			"<s ids=\"[0-9 ]+\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with start space", {
 			"[ strong]Hello[/] World",
-			"<s ids=\"[0-9 ]+\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "End tag with end space", {
 			"[strong]Hello[/ ] World",
-			"<s ids=\"[0-9 ]+\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "End tag with more spaces", {
 			"[strong]Hello[ / ] World",
-			"<s ids=\"[0-9 ]+\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with mismatching case", {
 			"[Strong]Hello[/] World",
-			"<s ids=\"[0-9 ]+\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with payload", {
 			"[strong img:cool]Hello[/] World",
-			"<s ids=\"[0-9 ]+\" img=\"cool\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\" img=\"cool\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with payload and quotes", {
 			"[strong mykey:\"great stuff\"]Hello[/] World",
-			"<s ids=\"[0-9 ]+\" mykey=\"great stuff\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\" mykey=\"great stuff\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with payload and spaces at the end", {
 			"[strong key:val ]Hello[/] World",
-			"<s ids=\"[0-9 ]+\" key=\"val\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\" key=\"val\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with payload with only key", {
 			"[strong key]Hello[/] World",
-			"<s ids=\"[0-9 ]+\" key=\"\">Hello</><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\" key=\"\">Hello</><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Mismatching order between start/end shortcuts", {
 			"Start *bold then _emph, end bold*, end emph_",
-			"<s ids=\"[0-9 ]+\">Start </><s ids=\"[0-9 ]+\">bold then </><s ids=\"[0-9 ]+\">emph, end bold</><s ids=\"[0-9 ]+\">, end emph</>",
+			FString::Printf( TEXT( "<s ids=\"%s\">Start </><s ids=\"%s\">bold then </><s ids=\"%s\">emph, end bold</><s ids=\"%s\">, end emph</>" ), *Default, *Strong, *Strong, *Default ),
 		} },
 		{ "Tag with no content", {
 			"[strong][/] World",
-			"<s ids=\"[0-9 ]+\"></><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\"></><s ids=\"%s\"> World</>" ), *Strong, *Default ),
 		} },
 		{ "Tag with payload and no content", {
 			"[strong key:val][/] World",
-			"<s ids=\"[0-9 ]+\" key=\"val\"></><s ids=\"[0-9 ]+\"> World</>",
+			FString::Printf( TEXT( "<s ids=\"%s\" key=\"val\"></><s ids=\"%s\"> World</>" ), *Strong, *Default ),
+		} },
+		{ "Shortcut after a long run of plain text", {
+			"The quick brown fox jumps over the *lazy* dog again and again",
+			FString::Printf( TEXT( "<s ids=\"%s\">The quick brown fox jumps over the </><s ids=\"%s\">lazy</><s ids=\"%s\"> dog again and again</>" ), *Default, *Strong, *Default ),
+		} },
+		{ "Escapes after a long run of plain text", {
+			"A long run of plain text \\*not bold\\* then more plain text",
+			FString::Printf( TEXT( "<s ids=\"%s\">A long run of plain text \\*not bold\\* then more plain text</>" ), *Default ),
 		} },
 	};
 }
@@ -119,6 +142,7 @@ bool FBYGRichTextParseTestBase::RunTest( const FString& Parameters )
 		Style->SetID( "strong" );
 		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
 		Style->SetShortcut( "*" );
+		Style->Properties.Add( NewObject<UBYGRichTextColorProperty>() );
 		DefaultStylesheet->AddStyle( Style );
 	}
 	{
@@ -137,7 +161,7 @@ bool FBYGRichTextParseTestBase::RunTest( const FString& Parameters )
 	FString Out;
 	Parser.Get().Process( Results, TestDatum.Input, Out );
 
-	FRegexPattern Pattern( TestDatum.ExpectedPattern );
+	FRegexPattern Pattern( FString::Printf( TEXT( "^%s$" ), *TestDatum.ExpectedPattern ) );
 	FRegexMatcher Matcher( Pattern, Out );
 
 	TestTrue( FString::Printf( TEXT( "Input '%s', Output '%s' matches regex '%s'" ), *TestDatum.Input, *Out, *TestDatum.ExpectedPattern ), Matcher.FindNext() );
@@ -158,6 +182,69 @@ bool FBYGRichTextParseTest::RunTest( const FString& Parameters )
 }
 
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextParseSlotsTest, "BYG.RichText.Parse.Slots", TestFlags )
+bool FBYGRichTextParseSlotsTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+
+	auto Parse = [ Stylesheet ]( const FString& Input, TArray<FName>& OutSlotNames )
+	{
+		TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+		const TArray<FBYGTextBlockInfo> Blocks = Parser->SplitIntoBlocks( Input );
+		OutSlotNames = Blocks.Num() > 0 ? Blocks[ 0 ].SlotNames : TArray<FName>();
+		return Parser->ConvertInputToInlineXML( Input );
+	};
+	TArray<FName> SlotNames;
+
+	UBYGRichTextRuntimeSettings* Settings = GetMutableDefault<UBYGRichTextRuntimeSettings>();
+	const FString OldSlotOpen = Settings->SlotOpenCharacter;
+	const FString OldSlotClose = Settings->SlotCloseCharacter;
+
+	// Off unless a project asks for them, so existing text with braces in it is left alone
+	Settings->SlotOpenCharacter = "";
+	Settings->SlotCloseCharacter = "";
+	FString Output = Parse( "Hello {Name}!", SlotNames );
+	TestTrue( "Braces are text when slots are disabled", Output.Contains( ">Hello {Name}!</>" ) );
+	TestFalse( "No slot runs when slots are disabled", Output.Contains( "slot=" ) );
+	TestEqual( "No slot names when slots are disabled", SlotNames.Num(), 0 );
+
+	Settings->SlotOpenCharacter = "{";
+	Settings->SlotCloseCharacter = "}";
+
+	Output = Parse( "Hello {Name}!", SlotNames );
+	TestTrue( "Slot is its own run showing the placeholder", Output.Contains( " slot=\"Name\">{Name}</>" ) );
+	TestTrue( "Text before the slot", Output.Contains( ">Hello </>" ) );
+	TestTrue( "Text after the slot", Output.Contains( ">!</>" ) );
+	TestEqual( "Block knows its slot", SlotNames, TArray<FName>( { "Name" } ) );
+
+	Output = Parse( "{Gold} gold and {Gold_2} more", SlotNames );
+	TestTrue( "Slot at the start", Output.Contains( " slot=\"Gold\">{Gold}</>" ) );
+	TestTrue( "Names can have numbers and underscores", Output.Contains( " slot=\"Gold_2\">{Gold_2}</>" ) );
+	TestEqual( "Block knows both slots", SlotNames.Num(), 2 );
+
+	Output = Parse( "Costs {5 gold} or {} or {Name", SlotNames );
+	TestTrue( "Stray braces stay as text", Output.Contains( ">Costs {5 gold} or {} or {Name</>" ) );
+	TestFalse( "Stray braces aren't slots", Output.Contains( "slot=" ) );
+	TestEqual( "No slot names from stray braces", SlotNames.Num(), 0 );
+
+	Output = Parse( "Type \\{Name} here", SlotNames );
+	TestTrue( "Escaped brace is shown as text", Output.Contains( ">Type {Name} here</>" ) );
+	TestFalse( "Escaped brace isn't a slot", Output.Contains( "slot=" ) );
+	TestEqual( "No slot names from escaped braces", SlotNames.Num(), 0 );
+
+	Settings->SlotOpenCharacter = OldSlotOpen;
+	Settings->SlotCloseCharacter = OldSlotClose;
+
+	return true;
+}
+
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST( FRichTextDefaultsTest, "BYG.RichText.Defaults", TestFlags )
 bool FRichTextDefaultsTest::RunTest( const FString& Parameters )
 {
@@ -194,3 +281,545 @@ bool FBYGRichTextStyleNameTest::RunTest( const FString& Parameters )
 
 	return true;
 }
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextStatsTest, "BYG.RichText.Stats", TestFlags )
+bool FBYGRichTextStatsTest::RunTest( const FString& Parameters )
+{
+	FBYGRichTextBlockStats Stats;
+	Stats.ResetBlocks( 2 );
+	Stats.AddRun( 0, EBYGRunType::Text );
+	Stats.AddRun( 0, EBYGRunType::Text );
+	Stats.AddRun( 1, EBYGRunType::Widget );
+	TestEqual( "Text runs", Stats.GetNumRuns( EBYGRunType::Text ), 2 );
+	TestEqual( "Widget runs", Stats.GetNumRuns( EBYGRunType::Widget ), 1 );
+
+	// Laying out a block again replaces its runs
+	Stats.ClearBlock( 0 );
+	Stats.AddRun( 0, EBYGRunType::Text );
+	TestEqual( "Runs of a block laid out again", Stats.GetNumRuns( EBYGRunType::Text ), 1 );
+
+	Stats.AddRebuild( 10.0, 0.5 );
+	Stats.AddRebuild( 20.0, 0.25 );
+	int32 Count = 0;
+	double Seconds = 0.0;
+	Stats.GetRebuildsSince( 15.0, Count, Seconds );
+	TestEqual( "Recent rebuilds", Count, 1 );
+	TestEqual( "Recent rebuild time", Seconds, 0.25 );
+	TestEqual( "All rebuilds", Stats.GetNumRebuilds(), 2 );
+
+	for ( int32 i = 0; i < FBYGRichTextBlockStats::MaxRecentRebuilds; ++i )
+	{
+		Stats.AddRebuild( 30.0, 0.0 );
+	}
+	Stats.GetRebuildsSince( 0.0, Count, Seconds );
+	TestEqual( "Only the latest rebuilds are kept", Count, FBYGRichTextBlockStats::MaxRecentRebuilds );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextRingBufferTest, "BYG.RichText.RingBuffer", TestFlags )
+bool FBYGRichTextRingBufferTest::RunTest( const FString& Parameters )
+{
+	TBYGRingBuffer<FString> Order;
+	for ( int32 i = 0; i < 20; ++i )
+	{
+		Order.Add( FString::FromInt( i ) );
+		// Same as a full cache, one in and the oldest out
+		if ( Order.Num() > 5 )
+		{
+			Order.PopFirst();
+		}
+	}
+	TestEqual( "Capped", Order.Num(), 5 );
+	TestEqual( "Oldest kept", Order.First(), FString( "15" ) );
+	TestEqual( "Newest", Order[ 4 ], FString( "19" ) );
+	const SIZE_T Allocated = Order.GetAllocatedSize();
+
+	// Growing while wrapped around keeps the order
+	for ( int32 i = 20; i < 40; ++i )
+	{
+		Order.Add( FString::FromInt( i ) );
+	}
+	TestEqual( "Grown", Order.Num(), 25 );
+	for ( int32 i = 0; i < Order.Num(); ++i )
+	{
+		TestEqual( "In order after growing", Order[ i ], FString::FromInt( 15 + i ) );
+	}
+	TestTrue( "Only grows when full", Order.GetAllocatedSize() > Allocated );
+
+	Order.Empty();
+	TestEqual( "Empty", Order.Num(), 0 );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextRevealTest, "BYG.RichText.Reveal", TestFlags )
+bool FBYGRichTextRevealTest::RunTest( const FString& Parameters )
+{
+	TSharedRef<FBYGRevealState> State = MakeShared<FBYGRevealState>();
+	State->ResetBlocks( 2 );
+	// Runs report where they end as they're created, in any order
+	State->ExtendBlock( 0, 5 );
+	State->ExtendBlock( 0, 3 );
+	State->ExtendBlock( 1, 10 );
+	State->ExtendBlock( 2, 50 );
+	TestEqual( "Block length is where its last run ends", State->GetBlockLength( 0 ), 5 );
+	TestEqual( "Second block starts after the first", State->GetBlockStart( 1 ), 5 );
+	TestEqual( "Blocks that don't exist are ignored", State->GetTotalCount(), 15 );
+	TestTrue( "Shows everything by default", State->IsRevealingAll() );
+
+	// A run covering characters 2-5 of the second block
+	FBYGRunRevealInfo RunInfo;
+	RunInfo.RevealState = State;
+	RunInfo.BlockIndex = 1;
+	RunInfo.LocalOffset = 2;
+	TestEqual( "Whole run is visible when revealing everything", RunInfo.GetVisibleCount( 0, 0, 4 ), 4 );
+
+	State->SetRevealedCount( 8 );
+	TestFalse( "Count set", State->IsRevealingAll() );
+	TestEqual( "Visible up to the revealed count", RunInfo.GetVisibleCount( 0, 0, 4 ), 1 );
+	TestEqual( "Later layout blocks of the run are hidden", RunInfo.GetVisibleCount( 0, 2, 4 ), 0 );
+	State->SetRevealedCount( 3 );
+	TestEqual( "Runs in later blocks are hidden", RunInfo.GetVisibleCount( 0, 0, 4 ), 0 );
+
+	State->SetRevealedFraction( 0.6f );
+	TestEqual( "Fraction is of the laid out length", State->GetRevealedCount(), 9 );
+	TestEqual( "Visible up to the fraction", RunInfo.GetVisibleCount( 0, 0, 4 ), 2 );
+	State->SetRevealedFraction( 2.0f );
+	TestEqual( "Fraction is clamped", State->GetRevealedCount(), 15 );
+
+	// Laying a block out again, e.g. for a new slot value, changes what a fraction resolves to
+	State->ClearBlock( 1 );
+	State->ExtendBlock( 1, 5 );
+	TestEqual( "Length follows the new layout", State->GetTotalCount(), 10 );
+	State->SetRevealedFraction( 0.5f );
+	TestEqual( "Fraction follows the new layout", State->GetRevealedCount(), 5 );
+
+	State->SetRevealedCount( INDEX_NONE );
+	TestTrue( "INDEX_NONE shows everything again", State->IsRevealingAll() );
+	TestEqual( "Whole run is visible again", RunInfo.GetVisibleCount( 0, 0, 4 ), 4 );
+
+	// Widgets keep their reveal state between rebuilds, only the lengths are reset
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRevealProgress( 0.5f );
+	TSharedRef<FBYGRevealState> BlockState = Block->GetRevealState();
+	Block->SetText( FText::FromString( "Hello World" ) );
+	TestTrue( "Same reveal state after setting text", Block->GetRevealState() == BlockState );
+	TestFalse( "Reveal is kept after setting text", BlockState->IsRevealingAll() );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextTooltipPoolTest, "BYG.RichText.TooltipPool", TestFlags )
+bool FBYGRichTextTooltipPoolTest::RunTest( const FString& Parameters )
+{
+	FBYGRichTextModule& RichTextModule = FModuleManager::GetModuleChecked<FBYGRichTextModule>( TEXT( "BYGRichText" ) );
+	RichTextModule.EmptyTooltipWidgetPool();
+	UBYGRichTextRuntimeSettings* Settings = GetMutableDefault<UBYGRichTextRuntimeSettings>();
+	const int32 OldMaxPooled = Settings->MaxPooledTooltipWidgets;
+	Settings->MaxPooledTooltipWidgets = 2;
+
+	UWorld* World = UWorld::CreateWorld( EWorldType::Game, false );
+	const TSubclassOf<UUserWidget> WidgetClass = UBYGRichTextTestTooltipWidget::StaticClass();
+
+	TestNull( "Needs a world", RichTextModule.AcquireTooltipWidget( nullptr, WidgetClass ) );
+
+	UUserWidget* First = RichTextModule.AcquireTooltipWidget( World, WidgetClass );
+	TestNotNull( "Creates a widget when the pool is empty", First );
+	RichTextModule.ReleaseTooltipWidget( First );
+	TestEqual( "Released widgets are kept", RichTextModule.GetNumFreeTooltipWidgets(), 1 );
+	TestTrue( "And reused", RichTextModule.AcquireTooltipWidget( World, WidgetClass ) == First );
+	TestEqual( "Reused widgets leave the pool", RichTextModule.GetNumFreeTooltipWidgets(), 0 );
+
+	TArray<UUserWidget*> Widgets = { First, RichTextModule.AcquireTooltipWidget( World, WidgetClass ), RichTextModule.AcquireTooltipWidget( World, WidgetClass ) };
+	TestTrue( "Widgets in use aren't handed out twice", Widgets[ 0 ] != Widgets[ 1 ] && Widgets[ 1 ] != Widgets[ 2 ] && Widgets[ 0 ] != Widgets[ 2 ] );
+	for ( UUserWidget* Widget : Widgets )
+	{
+		RichTextModule.ReleaseTooltipWidget( Widget );
+	}
+	TestEqual( "Pool is capped at MaxPooledTooltipWidgets", RichTextModule.GetNumFreeTooltipWidgets(), 2 );
+	TestTrue( "Most recently released is reused first", RichTextModule.AcquireTooltipWidget( World, WidgetClass ) == Widgets[ 2 ] );
+	TestTrue( "Oldest is dropped", RichTextModule.AcquireTooltipWidget( World, WidgetClass ) == Widgets[ 1 ] );
+	TestTrue( "Dropped widgets aren't reused", RichTextModule.AcquireTooltipWidget( World, WidgetClass ) != Widgets[ 0 ] );
+
+	Settings->MaxPooledTooltipWidgets = 0;
+	RichTextModule.ReleaseTooltipWidget( Widgets[ 1 ] );
+	TestEqual( "Nothing is kept with pooling off", RichTextModule.GetNumFreeTooltipWidgets(), 0 );
+
+	Settings->MaxPooledTooltipWidgets = 2;
+	RichTextModule.ReleaseTooltipWidget( Widgets[ 1 ] );
+	RichTextModule.ReleaseTooltipWidget( Widgets[ 2 ] );
+	World->DestroyWorld( false );
+	TestEqual( "Cleaning up a world empties its widgets", RichTextModule.GetNumFreeTooltipWidgets(), 0 );
+
+	Settings->MaxPooledTooltipWidgets = OldMaxPooled;
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextResourceSizeTest, "BYG.RichText.ResourceSize", TestFlags )
+bool FBYGRichTextResourceSizeTest::RunTest( const FString& Parameters )
+{
+	const FBYGTextBlockInfo Short( "Hello", {}, {} );
+	const FBYGTextBlockInfo Long( FString::ChrN( 1000, 'a' ), { "body" }, { { "id", "tooltip" } } );
+	TestTrue( "Longer blocks report more memory", Long.GetAllocatedSize() > Short.GetAllocatedSize() );
+	TestTrue( "Counts the raw text", Long.GetAllocatedSize() >= 1000 * sizeof( TCHAR ) );
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	const SIZE_T Empty = Block->GetResourceSizeBytes( EResourceSizeMode::Exclusive );
+	Block->SetText( FText::FromString( FString::ChrN( 1000, 'a' ) ) );
+	TestTrue( "Widget counts its text", Block->GetResourceSizeBytes( EResourceSizeMode::Exclusive ) >= Empty + 1000 * sizeof( TCHAR ) );
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+	Style->SetID( "body" );
+	Stylesheet->AddStyle( Style );
+	TestTrue( "Stylesheet counts its styles", Stylesheet->GetResourceSizeBytes( EResourceSizeMode::EstimatedTotal ) > 0 );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextSetTextsTest, "BYG.RichText.SetTexts", TestFlags )
+bool FBYGRichTextSetTextsTest::RunTest( const FString& Parameters )
+{
+	// Only built widgets parse their text
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+	Style->SetID( "default" );
+	Stylesheet->AddStyle( Style );
+	Stylesheet->SetDefaultStyleName( "default" );
+
+	// Rows of a leaderboard, most showing the same rank
+	TArray<UBYGRichTextBlock*> Blocks;
+	TArray<TSharedRef<SWidget>> Widgets;
+	TArray<TPair<UBYGRichTextBlock*, FText>> WidgetTexts;
+	for ( int32 i = 0; i < 20; ++i )
+	{
+		UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+		Block->SetRichTextStylesheet( Stylesheet );
+		Block->SetText( FText::FromString( "Unranked" ) );
+		Widgets.Add( Block->TakeWidget() );
+		Blocks.Add( Block );
+		WidgetTexts.Emplace( Block, FText::FromString( i < 2 ? FString::Printf( TEXT( "Rank %d" ), i + 1 ) : TEXT( "Top 10%" ) ) );
+	}
+
+	FBYGRichTextParseCache::Get().Empty();
+	FBYGRichTextParseCache::Get().ResetHitCounts();
+	UBYGRichTextBlock::SetTexts( WidgetTexts );
+
+	int64 Hits = 0;
+	int64 Misses = 0;
+	FBYGRichTextParseCache::Get().GetHitCounts( Hits, Misses );
+	TestEqual( "Each distinct text is parsed once", FBYGRichTextParseCache::Get().NumShared(), 3 );
+	TestEqual( "Only distinct texts miss the cache", Misses, ( int64 )3 );
+	TestEqual( "Widgets use the parsed output", Hits, ( int64 )20 );
+	TestEqual( "First row", Blocks[ 0 ]->GetText().ToString(), FString( "Rank 1" ) );
+	TestEqual( "Last row", Blocks.Last()->GetText().ToString(), FString( "Top 10%" ) );
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextTextBindingTest, "BYG.RichText.TextBinding", TestFlags )
+bool FBYGRichTextTextBindingTest::RunTest( const FString& Parameters )
+{
+	// Only built widgets poll their binding
+	if ( !FSlateApplication::IsInitialized() )
+	{
+		AddInfo( "Slate isn't initialized, skipping" );
+		return true;
+	}
+
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+	Style->SetID( "default" );
+	Stylesheet->AddStyle( Style );
+	Stylesheet->SetDefaultStyleName( "default" );
+
+	UBYGRichTextTestTextSource* Source = NewObject<UBYGRichTextTestTextSource>();
+	Source->Text = FText::FromString( "Bound" );
+
+	UBYGRichTextBlock* Block = NewObject<UBYGRichTextBlock>();
+	Block->SetRichTextStylesheet( Stylesheet );
+	Block->SetText( FText::FromString( "Designer text" ) );
+	// Bound the same way the widget blueprint compiler does
+	FDelegateProperty* DelegateProperty = FindFProperty<FDelegateProperty>( UBYGRichTextBlock::StaticClass(), "TextDelegate" );
+	if ( !TestNotNull( "Has a Text binding", DelegateProperty ) )
+		return false;
+	DelegateProperty->GetPropertyValuePtr_InContainer( Block )->BindUFunction( Source, GET_FUNCTION_NAME_CHECKED( UBYGRichTextTestTextSource, GetText ) );
+
+	TSharedRef<SWidget> Widget = Block->TakeWidget();
+	TestEqual( "Built with the bound text", Block->GetText().ToString(), FString( "Bound" ) );
+	TestEqual( "Binding read once to build", Source->NumReads, 1 );
+
+	const int32 NumRebuilds = Block->GetStats()->GetNumRebuilds();
+	double Time = FPlatformTime::Seconds() + 1000.0;
+	Block->PollTextBinding( Time );
+	TestEqual( "Binding is read when due", Source->NumReads, 2 );
+	TestEqual( "Unchanged text doesn't rebuild", Block->GetStats()->GetNumRebuilds(), NumRebuilds );
+
+	Source->Text = FText::FromString( "Changed" );
+	Block->PollTextBinding( Time );
+	TestEqual( "Binding isn't read again before the interval", Source->NumReads, 2 );
+	Time += 1000.0;
+	Block->PollTextBinding( Time );
+	TestEqual( "Changed text", Block->GetText().ToString(), FString( "Changed" ) );
+	TestEqual( "Changed text rebuilds once", Block->GetStats()->GetNumRebuilds(), NumRebuilds + 1 );
+
+	Time += 1000.0;
+	Block->PollTextBinding( Time );
+	TestEqual( "And not again", Block->GetStats()->GetNumRebuilds(), NumRebuilds + 1 );
+
+	return true;
+}
+
+
+static const int BenchmarkTestFlags = (
+	EAutomationTestFlags::EditorContext
+	| EAutomationTestFlags::CommandletContext
+	| EAutomationTestFlags::ClientContext
+	| EAutomationTestFlags::PerfFilter );
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextDelimiterBenchmark, "BYG.RichText.Benchmark.Delimiters", BenchmarkTestFlags )
+bool FBYGRichTextDelimiterBenchmark::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "strong" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Style->SetShortcut( "*" );
+		Stylesheet->AddStyle( Style );
+	}
+
+	// Numbered so no two paragraphs are the same, the parser only processes each distinct one once
+	FString DefaultMarkup;
+	for ( int32 i = 0; i < 200; ++i )
+	{
+		DefaultMarkup += FString::Printf( TEXT( "Paragraph %d has long stretches of plain prose, then a [strong]tag[/], a *shortcut* and a {Slot} to fill in later.\r\n\r\n" ), i );
+	}
+	// Same markup with delimiters that can't use the default tokenizer
+	const FString CustomMarkup = DefaultMarkup.Replace( TEXT( "[" ), TEXT( "(" ) ).Replace( TEXT( "]" ), TEXT( ")" ) );
+
+	UBYGRichTextRuntimeSettings* Settings = GetMutableDefault<UBYGRichTextRuntimeSettings>();
+	const FString OldTagOpen = Settings->TagOpenCharacter;
+	const FString OldTagClose = Settings->TagCloseCharacter;
+
+	const int32 NumIterations = 20;
+	auto Time = [ & ]( const FString& Markup, TSharedPtr<const FBYGParsedText>& OutParsed )
+	{
+		const double Start = FPlatformTime::Seconds();
+		for ( int32 i = 0; i < NumIterations; ++i )
+		{
+			OutParsed = FBYGRichTextMarkupParser::Create( Stylesheet, "s" )->ParseFully( Markup );
+		}
+		return ( FPlatformTime::Seconds() - Start ) * 1000.0 / NumIterations;
+	};
+
+	Settings->TagOpenCharacter = "[";
+	Settings->TagCloseCharacter = "]";
+	TSharedPtr<const FBYGParsedText> DefaultParsed;
+	const double DefaultMs = Time( DefaultMarkup, DefaultParsed );
+
+	Settings->TagOpenCharacter = "(";
+	Settings->TagCloseCharacter = ")";
+	TSharedPtr<const FBYGParsedText> CustomParsed;
+	const double CustomMs = Time( CustomMarkup, CustomParsed );
+
+	Settings->TagOpenCharacter = OldTagOpen;
+	Settings->TagCloseCharacter = OldTagClose;
+
+	if ( !TestEqual( "Same number of blocks", CustomParsed->BlockRuns.Num(), DefaultParsed->BlockRuns.Num() ) )
+		return false;
+	for ( int32 i = 0; i < DefaultParsed->BlockRuns.Num(); ++i )
+	{
+		TestEqual( "Both tokenizers give the same output", CustomParsed->BlockRuns[ i ].Output, DefaultParsed->BlockRuns[ i ].Output );
+	}
+
+	AddInfo( FString::Printf( TEXT( "%d characters: default delimiters %.3fms, configured delimiters %.3fms" ), DefaultMarkup.Len(), DefaultMs, CustomMs ) );
+
+	return true;
+}
+
+
+// Counts allocations made on the calling thread while it's in front of GMalloc
+// Never destroyed, other threads may still be inside it just after it's taken out again
+class FBYGAllocationCounter : public FMalloc
+{
+public:
+	static FBYGAllocationCounter& Get()
+	{
+		static FBYGAllocationCounter* Counter = new FBYGAllocationCounter();
+		return *Counter;
+	}
+
+	// GMalloc is put back even if Work fails
+	int32 Count( TFunctionRef<void()> Work )
+	{
+		check( IsInGameThread() );
+		NumAllocations = 0;
+		ThreadId = FPlatformTLS::GetCurrentThreadId();
+		Inner = GMalloc;
+		GMalloc = this;
+		ON_SCOPE_EXIT
+		{
+			GMalloc = Inner;
+		};
+		Work();
+		return NumAllocations;
+	}
+
+	virtual void* Malloc( SIZE_T Count, uint32 Alignment ) override
+	{
+		Record();
+		return Inner->Malloc( Count, Alignment );
+	}
+	virtual void* Realloc( void* Original, SIZE_T Count, uint32 Alignment ) override
+	{
+		if ( Count > 0 )
+		{
+			Record();
+		}
+		return Inner->Realloc( Original, Count, Alignment );
+	}
+	virtual void Free( void* Original ) override { Inner->Free( Original ); }
+	virtual SIZE_T QuantizeSize( SIZE_T Count, uint32 Alignment ) override { return Inner->QuantizeSize( Count, Alignment ); }
+	virtual bool GetAllocationSize( void* Original, SIZE_T& SizeOut ) override { return Inner->GetAllocationSize( Original, SizeOut ); }
+	virtual void Trim( bool bTrimThreadCaches ) override { Inner->Trim( bTrimThreadCaches ); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { Inner->UpdateStats(); }
+	virtual void GetAllocatorStats( FGenericMemoryStats& OutStats ) override { Inner->GetAllocatorStats( OutStats ); }
+	virtual void DumpAllocatorStats( FOutputDevice& Ar ) override { Inner->DumpAllocatorStats( Ar ); }
+	virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT( "BYGAllocationCounter" ); }
+
+protected:
+	void Record()
+	{
+		if ( FPlatformTLS::GetCurrentThreadId() == ThreadId )
+		{
+			++NumAllocations;
+		}
+	}
+
+	FMalloc* Inner = nullptr;
+	uint32 ThreadId = 0;
+	int32 NumAllocations = 0;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBYGRichTextParseAllocationsTest, "BYG.RichText.Parse.Allocations", TestFlags )
+bool FBYGRichTextParseAllocationsTest::RunTest( const FString& Parameters )
+{
+	UBYGRichTextStylesheet* Stylesheet = NewObject<UBYGRichTextStylesheet>();
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "default" );
+		Stylesheet->AddStyle( Style );
+		Stylesheet->SetDefaultStyleName( "default" );
+	}
+	{
+		UBYGRichTextStyle* Style = NewObject<UBYGRichTextStyle>();
+		Style->SetID( "strong" );
+		Style->SetDisplayType( EBYGStyleDisplayType::Inline );
+		Style->SetShortcut( "*" );
+		Stylesheet->AddStyle( Style );
+	}
+
+	// Slots are opt-in
+	UBYGRichTextRuntimeSettings* Settings = GetMutableDefault<UBYGRichTextRuntimeSettings>();
+	const FString OldSlotOpen = Settings->SlotOpenCharacter;
+	const FString OldSlotClose = Settings->SlotCloseCharacter;
+	Settings->SlotOpenCharacter = "{";
+	Settings->SlotCloseCharacter = "}";
+	ON_SCOPE_EXIT
+	{
+		Settings->SlotOpenCharacter = OldSlotOpen;
+		Settings->SlotCloseCharacter = OldSlotClose;
+	};
+
+	auto MakeMarkup = []( int32 NumLines )
+	{
+		FString Markup;
+		for ( int32 i = 0; i < NumLines; ++i )
+		{
+			Markup += "Plain prose with a *shortcut*, a [strong]tag[/], [ strong ]spaces[ / ], a [strong id:glossary page:2]payload[/] and a {Name} slot.\n";
+		}
+		return Markup;
+	};
+	const int32 NumShortLines = 10;
+	const int32 NumLongLines = 200;
+	const FString Short = MakeMarkup( NumShortLines );
+	const FString Long = MakeMarkup( NumLongLines );
+
+	TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, "s" );
+	// Warm up with the longest input, so the reused buffers are already big enough
+	const FString Expected = Parser->ConvertInputToInlineXML( Long );
+	TestTrue( "Slots are emitted with their name", Expected.Contains( "slot=\"Name\">{Name}</>" ) );
+	TestTrue( "Payloads are emitted", Expected.Contains( "id=\"glossary\" page=\"2\">payload</>" ) );
+
+	// The inline pass on its own
+	const int32 ShortAllocations = FBYGAllocationCounter::Get().Count( [ & ]() { Parser->ConvertInputToInlineXML( Short ); } );
+	FString Output;
+	const int32 LongAllocations = FBYGAllocationCounter::Get().Count( [ & ]() { Output = Parser->ConvertInputToInlineXML( Long ); } );
+
+	TestEqual( "Warm output is the same", Output, Expected );
+	AddInfo( FString::Printf( TEXT( "Inline pass, %d lines: %d allocations, %d lines: %d allocations" ), NumShortLines, ShortAllocations, NumLongLines, LongAllocations ) );
+	// The style stack, the returned string and so on, but nothing per run
+	const int32 MaxAllocations = 32;
+	TestTrue( FString::Printf( TEXT( "Warm parse of %d characters makes at most %d allocations (made %d)" ), Long.Len(), MaxAllocations, LongAllocations ), LongAllocations <= MaxAllocations );
+	TestTrue( "Allocations don't grow with the input", LongAllocations <= ShortAllocations );
+
+	// The whole parse. FDefaultRichTextMarkupParser and the output have to allocate per run, so that's counted
+	// on its own and taken off, leaving what's ours: splitting into blocks, the inline pass and the bookkeeping
+	auto CountOurs = [ & ]( const FString& Markup )
+	{
+		TArray<FString> XMLBlocks;
+		for ( const FBYGTextBlockInfo& Block : Parser->SplitIntoBlocks( Markup ) )
+		{
+			XMLBlocks.Add( Parser->ConvertInputToInlineXML( Block.RawText ) );
+		}
+		TSharedRef<FDefaultRichTextMarkupParser> DefaultParser = FDefaultRichTextMarkupParser::Create();
+		const int32 DefaultAllocations = FBYGAllocationCounter::Get().Count( [ & ]()
+		{
+			for ( const FString& XML : XMLBlocks )
+			{
+				TArray<FTextLineParseResults> Results;
+				FString PlainText;
+				DefaultParser->Process( Results, XML, PlainText );
+			}
+		} );
+
+		TSharedPtr<FBYGParsedText> Parsed;
+		const int32 FullAllocations = FBYGAllocationCounter::Get().Count( [ & ]() { Parsed = Parser->ParseFully( Markup ); } );
+		return FullAllocations - DefaultAllocations;
+	};
+	CountOurs( Long );
+	const int32 ShortOurs = CountOurs( Short );
+	const int32 LongOurs = CountOurs( Long );
+	AddInfo( FString::Printf( TEXT( "Full parse without the default parser, %d lines: %d allocations, %d lines: %d allocations" ), NumShortLines, ShortOurs, NumLongLines, LongOurs ) );
+	// Growing the block's raw text is allowed for, one allocation per extra line is not
+	const int32 NumExtraLines = NumLongLines - NumShortLines;
+	TestTrue( FString::Printf( TEXT( "Full parse allocations don't grow per line (%d for %d more lines)" ), LongOurs - ShortOurs, NumExtraLines ), LongOurs - ShortOurs < NumExtraLines / 4 );
+
+	return true;
+}
@@ -0,0 +1,25 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "BYGRichTextTestTextSource.generated.h"
+
+// Stands in for a widget blueprint's Text binding, which needs a UFUNCTION to bind to
+UCLASS( Transient )
+class UBYGRichTextTestTextSource : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION()
+	FText GetText() const
+	{
+		++NumReads;
+		return Text;
+	}
+
+	FText Text;
+	mutable int32 NumReads = 0;
+};
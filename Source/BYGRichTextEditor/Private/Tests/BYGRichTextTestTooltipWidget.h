@@ -0,0 +1,14 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "BYGRichTextTestTooltipWidget.generated.h"
+
+// UUserWidget is abstract, the tooltip pool tests need one they can create
+UCLASS( NotBlueprintable, HideDropdown )
+class UBYGRichTextTestTooltipWidget : public UUserWidget
+{
+	GENERATED_BODY()
+};
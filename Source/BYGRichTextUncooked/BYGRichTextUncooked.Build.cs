@@ -0,0 +1,24 @@
+using UnrealBuildTool;
+
+// Tools that run on uncooked content, outside the editor UI too, e.g. commandlets
+public class BYGRichTextUncooked : ModuleRules
+{
+	public BYGRichTextUncooked(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[] {
+				"Core",
+				"CoreUObject",
+				"Engine",
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[] {
+				"BYGRichText",
+			}
+		);
+	}
+}
@@ -0,0 +1,6 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Loaded for commandlets as well as the editor, unlike BYGRichTextEditor which is EditorNoCommandlet
+IMPLEMENT_MODULE( FDefaultModuleImpl, BYGRichTextUncooked );
@@ -0,0 +1,118 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#include "Commandlets/BYGRichTextCompileMarkupCommandlet.h"
+#include "Core/BYGRichTextMarkupProcessing.h"
+#include "Core/BYGRichTextParseCache.h"
+#include "Settings/BYGRichTextStylesheet.h"
+
+#include "Internationalization/StringTable.h"
+#include "Internationalization/StringTableCore.h"
+#include "Misc/Paths.h"
+
+UBYGRichTextCompileMarkupCommandlet::UBYGRichTextCompileMarkupCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBYGRichTextCompileMarkupCommandlet::Main( const FString& Params )
+{
+	FString StylesheetPath;
+	FString StringTablesParam;
+	FString OutputPath;
+	FString XMLElementName = "s";
+	FParse::Value( *Params, TEXT( "Stylesheet=" ), StylesheetPath );
+	FParse::Value( *Params, TEXT( "StringTables=" ), StringTablesParam );
+	FParse::Value( *Params, TEXT( "Output=" ), OutputPath );
+	FParse::Value( *Params, TEXT( "ElementName=" ), XMLElementName );
+
+	if ( StylesheetPath.IsEmpty() || StringTablesParam.IsEmpty() || OutputPath.IsEmpty() )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Usage: -run=BYGRichTextCompileMarkup -Stylesheet=<path> -StringTables=<path>+<path> -Output=<file>" ) );
+		return 1;
+	}
+
+	const UBYGRichTextStylesheet* Stylesheet = LoadStylesheet( StylesheetPath );
+	if ( !Stylesheet )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Could not load stylesheet '%s'" ), *StylesheetPath );
+		return 1;
+	}
+
+	TArray<FString> StringTablePaths;
+	StringTablesParam.ParseIntoArray( StringTablePaths, TEXT( "+" ) );
+
+	TArray<FString> Strings;
+	for ( const FString& StringTablePath : StringTablePaths )
+	{
+		GatherStrings( StringTablePath, Strings );
+	}
+
+	TSharedRef<FBYGRichTextMarkupParser> Parser = FBYGRichTextMarkupParser::Create( Stylesheet, XMLElementName );
+	const uint32 ParseHash = Parser->GetParseHash();
+
+	// Strings that only differ in case parse differently, so don't let TSet<FString> fold them together
+	FBYGCompiledMarkupMap Compiled;
+	Compiled.Reserve( Strings.Num() );
+	for ( const FString& String : Strings )
+	{
+		if ( !Compiled.Contains( String ) )
+		{
+			Compiled.Add( String, Parser->ParseFully( String ) );
+		}
+	}
+
+	if ( FPaths::IsRelative( OutputPath ) )
+	{
+		OutputPath = FPaths::Combine( FPaths::ProjectDir(), OutputPath );
+	}
+
+	if ( !FBYGRichTextParseCache::SaveCompiledFile( OutputPath, StylesheetPath, ParseHash, Compiled ) )
+	{
+		return 1;
+	}
+
+	UE_LOG( LogTemp, Display, TEXT( "Compiled %d strings with stylesheet '%s' (hash %08x) to '%s'" ), Compiled.Num(), *StylesheetPath, ParseHash, *OutputPath );
+	return 0;
+}
+
+const UBYGRichTextStylesheet* UBYGRichTextCompileMarkupCommandlet::LoadStylesheet( const FString& Path ) const
+{
+	// Stylesheets are usually Blueprint classes, but allow plain assets too
+	UBYGRichTextStylesheet* Stylesheet = nullptr;
+	if ( UClass* StylesheetClass = LoadClass<UBYGRichTextStylesheet>( nullptr, *Path ) )
+	{
+		Stylesheet = StylesheetClass->GetDefaultObject<UBYGRichTextStylesheet>();
+	}
+	else
+	{
+		Stylesheet = LoadObject<UBYGRichTextStylesheet>( nullptr, *Path );
+	}
+
+	if ( Stylesheet )
+	{
+		Stylesheet->RebuildLookup();
+	}
+	return Stylesheet;
+}
+
+void UBYGRichTextCompileMarkupCommandlet::GatherStrings( const FString& StringTablePath, TArray<FString>& OutStrings ) const
+{
+	UStringTable* StringTable = LoadObject<UStringTable>( nullptr, *StringTablePath );
+	if ( !StringTable )
+	{
+		UE_LOG( LogTemp, Warning, TEXT( "Could not load string table '%s'" ), *StringTablePath );
+		return;
+	}
+
+	const FName TableID = StringTable->GetStringTableId();
+	StringTable->GetStringTable()->EnumerateSourceStrings( [&]( const FString& Key, const FString& SourceString )
+	{
+		OutStrings.Add( SourceString );
+		// Also include whatever the current culture displays, so localized builds hit the cache
+		OutStrings.Add( FText::FromStringTable( TableID, Key ).ToString() );
+		return true;
+	} );
+}
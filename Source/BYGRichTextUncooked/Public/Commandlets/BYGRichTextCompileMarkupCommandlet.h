@@ -0,0 +1,33 @@
+// Copyright Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "BYGRichTextCompileMarkupCommandlet.generated.h"
+
+class UBYGRichTextStylesheet;
+
+/**
+ * Parses every string in the given string tables ahead of time and writes the results to a file
+ * that can be listed in the runtime settings' CompiledMarkupFiles.
+ *
+ * Run before cooking, e.g.
+ * UE4Editor-Cmd.exe Game.uproject -run=BYGRichTextCompileMarkup -Stylesheet=/Game/UI/MyStylesheet.MyStylesheet_C
+ *     -StringTables=/Game/Text/Dialogue.Dialogue+/Game/Text/UI.UI -Output=Content/RichText/Compiled.bygm
+ */
+UCLASS()
+class BYGRICHTEXTUNCOOKED_API UBYGRichTextCompileMarkupCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBYGRichTextCompileMarkupCommandlet();
+
+	virtual int32 Main( const FString& Params ) override;
+
+protected:
+	const UBYGRichTextStylesheet* LoadStylesheet( const FString& Path ) const;
+	void GatherStrings( const FString& StringTablePath, TArray<FString>& OutStrings ) const;
+};